@@ -2,11 +2,22 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#define MAX_MICE        6
 #define NUM_MICE        6
 #define LOGIC_MODE      0
 #define INPUT_MODE      2
 #define OUTPUT_MODE     1
 #define AMPLIFY         1.0f
 #define QUAD_SCALE      2
+#define ACCEL_MODE      0
+#define ACCEL_WINDOW_MS 20
+#define ACCEL_THRESHOLD 4
+#define ACCEL_RATE      50
+#define ACCEL_MAX       4.0f
+#define QUAD_SAMPLER    0
+#define QUAD_FILTER     1
+#define QUAD_RATE_MAX_KHZ 20
+#define SPI_CPI         1600
+#define UART_BAUD       115200
 
 #endif
@@ -0,0 +1,37 @@
+/**
+ * Pointer acceleration: gain as a function of recent pointer speed.
+ * The curve is evaluated once into a lookup table when settings change;
+ * per-report work is a table lookup and two multiplies.
+ */
+#ifndef ACCEL_H
+#define ACCEL_H
+
+#include <stdint.h>
+#include "settings.h"
+
+#define ACCEL_LUT_SIZE   256   /* speed index: counts per window, clamped */
+#define ACCEL_HIST_LEN   32    /* recent moving reports kept for the speed window (>= 64 ms at 2 ms/report) */
+#define ACCEL_IN_MAX     32767 /* per-axis delta accel_apply() takes before clamping (d * gain fits in int32);
+                                  as much as the report coalescer holds */
+
+typedef struct {
+  uint16_t gain_q8[ACCEL_LUT_SIZE];  /* Q8 gain per speed (256 = 1.0) */
+  uint32_t version;                  /* settings_version() the table was built from */
+  uint8_t window_ms;
+  uint32_t hist_ms[ACCEL_HIST_LEN];  /* report timestamps */
+  uint16_t hist_mag[ACCEL_HIST_LEN]; /* report magnitudes (pre-accel counts) */
+  uint8_t hist_pos;
+  int32_t res[2];                    /* Q8 remainder per axis */
+} accel_t;
+
+/* Direct curve evaluation (float); used to build the table. */
+float accel_eval(const settings_t *s, int speed);
+
+/* Rebuild the table from settings and clear history. */
+void accel_build(accel_t *a, const settings_t *s, uint32_t version);
+
+/* Record this report's motion and scale (dx, dy), clamped to ACCEL_IN_MAX, by the gain
+ * for the current speed. */
+void accel_apply(accel_t *a, int32_t *dx, int32_t *dy, uint32_t now_ms);
+
+#endif
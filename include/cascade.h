@@ -0,0 +1,80 @@
+/**
+ * Cascade link: Picos chained over UART. Each node sends its mice (one record per
+ * slot, or one record for its combined output) and everything it received from
+ * further down to the next node up, so the head of the chain sees every downstream
+ * mouse as one of its own slots. Frames say how long their oldest input has been in
+ * the chain and over how many links, so the head can stamp it with the time it was
+ * really moved. No Pico SDK dependencies (scripts/cascade_sim.py runs the same
+ * format on a PC).
+ *
+ * Frame: 0xAC, count, hops, age_us (2), count records, xor of every byte after 0xAC.
+ * Record: slot (bits 0-5; bit 7 = wheel/pan record), buttons, a (2), b (2): dx, dy,
+ * or wheel, pan in 1/120 detents. Little-endian.
+ */
+#ifndef CASCADE_H
+#define CASCADE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CASCADE_SYNC          0xAC
+#define CASCADE_HEADER_LEN    5
+#define CASCADE_RECORD_LEN    6
+#define CASCADE_LEN(count)    (CASCADE_HEADER_LEN + (count) * CASCADE_RECORD_LEN + 1)
+#define CASCADE_SLOTS         16   /* upstream slots a chain can address */
+#define CASCADE_RECORDS_MAX   (2 * CASCADE_SLOTS)   /* motion and wheel/pan per slot */
+#define CASCADE_LEN_MAX       CASCADE_LEN(CASCADE_RECORDS_MAX)
+#define CASCADE_SLOT_MASK     0x3F
+#define CASCADE_SCROLL        0x80
+#define CASCADE_AGE_MAX       0xFFFF
+
+typedef struct {
+  uint8_t slot;
+  bool scroll;       /* a, b are wheel, pan (else dx, dy) */
+  uint8_t buttons;
+  int16_t a, b;
+} cascade_record_t;
+
+/* Input waiting to go upstream, per upstream slot */
+typedef struct {
+  int32_t dx, dy, wheel, pan;
+  uint8_t buttons;        /* current level */
+  uint8_t sent_buttons;   /* level in the last frame */
+} cascade_acc_t;
+
+typedef struct {
+  cascade_acc_t acc[CASCADE_SLOTS];
+  uint32_t oldest_us;     /* origin (local clock) of the oldest input waiting */
+  bool waiting;           /* oldest_us is valid */
+  uint8_t hops;           /* most links crossed by any input waiting */
+} cascade_tx_t;
+
+void cascade_tx_reset(cascade_tx_t *t);
+
+/* Add input for upstream slot (< CASCADE_SLOTS): motion, and the buttons' level.
+ * origin_us is when it was moved (local clock), hops the links it has crossed. */
+void cascade_tx_add(cascade_tx_t *t, int slot, uint8_t buttons, int32_t dx, int32_t dy,
+                    int32_t wheel, int32_t pan, uint32_t origin_us, uint8_t hops);
+
+/* Build the next frame into out (CASCADE_LEN_MAX bytes) from everything waiting, and
+ * remove what it carries (past int16 the rest waits for the next frame). Returns its
+ * length, or 0 if nothing is waiting. */
+int cascade_tx_frame(cascade_tx_t *t, uint8_t *out, uint32_t now_us);
+
+/* Received frame of len bytes: sync, a count of at most CASCADE_RECORDS_MAX, len =
+ * CASCADE_LEN(count) and the checksum all match. */
+bool cascade_check(const uint8_t *f, int len);
+
+static inline int cascade_count(const uint8_t *f) { return f[1]; }
+static inline uint8_t cascade_hops(const uint8_t *f) { return f[2]; }
+static inline uint32_t cascade_age_us(const uint8_t *f) { return (uint32_t)f[3] | ((uint32_t)f[4] << 8); }
+
+/* Record k of a checked frame. */
+void cascade_record(const uint8_t *f, int k, cascade_record_t *r);
+
+/* Time len bytes take on a UART at baud (8N1). */
+static inline uint32_t cascade_wire_us(int len, uint32_t baud) {
+  return baud ? (uint32_t)len * 10000000u / baud : 0;
+}
+
+#endif
@@ -0,0 +1,44 @@
+/**
+ * Report coalescing: per-HID-instance accumulator that sums motion until the
+ * endpoint is ready, then emits one report. Motion beyond the report range
+ * (int8 X/Y, int16 wheel/pan) stays queued for the next report. Button changes go through a small
+ * FIFO so every press and release reaches the host in order, one state per
+ * report, each held for at least the configured minimum time.
+ */
+#ifndef COALESCE_H
+#define COALESCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define COALESCE_MAX           32767   /* pending motion is saturated here per axis */
+#define COALESCE_BUTTON_QUEUE  8       /* button states waiting to be reported */
+
+typedef struct {
+  int32_t dx, dy, wheel, pan;              /* pending motion */
+  uint8_t queue[COALESCE_BUTTON_QUEUE];    /* button states not yet reported, oldest first */
+  uint8_t queued;
+  uint8_t sent;                            /* buttons in the last report */
+  uint32_t sent_ms;                        /* when the last button change was reported */
+} coalesce_t;
+
+typedef struct {
+  uint8_t buttons;
+  int8_t dx, dy;
+  int16_t wheel, pan;
+} coalesce_report_t;
+
+void coalesce_reset(coalesce_t *c);
+
+void coalesce_add(coalesce_t *c, int32_t dx, int32_t dy, int32_t wheel, int32_t pan);
+
+/* Queue a new button level (ignored if it equals the newest queued or reported state). */
+void coalesce_buttons(coalesce_t *c, uint8_t level);
+
+/* True if a report would carry motion or a button change that may go out now. */
+bool coalesce_pending(const coalesce_t *c, uint32_t now_ms, uint8_t min_hold_ms);
+
+/* Build the next report and remove what it carries. Returns false if nothing is pending. */
+bool coalesce_take(coalesce_t *c, coalesce_report_t *r, uint32_t now_ms, uint8_t min_hold_ms);
+
+#endif
@@ -0,0 +1,32 @@
+/**
+ * Division by a run-time constant without a divide: q = (n * mul) >> shift, with
+ * mul/shift worked out once per divisor. Exact for |n| <= FASTDIV_N_MAX, where the
+ * product still fits in 32 bits (one MUL on the M0+); larger n fall back to '/'.
+ * No Pico SDK dependencies.
+ */
+#ifndef FASTDIV_H
+#define FASTDIV_H
+
+#include <stdint.h>
+
+#define FASTDIV_N_MAX  32768u   /* covers every int16 dividend */
+
+typedef struct {
+  uint32_t mul;
+  uint8_t shift;
+  uint16_t div;
+} fastdiv_t;
+
+/* Set up division by d (1..65535). */
+void fastdiv_init(fastdiv_t *f, uint16_t d);
+
+/* n / d, truncated toward zero like C division. */
+static inline int32_t fastdiv_s32(const fastdiv_t *f, int32_t n) {
+  uint32_t u = n < 0 ? 0u - (uint32_t)n : (uint32_t)n;
+  if (u > FASTDIV_N_MAX)
+    return n / (int32_t)f->div;
+  uint32_t q = (u * f->mul) >> f->shift;
+  return n < 0 ? -(int32_t)q : (int32_t)q;
+}
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * Report frame clock locked to USB start-of-frame. SOFs are seen late and unevenly
+ * (tud_sof_cb runs from tud_task, one main loop pass after the interrupt), so the
+ * clock keeps the earliest sighting per window as the SOF phase and tracks the SOF
+ * period in local microseconds (host and Pico crystals differ by up to ~100 ppm).
+ * Report frames then run lead_us before every ticks-th SOF, with no drift against the
+ * host's schedule. Which of the ticks SOFs is taken from the frames the host is seen
+ * polling the IN endpoints in, so the reports are queued just before a poll.
+ * Without SOFs (unplugged, suspended, a cascading Pico) it free-runs on the
+ * microsecond timer. No Pico SDK dependencies.
+ */
+#ifndef FRAMECLOCK_H
+#define FRAMECLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FRAMECLOCK_SOF_US    1000   /* full-speed frame */
+#define FRAMECLOCK_WINDOW    32     /* SOFs per phase and period update */
+#define FRAMECLOCK_LOST_US   4000   /* no SOF for this long: unlocked */
+#define FRAMECLOCK_PPM_MAX   500    /* SOF period estimate stays within this of nominal */
+#define FRAMECLOCK_POLLS     4      /* polls in a row in one phase to move the frames there */
+
+typedef struct {
+  uint32_t tick_us;        /* report frame period */
+  uint32_t ticks_sofs;     /* SOFs per report frame */
+  uint32_t lead_us;        /* run a frame this long before its SOF */
+  bool locked;             /* phase and period known: frames follow the SOFs */
+  bool have_sof;
+  uint16_t last_fn;        /* 11-bit number of the last SOF seen */
+  uint32_t last_seen_us;
+  uint32_t frame;          /* unwrapped number of the last SOF seen */
+  uint32_t ref_frame;      /* SOF whose time is estimated ... */
+  uint32_t ref_us;         /* ... as this */
+  int32_t period_q8;       /* SOF period in local us, Q8 */
+  int32_t win_min;         /* earliest sighting in this window, vs. predicted */
+  uint32_t win_n;
+  uint32_t phase;          /* report frames run ahead of SOFs n with n % ticks_sofs == phase */
+  uint32_t poll_phase;     /* phase of the last polls seen ... */
+  uint32_t poll_run;       /* ... and how many in a row */
+  uint32_t next_frame;     /* SOF the next report frame runs ahead of (locked) */
+  uint32_t next_us;        /* when the next report frame is due */
+  uint32_t sofs;           /* SOFs seen */
+  uint32_t locks;          /* times the clock (re)locked */
+} frameclock_t;
+
+/* Report frames every tick_us (a multiple of FRAMECLOCK_SOF_US), lead_us ahead of the SOF. */
+void frameclock_init(frameclock_t *c, uint32_t tick_us, uint32_t lead_us, uint32_t now_us);
+
+/* A SOF with 11-bit frame number fn was seen at now_us. */
+void frameclock_sof(frameclock_t *c, uint32_t fn, uint32_t now_us);
+
+/* The host took an IN report. Call it where SOFs are seen (tud_task): the completion
+ * is reported after the SOF of the frame it happened in, so the last SOF seen is the
+ * poll's. Once FRAMECLOCK_POLLS polls in a row fall in another phase than the frames',
+ * the frames move there. Phases are of 11-bit SOF numbers, so they hold across relocks
+ * when ticks_sofs divides 2048 (host interrupt schedules are powers of two). */
+void frameclock_polled(frameclock_t *c);
+
+/* True once per report frame when it is due; *late_us is how far past its time it
+ * is. After a stall it skips ahead rather than running the missed frames back to back. */
+bool frameclock_due(frameclock_t *c, uint32_t now_us, uint32_t *late_us);
+
+/* Microseconds until the next report frame is due (0 if it is). */
+uint32_t frameclock_wait_us(frameclock_t *c, uint32_t now_us);
+
+/* SOF period estimate against the local clock, in ppm of nominal (0 while unlocked). */
+int32_t frameclock_ppm(const frameclock_t *c);
+
+#endif
@@ -0,0 +1,40 @@
+/**
+ * Velocity-weighted sensor fusion for redundant mice observing the same motion.
+ * Each input is weighted by its recent disagreement with the fused estimate;
+ * inputs stuck at zero while the others move are treated as dropped out.
+ * The fused measurement then goes through a fixed-point alpha-beta filter.
+ */
+#ifndef FUSION_H
+#define FUSION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FUSION_MAX_INPUTS    16   /* the most mouse slots a build can have */
+#define FUSION_ALPHA_SHIFT   1    /* alpha = 1/2 (position correction) */
+#define FUSION_BETA_SHIFT    3    /* beta = 1/8 (velocity correction) */
+#define FUSION_NOISE_SHIFT   3    /* noise estimate EWMA weight = 1/8 */
+#define FUSION_NOISE_FLOOR   64   /* Q8: noise never below 0.25 count, caps any weight */
+#define FUSION_DROP_SPEED    (2 << 8)  /* Q8: fused speed that makes a zero input suspicious */
+#define FUSION_DROP_FRAMES   3    /* frames at zero while moving before an input is dropped */
+
+typedef struct {
+  int32_t noise_q8[FUSION_MAX_INPUTS];  /* EWMA of |input - fused| per input (L1, Q8) */
+  uint8_t stuck[FUSION_MAX_INPUTS];     /* consecutive frames at zero while moving */
+  int32_t meas_q8[2];                   /* integrated fused measurement (Q8, relative) */
+  int32_t pos_q8[2];                    /* filtered position (Q8, relative) */
+  int32_t vel_q8[2];                    /* filtered velocity (Q8 counts per frame) */
+} fusion_t;
+
+void fusion_reset(fusion_t *f);
+
+/* One frame: n inputs' deltas in (int16 range, as the per-mouse stage leaves them),
+ * fused integer delta out. live_mask excludes inputs known to be absent (bit i =
+ * input i usable). */
+void fusion_step(fusion_t *f, const int32_t *dx, const int32_t *dy, int n,
+                 uint32_t live_mask, int32_t *out_x, int32_t *out_y);
+
+/* Bit i set when input i is currently considered dropped out. */
+uint32_t fusion_dropped(const fusion_t *f, int n);
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ * Mouse reports from HID devices: where buttons, X, Y, wheel and pan sit in a report,
+ * worked out once per device (the boot layout, or from the report descriptor of a
+ * report-protocol mouse), then compiled into a plan of fixed loads and shifts so each
+ * report is read without looking at the descriptor again. Any field size up to 32
+ * bits at any bit position (12-bit packed axes, 16 buttons). No Pico SDK or TinyUSB
+ * dependencies, so descriptors captured from real mice can be checked on a PC.
+ */
+#ifndef HID_MOUSE_H
+#define HID_MOUSE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define HID_MOUSE_BUTTONS_MAX  16
+
+/* One field: bit offset from the start of the report data (after the report ID). */
+typedef struct {
+  uint16_t offset;
+  uint8_t size;      /* bits; 0 = not in the report */
+  bool is_signed;    /* logical minimum < 0 */
+} hid_field_t;
+
+typedef struct {
+  uint8_t report_id;   /* 0 = reports carry no ID byte */
+  hid_field_t buttons; /* bit i = button i + 1; size = button count */
+  hid_field_t x, y, wheel, pan;
+} hid_mouse_layout_t;
+
+/* One field, compiled: the value is bits [shift, shift + size) of the nbytes
+ * little-endian bytes at byte. */
+typedef struct {
+  uint8_t byte;
+  uint8_t nbytes;    /* 0 = not in the report */
+  uint8_t shift;
+  uint8_t size;
+  bool is_signed;
+} hid_op_t;
+
+typedef struct {
+  uint8_t report_id;
+  uint8_t min_len;   /* report data bytes (after the ID) that X and Y need */
+  hid_op_t buttons, x, y, wheel, pan;
+} hid_mouse_plan_t;
+
+typedef struct {
+  uint16_t buttons;
+  int16_t dx, dy;
+  int16_t wheel, pan;  /* detents */
+} hid_mouse_report_t;
+
+/* Boot protocol: buttons, X, Y, then (on most mice) wheel, one byte each. */
+void hid_mouse_boot_layout(hid_mouse_layout_t *l);
+
+/* Find the first relative X/Y mouse collection in a report descriptor. Returns false
+ * if there is none (keyboards, absolute pointers, vendor interfaces). */
+bool hid_mouse_parse(const uint8_t *desc, size_t len, hid_mouse_layout_t *l);
+
+/* Compile a layout into its extraction plan. */
+void hid_mouse_compile(const hid_mouse_layout_t *l, hid_mouse_plan_t *p);
+
+/* Read one input report as received (with its ID byte, if the plan has one). Returns
+ * false if it is another report ID's or too short for X and Y; optional fields past
+ * the end (the boot wheel) read as 0. Axes saturate to int16. */
+bool hid_mouse_extract(const hid_mouse_plan_t *p, const uint8_t *report, size_t len, hid_mouse_report_t *out);
+
+#endif
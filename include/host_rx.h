@@ -0,0 +1,43 @@
+/**
+ * Slot-addressed host records, as carried by the 0xAB packet (UART, USB CDC) and the
+ * raw HID OUT frame: validation and decode, so that the firmware and the host tests
+ * read them the same way. No Pico SDK dependencies.
+ *
+ * Record: slot, buttons, dx, dy, wheel, pan (int16 little-endian, wheel/pan in
+ * 1/120 detent). Raw HID OUT frame (one 64-byte transfer): count, sequence, then
+ * count records; USB checks integrity, so there is no sync or checksum.
+ */
+#ifndef HOST_RX_H
+#define HOST_RX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HOST_RECORD_LEN        10
+#define HOST_RAW_HEADER_LEN    2
+#define HOST_RAW_FRAME_LEN     64
+#define HOST_RAW_RECORDS_MAX   ((HOST_RAW_FRAME_LEN - HOST_RAW_HEADER_LEN) / HOST_RECORD_LEN)   /* 6 */
+
+typedef struct {
+  uint8_t slot;
+  uint8_t buttons;
+  int16_t dx, dy, wheel, pan;
+} host_record_t;
+
+/* Raw HID OUT frames accepted, and sequence numbers seen */
+typedef struct {
+  uint32_t frames;
+  uint32_t gaps;     /* frames whose sequence number was not the last one + 1 */
+  uint8_t seq;
+} host_raw_rx_t;
+
+/* Raw HID OUT frame of len bytes: the number of records it carries, or -1 if it is
+ * shorter than its header and records or claims more than HOST_RAW_RECORDS_MAX. An
+ * accepted frame is counted, and so is a gap before it. */
+int host_raw_frame(host_raw_rx_t *rx, const uint8_t *p, int len);
+
+/* Record k of the records at rec into r. False if its slot is not one of slots
+ * (bit i = slot i; slots past 31 are never). */
+bool host_record(const uint8_t *rec, int k, uint32_t slots, host_record_t *r);
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * Per-mouse liveness: when each input last delivered data and last moved,
+ * and how often its packets arrive. A mouse is live while it has moved (or
+ * changed buttons) within the stale timeout; AVERAGE and FUSION only count
+ * live mice so an unplugged or silent input no longer dilutes the result.
+ */
+#ifndef LIVENESS_H
+#define LIVENESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LIVENESS_MAX_SLOTS   16   /* the most mouse slots a build can have */
+
+#define LIVENESS_DEAD        0   /* nothing received within the stale timeout (or never) */
+#define LIVENESS_IDLE        1   /* packets arriving, but no motion within the timeout */
+#define LIVENESS_ACTIVE      2   /* moved within the timeout */
+
+typedef struct {
+  uint32_t last_packet_ms;   /* last time a source delivered data for this slot */
+  uint32_t last_active_ms;   /* last non-zero motion or button change */
+  uint16_t interval_q4;      /* EWMA of packet inter-arrival time, ms x16 */
+  uint32_t packets;
+  bool moved;                /* last_active_ms is valid */
+} liveness_slot_t;
+
+void liveness_reset(void);
+
+/* Record data for a slot; active = it carried motion or a button change. */
+void liveness_mark(int slot, bool active, uint32_t now_ms);
+
+/* Bit i set for each of the first n slots that is ACTIVE. */
+uint32_t liveness_mask(int n, uint32_t now_ms, uint16_t stale_ms);
+
+/* Bit i set for each of the first n slots that is not DEAD (IDLE or ACTIVE). */
+uint32_t liveness_present_mask(int n, uint32_t now_ms, uint16_t stale_ms);
+
+uint8_t liveness_state(int slot, uint32_t now_ms, uint16_t stale_ms);
+
+/* Packet arrival rate in Hz (0 if unknown). */
+uint16_t liveness_rate_hz(int slot);
+
+const liveness_slot_t *liveness_get(int slot);
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * Execution plan: everything the report path derives from settings (which inputs to
+ * poll, which logic kernel to run, fixed-point gains), worked out once per settings
+ * change instead of on every frame. No Pico SDK dependencies.
+ */
+#ifndef PLAN_H
+#define PLAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "settings.h"
+#include "fastdiv.h"
+
+typedef struct plan plan_t;
+
+/* Input sources, by index: SETTINGS_SRC_* is 1 << index */
+#define PLAN_SRC_HOST   0
+#define PLAN_SRC_QUAD   1
+#define PLAN_SRC_SPI    2
+#define PLAN_SRC_USB    3
+#define PLAN_SOURCES    4
+
+/* Combined-mode logic stage: per-mouse (already transformed) deltas in, one delta out.
+ * live has bit i set for each mouse that is live (only filled in if needs_live). */
+typedef void (*plan_logic_fn)(const plan_t *p, const int32_t *mx, const int32_t *my,
+                              uint32_t live, int32_t *dx, int32_t *dy);
+
+struct plan {
+  uint32_t version;        /* settings version the plan was built from */
+  uint8_t num_mice;
+  uint8_t sources;         /* SETTINGS_SRC_* the input mode runs (UART pins, quad, SPI, USB host) */
+  uint16_t src_slots[PLAN_SOURCES];  /* per PLAN_SRC_*: slots (bit i = mouse i < num_mice) it adds into */
+  uint8_t cascade;         /* SETTINGS_CASCADE_*: mice go up the UART instead of to USB */
+  uint8_t cascade_slot;    /* upstream slot of mouse 0 (or of the combined output) */
+  uint8_t quad_sampler;    /* SETTINGS_QUAD_*: main loop, edge IRQ or adaptive timer */
+  uint8_t quad_filter;     /* majority filter taps (1 = off) */
+  uint32_t quad_rate_max_hz;  /* timer sampler ceiling */
+  uint16_t xform_mask;     /* mice with a non-identity transform */
+  plan_logic_fn logic;     /* NULL for fusion, whose filter state lives with the caller */
+  uint8_t logic_mode;      /* SETTINGS_LOGIC_*, for the 2-ball kernel */
+  bool needs_live;         /* logic stage reads the liveness mask */
+  bool accel_on;
+  int16_t quad_scale;      /* quadrature counts per reported count (>= 1) */
+  fastdiv_t quad_div;      /* / quad_scale */
+  fastdiv_t avg_div[SETTINGS_NUM_MICE_MAX + 1];  /* / live mouse count (AVERAGE) */
+  int32_t amplify_x100;    /* combined-mode gain x100, as configured */
+  fastdiv_t amplify_div;   /* / 100 */
+  int32_t abs_gain_q8;     /* absolute-mode units per count, Q8 */
+};
+
+/* Absolute output: one count moves this many units (times amplify). */
+#define PLAN_ABS_UNITS_PER_COUNT  8
+
+/* Largest per-frame delta plan_amplify() takes before clamping (keeps d * gain in int32). */
+#define PLAN_AMPLIFY_IN_MAX  ((int32_t)1 << 21)
+
+/* Per-mouse deltas into and out of plan_xform(): int16, less -32768, so a row of a
+ * SETTINGS_XFORM_MAX matrix and the remainder stay in int32. */
+#define PLAN_XFORM_IN_MAX    32767
+
+/* Largest per-frame delta plan_abs_units() takes before clamping: crosses the whole
+ * range at the lowest gain, and keeps d * gain in int32 at the highest (amplify 10). */
+#define PLAN_ABS_IN_MAX      ((int32_t)1 << 16)
+
+/* Build the plan for settings snapshot s. */
+void plan_build(plan_t *p, const settings_t *s);
+
+/* Input sources set up so far, carried from one plan to the next (main.c's
+ * sources_apply). Zero-initialise before the first plan. */
+typedef struct {
+  uint8_t up;          /* SETTINGS_SRC_* set up and not stopped since */
+  uint8_t num_mice;    /* the plan's num_mice when they were */
+} plan_sources_t;
+
+/* The sources to stop and then to set up to go from st to what p runs. A source that
+ * left the plan is stopped, and one that enters it is set up again even if it ran
+ * before: another source may have taken its pins meanwhile (the SPI chip selects are
+ * quadrature pins). Sources in per_mouse set up pins for num_mice slots, so they are
+ * stopped and set up again when num_mice changes. Updates st. */
+void plan_sources_step(plan_sources_t *st, const plan_t *p, uint8_t per_mouse,
+                       uint8_t *stop, uint8_t *start);
+
+/* Mouse transform: (dx, dy) through the Q8 matrix m ({ xx, xy, yx, yy }, entries within
+ * SETTINGS_XFORM_MAX), with the sub-count remainder carried in res_q8 from one frame to
+ * the next. Deltas in and out are clamped to PLAN_XFORM_IN_MAX. */
+void plan_xform(const int16_t *m, int32_t *res_q8, int32_t *dx, int32_t *dy);
+
+/* Absolute-mode step: d counts at gain_q8 units per count (plan.abs_gain_q8), in whole
+ * units, with the remainder carried in *res_q8. */
+int32_t plan_abs_units(int32_t d, int32_t gain_q8, int32_t *res_q8);
+
+/* Combined-mode gain: d * amplify, truncated toward zero. Integer-only (the M0+ has
+ * no FPU or divide instruction), and exact where the float product used to round. */
+static inline int32_t plan_amplify(const plan_t *p, int32_t d) {
+  if (p->amplify_x100 == 100) return d;
+  if (d > PLAN_AMPLIFY_IN_MAX) d = PLAN_AMPLIFY_IN_MAX;
+  if (d < -PLAN_AMPLIFY_IN_MAX) d = -PLAN_AMPLIFY_IN_MAX;
+  return fastdiv_s32(&p->amplify_div, d * p->amplify_x100);
+}
+
+#endif
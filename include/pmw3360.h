@@ -0,0 +1,113 @@
+/**
+ * PMW3360-class SPI optical sensors (PMW3360, PMW3389 and others with the same motion
+ * burst): power-up, optional SROM download, and a non-blocking round-robin of motion
+ * burst reads over one SPI bus with a chip select per sensor. The bus is reached only
+ * through pmw_bus_t, so the firmware plugs in SPI + DMA and anything else (a mock
+ * device on a PC) can stand in for it. No Pico SDK dependencies.
+ */
+#ifndef PMW3360_H
+#define PMW3360_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PMW_SENSORS_MAX   6
+
+#define PMW_REG_PRODUCT_ID      0x00
+#define PMW_REG_MOTION          0x02
+#define PMW_REG_DELTA_X_L       0x03
+#define PMW_REG_DELTA_Y_H       0x06
+#define PMW_REG_CONFIG1         0x0F   /* resolution: CPI / 100 - 1 */
+#define PMW_REG_CONFIG2         0x10
+#define PMW_REG_SROM_ENABLE     0x13
+#define PMW_REG_SROM_ID         0x2A
+#define PMW_REG_POWER_UP_RESET  0x3A
+#define PMW_REG_MOTION_BURST    0x50
+#define PMW_REG_SROM_LOAD_BURST 0x62
+
+#define PMW_PRODUCT_ID    0x42
+#define PMW_BURST_LEN     12   /* Motion .. Shutter_Lower */
+#define PMW_CPI_MIN       100
+#define PMW_CPI_MAX       12000
+
+/* Datasheet timings (us) */
+#define PMW_T_SRAD        160  /* address to read data */
+#define PMW_T_SRAD_MOTBR  35   /* motion burst address to first byte */
+#define PMW_T_SCLK_NCS_W  35   /* last write bit to chip select high */
+#define PMW_T_SWW         180  /* write to next write */
+#define PMW_T_SRR         20   /* read to next access */
+#define PMW_T_BEXIT       1    /* chip select high between bursts (500 ns) */
+#define PMW_T_SROM_BYTE   15   /* between SROM download bytes */
+
+/* Motion register bits */
+#define PMW_MOTION_MOT    0x80  /* motion since the last burst */
+#define PMW_MOTION_LIFT   0x08  /* lifted off the surface */
+
+typedef struct {
+  int16_t dx;
+  int16_t dy;
+  uint8_t squal;     /* surface quality */
+  bool lifted;
+} pmw_motion_t;
+
+/* Bus access. select() drives one sensor's chip select (on = low). read() starts a
+ * transfer of n bytes into buf (clocking out zeros) and may return before it is done;
+ * busy() is then polled until it completes. */
+typedef struct {
+  void (*select)(void *ctx, int sensor, bool on);
+  void (*write)(void *ctx, const uint8_t *buf, size_t n);
+  void (*read)(void *ctx, uint8_t *buf, size_t n);
+  bool (*busy)(void *ctx);
+  void (*delay_us)(void *ctx, uint32_t us);
+  void *ctx;
+} pmw_bus_t;
+
+/* Burst read state, per pass over the sensors. */
+enum {
+  PMW_IDLE,    /* next: address the current sensor */
+  PMW_WAIT,    /* address sent; data valid at t_us */
+  PMW_READ,    /* burst transfer in flight */
+};
+
+typedef struct {
+  const pmw_bus_t *bus;
+  uint8_t count;             /* sensors on the bus (chip selects 0..count-1) */
+  uint8_t present;           /* sensors that answered with PMW_PRODUCT_ID */
+  uint8_t cur;               /* sensor being read */
+  uint8_t state;             /* PMW_IDLE, PMW_WAIT or PMW_READ */
+  uint32_t t_us;             /* when the current wait ends */
+  uint8_t buf[PMW_BURST_LEN];
+  int32_t acc[PMW_SENSORS_MAX][2];  /* counts not yet taken [sensor][x, y] */
+  uint8_t moved;             /* sensors that counted since the caller last cleared it */
+  uint8_t lifted;            /* sensors off the surface at their last burst */
+  uint32_t bursts;           /* completed burst reads */
+  uint32_t bad;              /* bursts dropped as implausible (bus fault, sensor gone) */
+} pmw_t;
+
+/* SROM firmware image to download at power-up, or NULL to run the sensor's ROM
+ * firmware. Weak, returns NULL: link a definition that returns the vendor image
+ * (it can't be shipped here) to enable the download. */
+const uint8_t *pmw_srom(size_t *len);
+
+/* Read register reg (blocking, with datasheet delays). */
+uint8_t pmw_read_reg(const pmw_bus_t *bus, int sensor, uint8_t reg);
+
+/* Write register reg (blocking, with datasheet delays). */
+void pmw_write_reg(const pmw_bus_t *bus, int sensor, uint8_t reg, uint8_t v);
+
+/* Power up count sensors (blocking, ~55 ms each plus the SROM download) at cpi counts
+ * per inch, and get ready for pmw_poll(). Returns the mask of sensors found. */
+uint8_t pmw_init(pmw_t *p, const pmw_bus_t *bus, int count, uint16_t cpi);
+
+/* Decode one motion burst; false if it can't be a real sensor's (MISO stuck high). */
+bool pmw_burst_parse(const uint8_t *b, pmw_motion_t *m);
+
+/* Advance the burst round-robin as far as it goes without waiting: each present sensor
+ * in turn is addressed, left alone for PMW_T_SRAD_MOTBR, then read by one transfer.
+ * Call often (every main loop pass); now_us is a free-running microsecond clock.
+ * Counts add up in acc until the caller takes them. Returns the sensors whose burst
+ * completed with motion during this call. */
+uint32_t pmw_poll(pmw_t *p, uint32_t now_us);
+
+#endif
@@ -0,0 +1,52 @@
+/**
+ * Report path profiler: how long input waits before the host has its HID
+ * report (packet arrival to transfer complete), as a log2 histogram, plus
+ * frame and report counts. Used to compare output layouts (six endpoints vs
+ * one composite interface) from the status query. Also how evenly report
+ * frames run: each interval's distance from the frame period (jitter), and how
+ * late each frame started against the frame clock.
+ */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+#define PROFILER_BUCKETS     16
+#define PROFILER_BUCKET0_US  125   /* bucket 0: < 125 us, bucket b: < 125 << b (last: the rest) */
+#define PROFILER_JITTER_BUCKETS  8
+#define PROFILER_JITTER0_US      8   /* bucket 0: < 8 us, bucket b: < 8 << b (last: the rest) */
+
+typedef struct {
+  uint32_t hist[PROFILER_BUCKETS];
+  uint32_t samples;     /* latencies recorded */
+  uint32_t max_us;
+  uint32_t frames;      /* report frames run */
+  uint32_t reports;     /* HID reports the host collected */
+  uint32_t start_ms;    /* when the stats were last reset */
+  uint32_t jitter_hist[PROFILER_JITTER_BUCKETS];
+  uint32_t intervals;   /* frame intervals measured */
+  uint64_t jitter_sum_us;
+  uint32_t jitter_max_us;
+  uint64_t late_sum_us; /* per frame, so the mean is over frames */
+  uint32_t late_max_us;
+  uint32_t last_frame_us;
+} profiler_stats_t;
+
+void profiler_reset(uint32_t now_ms);
+
+/* Count one report frame, started at now_us, late_us after it was due, and
+ * measure its interval from the last against the frame period. */
+void profiler_frame(uint32_t now_us, uint32_t period_us, uint32_t late_us);
+
+/* Count one completed report. */
+void profiler_report(void);
+
+/* Record the latency of a completed report's oldest input. */
+void profiler_latency(uint32_t us);
+
+/* Histogram bucket for a latency. */
+int profiler_bucket(uint32_t us);
+
+const profiler_stats_t *profiler_get(void);
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * Quadrature decode over one packed sample of all encoder pins: 4 bits per mouse
+ * (X_A, X_B, Y_A, Y_B from bit 4*i up). Only axes whose pins changed are looked at,
+ * so a still sample costs one compare. A step where both pins of an axis changed
+ * can't be decoded (the direction is unknown): it is counted per axis, and a
+ * non-zero count means the pins are sampled too slowly for the ball speed.
+ * No Pico SDK dependencies.
+ */
+#ifndef QUAD_H
+#define QUAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define QUAD_MICE  6
+#define QUAD_BITS  (QUAD_MICE * 4)
+#define QUAD_MASK  ((1u << QUAD_BITS) - 1u)
+#define QUAD_TAPS_MAX  5   /* longest majority filter */
+#define QUAD_STEP_ILLEGAL  (1u << 31)   /* quad_step() flag: a step was dropped */
+#define QUAD_MOVED_MASK    ((1u << QUAD_MICE) - 1u)
+
+/* Adaptive sample rate (timer sampler): idle at QUAD_RATE_IDLE_HZ, jump to the ceiling
+ * on the first change or on any illegal step, then settle to the slowest rate that still
+ * sees a change in no more than 1 of QUAD_RATE_BUSY samples. Each halving needs a whole
+ * QUAD_RATE_WINDOW with changes in fewer than 1 of QUAD_RATE_QUIET samples. */
+#define QUAD_RATE_IDLE_HZ  1000
+#define QUAD_RATE_WINDOW   64
+#define QUAD_RATE_BUSY     4
+#define QUAD_RATE_QUIET    16
+
+typedef struct {
+  uint32_t prev;                /* last packed sample */
+  int16_t acc[QUAD_MICE][2];    /* counts not yet taken [mouse][x, y], saturating */
+  uint8_t moved;                /* mice that counted since the caller last cleared it */
+  uint32_t illegal[QUAD_MICE][2];  /* steps lost to both pins changing at once */
+} quad_state_t;
+
+/* Glitch filter: each pin reads as the majority of its last taps samples (1 = off). */
+typedef struct {
+  uint32_t hist[QUAD_TAPS_MAX];
+  uint8_t pos;
+  uint8_t taps;
+} quad_filter_t;
+
+/* Start decoding from sample (no counts for the first state). */
+void quad_reset(quad_state_t *q, uint32_t sample);
+
+typedef struct {
+  uint32_t period_us;       /* current sample period */
+  uint32_t min_period_us;   /* ceiling rate */
+  uint32_t max_period_us;   /* idle rate */
+  uint16_t samples;         /* in the current window */
+  uint16_t changes;         /* samples in the window where any pin changed */
+} quad_rate_t;
+
+/* Decode one sample; returns the mice that counted in this step, plus
+ * QUAD_STEP_ILLEGAL if a step had to be dropped. */
+uint32_t quad_step(quad_state_t *q, uint32_t sample);
+
+/* Per-bit majority of taps packed samples (taps 1, 3 or 5). */
+uint32_t quad_vote(const uint32_t *s, int taps);
+
+/* Start filtering with taps (1, 3 or 5) samples, all equal to sample. */
+void quad_filter_reset(quad_filter_t *f, uint8_t taps, uint32_t sample);
+
+/* Add a raw sample; returns the filtered sample. */
+uint32_t quad_filter(quad_filter_t *f, uint32_t sample);
+
+/* Start idle, with a ceiling of ceiling_hz. */
+void quad_rate_init(quad_rate_t *r, uint32_t ceiling_hz);
+
+/* Feed one sample's outcome; returns the period until the next sample in us. */
+uint32_t quad_rate_step(quad_rate_t *r, bool changed, bool illegal);
+
+#endif
@@ -7,9 +7,19 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "config.h"
 
+/* Mouse slots compiled in: MAX_MICE from config.h (2..16), 6 for an older config.h.
+ * Sizes the per-mouse arrays; num_mice picks how many are used at run time. */
+#ifndef MAX_MICE
+#define MAX_MICE  6
+#endif
 #define SETTINGS_NUM_MICE_MIN  2
-#define SETTINGS_NUM_MICE_MAX  6
+#define SETTINGS_NUM_MICE_MAX  MAX_MICE
+#define SETTINGS_NUM_MICE_LIMIT 16   /* masks are uint16_t */
+#if SETTINGS_NUM_MICE_MAX < SETTINGS_NUM_MICE_MIN || SETTINGS_NUM_MICE_MAX > SETTINGS_NUM_MICE_LIMIT
+#error "MAX_MICE must be 2..16. Run configure.py."
+#endif
 #define SETTINGS_LOGIC_SUM      0
 #define SETTINGS_LOGIC_AVERAGE  1
 #define SETTINGS_LOGIC_MAX      2
@@ -20,33 +30,95 @@
 #define SETTINGS_LOGIC_2_NAND   7
 #define SETTINGS_LOGIC_2_NOR    8
 #define SETTINGS_LOGIC_2_XNOR   9
+#define SETTINGS_LOGIC_FUSION   10  /* redundant sensors: confidence-weighted, filtered */
 #define SETTINGS_INPUT_UART         0
 #define SETTINGS_INPUT_QUADRATURE  1
 #define SETTINGS_INPUT_BOTH         2
+#define SETTINGS_INPUT_SPI          3   /* PMW3360-class optical sensors on SPI */
+#define SETTINGS_INPUT_USB          4   /* USB mice on the PIO-USB host port (USB_HOST_PIO builds) */
 #define SETTINGS_OUTPUT_COMBINED   0   /* single combined mouse (instance 0) */
 #define SETTINGS_OUTPUT_SEPARATE   1   /* 6 separate mice (instances 0..5) */
+#define SETTINGS_OUTPUT_ABSOLUTE   2   /* one multi-touch digitizer, one contact per mouse */
+#define SETTINGS_OUTPUT_COMPOSITE  3   /* 6 mice on one interface, one report ID each */
+#define SETTINGS_OUTPUT_RAW        4   /* one vendor report with all mice (host software reads it) */
+#define SETTINGS_XFORM_ONE         256 /* Q8 fixed point: 256 = 1.0 in transform matrices */
+#define SETTINGS_XFORM_MAX         32767  /* |entry|, so a row times int16 deltas fits in int32 */
+#define SETTINGS_ACCEL_OFF         0
+#define SETTINGS_ACCEL_LINEAR      1   /* gain = 1 + rate * (speed - threshold), capped */
+#define SETTINGS_ACCEL_EXP         2   /* gain rises exponentially toward accel_max */
+#define SETTINGS_ACCEL_WINDOW_MIN  4
+#define SETTINGS_ACCEL_WINDOW_MAX  64
+#define SETTINGS_STALE_MS_DEFAULT  1000 /* mouse counts as live this long after it last moved */
+#define SETTINGS_QUAD_POLL         0   /* sample quadrature pins from the main loop */
+#define SETTINGS_QUAD_IRQ          1   /* sample on GPIO edge interrupts */
+#define SETTINGS_QUAD_TIMER        2   /* sample from a timer whose rate follows ball speed */
+#define SETTINGS_QUAD_RATE_MAX_KHZ 50  /* highest allowed timer sampler ceiling */
+#define SETTINGS_QUAD_FILTER_MAX   5   /* majority-of-N glitch filter: N = 1 (off), 3 or 5 */
+/* Input sources, as bits of slot_src: which sources may feed each mouse slot */
+#define SETTINGS_SRC_HOST          0x01  /* UART / USB CDC packets and raw HID OUT frames */
+#define SETTINGS_SRC_QUAD          0x02  /* quadrature encoder i */
+#define SETTINGS_SRC_SPI           0x04  /* SPI sensor i */
+#define SETTINGS_SRC_USB           0x08  /* USB host mice, in plug-in order */
+#define SETTINGS_SRC_ALL           0x0F
+/* Cascade: this Pico sends its mice up the UART to another Pico instead of to USB */
+#define SETTINGS_CASCADE_OFF       0   /* head of a chain, or no chain: UART input as usual */
+#define SETTINGS_CASCADE_SLOTS     1   /* each mouse i goes up as slot cascade_slot + i */
+#define SETTINGS_CASCADE_COMBINED  2   /* transform + logic output goes up as slot cascade_slot */
 
 typedef struct {
-  uint8_t num_mice;      /* 2..6 */
+  uint8_t num_mice;      /* 2..SETTINGS_NUM_MICE_MAX */
   uint8_t logic_mode;
   uint8_t input_mode;
-  uint8_t output_mode;   /* combined (0) or separate (1) */
+  uint8_t output_mode;   /* combined (0), separate (1), absolute (2), composite (3) or raw (4) */
   float amplify;
   uint16_t quad_scale;
+  int16_t xform[SETTINGS_NUM_MICE_MAX][4];  /* per-mouse 2x2 matrix, Q8: { xx, xy, yx, yy } */
+  uint16_t xform_mask;   /* derived: bit i set when mouse i's matrix is not identity */
+  uint8_t accel_mode;    /* SETTINGS_ACCEL_* (combined mode only) */
+  uint8_t accel_window_ms;   /* speed = counts moved within this window */
+  uint8_t accel_threshold;   /* speed (counts per window) where gain starts rising */
+  uint16_t accel_rate;       /* curve steepness, in thousandths per count of speed */
+  uint16_t accel_max_x100;   /* gain cap x100 (100..1000) */
+  uint16_t stale_ms;     /* liveness timeout (50..60000 ms) */
+  uint8_t button_min_hold_ms;  /* each reported button state lasts at least this long (0..100) */
+  uint8_t quad_sampler;  /* SETTINGS_QUAD_* */
+  uint8_t quad_filter;   /* samples per majority vote: 1 (off), 3 or 5 */
+  uint8_t quad_rate_max_khz;  /* timer sampler ceiling (1..50 kHz) */
+  uint8_t slot_src[SETTINGS_NUM_MICE_MAX];  /* per mouse slot: SETTINGS_SRC_* that feed it */
+  uint8_t cascade_mode;  /* SETTINGS_CASCADE_* */
+  uint8_t cascade_slot;  /* first upstream slot this node's mice take (0..15) */
+  uint32_t version;      /* settings_version() at the time this snapshot was published */
 } settings_t;
 
 /* Load defaults from config.h, then try load from flash. Call once at boot. */
 void settings_init(void);
 
-/* Pointer to current settings (valid after settings_init). */
-const settings_t *settings_get(void);
+/* Copy the current settings into *out (valid after settings_init). The copy is always
+ * one complete, clamped update, even while another context is changing settings;
+ * take one per main loop iteration rather than reading fields piecemeal. */
+void settings_acquire(settings_t *out);
+
+/* Incremented on every settings change; lets callers rebuild derived state lazily. */
+uint32_t settings_version(void);
 
-/* Update a single setting (e.g. from UART). Values are clamped. */
+/* Update a single setting (e.g. from UART). Values are clamped, then published as a
+ * new snapshot. Only one context may call these (the main loop). */
 void settings_set_num_mice(uint8_t n);
 void settings_set_logic_mode(uint8_t m);
 void settings_set_input_mode(uint8_t m);
 void settings_set_amplify(float a);
 void settings_set_quad_scale(uint16_t q);
+/* Per-mouse transform: out_x = (xx*dx + xy*dy) / 256, out_y = (yx*dx + yy*dy) / 256. */
+void settings_set_xform(uint8_t mouse, int16_t xx, int16_t xy, int16_t yx, int16_t yy);
+void settings_set_accel(uint8_t mode, uint8_t window_ms, uint8_t threshold, uint16_t rate, uint16_t max_x100);
+void settings_set_stale_ms(uint16_t ms);
+void settings_set_button_min_hold(uint8_t ms);
+void settings_set_quad_sampler(uint8_t sampler);
+void settings_set_quad_filter(uint8_t taps);
+void settings_set_quad_rate_max(uint8_t khz);
+/* Sources (SETTINGS_SRC_* bits) allowed to feed each of the SETTINGS_NUM_MICE_MAX slots. */
+void settings_set_slot_sources(const uint8_t *masks);
+void settings_set_cascade(uint8_t mode, uint8_t slot);
 
 /* Apply raw bytes from UART: num_mice, logic_mode, input_mode, output_mode, amplify_x100, quad_scale (2 bytes). */
 void settings_apply_uart(uint8_t num_mice, uint8_t logic_mode, uint8_t input_mode,
@@ -0,0 +1,46 @@
+/**
+ * Telemetry: per-frame binary records (timestamp, raw per-mouse deltas, the
+ * motion sent to the HID output, buttons, drop count) queued in a lock-free
+ * single-producer / single-consumer ring and streamed over USB CDC. When the
+ * host reads too slowly the ring drops new records instead of blocking the
+ * report path; the drop count rides along in every record.
+ */
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TELEMETRY_MICE      6    /* records carry the first six mice */
+#define TELEMETRY_RING      32   /* records; must be a power of two */
+
+/* Wire format: 0x55 0xCF 0xA0, then the payload below (little-endian) */
+#define TELEMETRY_SYNC1     0x55
+#define TELEMETRY_SYNC2     0xCF
+#define TELEMETRY_TAG       0xA0
+#define TELEMETRY_WIRE_LEN  (3 + 4 + 4 + 1 + 1 + TELEMETRY_MICE * 4 + 4)
+
+typedef struct {
+  uint32_t time_us;
+  uint32_t dropped;                     /* records dropped so far (filled in by telemetry_push) */
+  uint8_t num_mice;
+  uint8_t buttons;                      /* OR of all mice */
+  int16_t raw[TELEMETRY_MICE][2];       /* per-mouse dx, dy this frame, before any processing */
+  int16_t out_dx, out_dy;               /* motion added to the HID output this frame */
+} telemetry_record_t;
+
+void telemetry_reset(void);
+
+void telemetry_enable(bool on);
+bool telemetry_enabled(void);
+
+/* Producer: queue a record. Returns false (and counts a drop) when the ring is full. */
+bool telemetry_push(telemetry_record_t *rec);
+
+/* Consumer: take the oldest record. Returns false when the ring is empty. */
+bool telemetry_pop(telemetry_record_t *rec);
+
+/* Serialize a record to TELEMETRY_WIRE_LEN bytes. */
+void telemetry_encode(const telemetry_record_t *rec, uint8_t *out);
+
+#endif
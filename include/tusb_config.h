@@ -9,14 +9,29 @@ extern "C" {
 #define CFG_TUD_ENABLED         1
 #define CFG_TUD_CDC             1   /* 1 CDC (serial) so Pico shows in /dev on host */
 #define CFG_TUD_CDC_RX_BUFSIZE  64
-#define CFG_TUD_CDC_TX_BUFSIZE  64
-#define CFG_TUD_HID             6   /* 6 HID interfaces for 6 separate mice or 1 combined */
-#define CFG_TUD_HID_EP_BUFSIZE  8
+#define CFG_TUD_CDC_TX_BUFSIZE  512  /* telemetry stream plus room for a status reply */
+#define CFG_TUD_HID             6   /* up to 6 mouse interfaces (raw: output + vendor raw) */
+#define CFG_TUD_HID_EP_BUFSIZE  64  /* report ID + TOUCH_REPORT_LEN (mouse reports use 8) */
 
 #ifndef BOARD_TUD_RHPORT
 #define BOARD_TUD_RHPORT        0
 #endif
 
+/* USB host on PIO-USB (cmake -DUSB_HOST_PIO=ON): up to 16 mice (MAX_MICE slots) behind
+ * up to 3 hubs, several HID interfaces each (many mice also expose a keyboard or
+ * vendor interface). */
+#if USB_HOST_PIO
+#define CFG_TUH_ENABLED         1
+#define CFG_TUH_RPI_PIO_USB     1
+#define BOARD_TUH_RHPORT        1
+#define CFG_TUH_HUB             3   /* hubs are counted apart from CFG_TUH_DEVICE_MAX */
+#define CFG_TUH_DEVICE_MAX      16
+#define CFG_TUH_HID             32
+#define CFG_TUH_HID_EPIN_BUFSIZE  64
+#define CFG_TUH_HID_EPOUT_BUFSIZE 8
+#define CFG_TUH_ENUMERATION_BUFSIZE 256
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,6 +1,69 @@
 #ifndef USB_DESCRIPTORS_H
 #define USB_DESCRIPTORS_H
 
-#define REPORT_ID_MOUSE  1
+#define REPORT_ID_MOUSE       1
+#define REPORT_ID_MULTIPLIER  2   /* feature: bits 0-1 wheel, bits 2-3 pan Resolution Multiplier */
+#define REPORT_ID_TOUCH       3   /* absolute output: all contacts in one report */
+#define REPORT_ID_TOUCH_MAX   4   /* feature: Contact Count Maximum */
+#define REPORT_ID_RAW         5   /* raw output: all mice in one vendor report */
+/* Composite output: mouse k on one interface uses these in place of 1 and 2 */
+#define REPORT_ID_COMPOSITE_MOUSE(k)  (0x11 + (k))
+#define REPORT_ID_COMPOSITE_MULT(k)   (0x21 + (k))
+
+/* Report frame period, and the bInterval of the combined and per-mouse endpoints, so
+ * the host polls each once per frame. Single-interface profiles poll every 1 ms. */
+#define HID_POLL_MS           2
+
+/* Wheel/pan units per detent once the host sets the Resolution Multiplier
+ * (physical max in the report descriptor). Matches the Windows/Linux 120 per notch. */
+#define WHEEL_HIRES_MULT      120
+
+/* Per-mouse outputs the descriptors offer: HID interfaces (separate), report IDs
+ * (composite), touch contacts (absolute) and raw report records. With more mice than
+ * this, mouse i shares output i % USB_MOUSE_OUTPUTS. */
+#define USB_MOUSE_OUTPUTS     6
+
+/* Mouse input report (after the report ID): buttons, X, Y, then wheel and AC Pan as int16 LE */
+#define MOUSE_REPORT_LEN      7
+
+/* Touch report (after the report ID): ABS_CONTACTS x (flags, contact id, x, y as uint16 LE),
+ * then contact count. flags: bit 0 tip switch, bit 1 in range. */
+#define ABS_CONTACTS          USB_MOUSE_OUTPUTS
+#define ABS_LOGICAL_MAX       32767
+#define TOUCH_CONTACT_LEN     6
+#define TOUCH_REPORT_LEN      (ABS_CONTACTS * TOUCH_CONTACT_LEN + 1)
+
+/* Raw report (after the report ID): mouse count, then RAW_SLOTS x mouse report layout
+ * (buttons, dx, dy, wheel, pan). Wheel and pan are always in 1/WHEEL_HIRES_MULT detents. */
+#define RAW_SLOTS             USB_MOUSE_OUTPUTS
+#define RAW_REPORT_LEN        (1 + RAW_SLOTS * MOUSE_REPORT_LEN)
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* USB descriptor profile: which output layout, and how many HID interfaces */
+typedef struct {
+  uint8_t output_mode;
+  uint8_t hid_count;   /* output interfaces */
+  bool vendor;         /* plus the vendor raw interface (raw profile only) */
+} usb_profile_t;
+
+/* Profile the current settings call for. */
+void usb_profile_from_settings(usb_profile_t *p);
+
+/* Profile the host enumerated (latched when it reads the configuration descriptor);
+ * before the first enumeration, the one the settings call for. */
+const usb_profile_t *usb_profile(void);
+uint8_t usb_output_mode(void);
+
+/* True when the settings call for a different profile than the host enumerated,
+ * i.e. the device should disconnect and re-enumerate. */
+bool usb_profile_stale(void);
+
+/* HID instance of the vendor raw interface (after the profile's output interface, in
+ * the raw profile only; USB_VENDOR_NONE otherwise): 64-byte OUT reports carry batched
+ * mouse frames from host software. */
+#define USB_VENDOR_NONE       0xFF
+uint8_t usb_vendor_instance(void);
 
 #endif
@@ -0,0 +1,410 @@
+#!/usr/bin/env python3
+"""
+Simulate a chain of Picos cascaded over UART (cascade_mode; see include/cascade.h)
+and account for the latency each link adds, before wiring one up. Node 0 is the
+head (on USB); node k sends its mice, and everything it received from node k+1,
+up to node k-1 in 0xAC frames, encoded and decoded byte for byte as the firmware
+does. Each node runs its own 2 ms report frame (at a random phase) and a main
+loop that reads the UART RX FIFO and feeds the 32-byte TX FIFO once per pass.
+
+  python3 scripts/cascade_sim.py                                  # 3 Picos x 5 mice, per-slot
+  python3 scripts/cascade_sim.py --nodes 4 --mice 12 --mode combined   # 48 inputs, 15 head slots
+  python3 scripts/cascade_sim.py --baud 115200 --rate 2000        # a slow link under load
+  python3 scripts/cascade_sim.py --golden tests/cascade_frames.txt   # encoder against the firmware's frames
+
+Per link: time an input waits in the sending node (for its own mice, the wait for
+the next report frame; then for the frame ahead of it to leave), time on the
+wire, and time until the receiving main loop reads the last byte. End to end:
+from the mouse moving to the head holding it, and on to the head's next report
+frame. Also checks that every count reached the head, and how far the head's
+estimate of each frame's input time (from its age field) is from the truth.
+
+The encoder and parser below mirror src/cascade.c; --golden replays the adds,
+frames and received frames of tests/cascade_frames.txt, which test_cascade
+generates and checks from the C code, and fails on any byte that differs.
+
+No dependencies beyond the Python standard library.
+"""
+import argparse
+import heapq
+import random
+import struct
+
+CASCADE_SYNC = 0xAC
+CASCADE_SCROLL = 0x80
+CASCADE_SLOTS = 16
+CASCADE_AGE_MAX = 0xFFFF
+HEADER_LEN = 5
+RECORD_LEN = 6
+TX_FIFO = 32   # RP2040 UART FIFO depth
+
+
+def frame_len(count: int) -> int:
+    return HEADER_LEN + count * RECORD_LEN + 1
+
+
+def clamp16(v: int) -> int:
+    return max(-32768, min(32767, v))
+
+
+class Tx:
+    """Mirror of cascade_tx_t / cascade_tx_frame()."""
+
+    def __init__(self):
+        self.acc = [[0, 0, 0, 0, 0, 0] for _ in range(CASCADE_SLOTS)]   # dx dy wheel pan buttons sent
+        self.oldest = None
+        self.hops = 0
+        self.events = [[] for _ in range(CASCADE_SLOTS)]   # simulation only: inputs waiting per slot
+
+    def add(self, slot, buttons, dx, dy, origin_us, hops, events, wheel=0, pan=0):
+        if not 0 <= slot < CASCADE_SLOTS:
+            return
+        a = self.acc[slot]
+        a[0] += dx
+        a[1] += dy
+        a[2] += wheel
+        a[3] += pan
+        changed = dx or dy or wheel or pan or buttons != a[4]
+        a[4] = buttons
+        if not changed:
+            return   # counts that cancelled out (combined mode): nothing to send, or to time
+        self.events[slot].extend(events)
+        if self.oldest is None or origin_us < self.oldest:
+            self.oldest = origin_us
+        self.hops = max(self.hops, hops)
+
+    def frame(self, now_us):
+        if self.oldest is None:
+            return None, []
+        recs, events, rest = b"", [], False
+        for i, a in enumerate(self.acc):
+            if not (a[0] or a[1] or a[2] or a[3] or a[4] != a[5]):
+                continue
+            if a[0] or a[1] or a[4] != a[5] or not (a[2] or a[3]):
+                dx, dy = clamp16(a[0]), clamp16(a[1])
+                a[0] -= dx
+                a[1] -= dy
+                recs += struct.pack("<BBhh", i, a[4], dx, dy)
+            if a[2] or a[3]:
+                wh, pan = clamp16(a[2]), clamp16(a[3])
+                a[2] -= wh
+                a[3] -= pan
+                recs += struct.pack("<BBhh", i | CASCADE_SCROLL, a[4], wh, pan)
+            a[5] = a[4]
+            events += self.events[i]
+            self.events[i] = []
+            rest |= bool(a[0] or a[1] or a[2] or a[3])
+        age = min(now_us - self.oldest, CASCADE_AGE_MAX)
+        body = struct.pack("<BBH", len(recs) // RECORD_LEN, min(self.hops + 1, 0xFF), int(age)) + recs
+        x = 0
+        for b in body:
+            x ^= b
+        if not rest:
+            self.oldest = None
+            self.hops = 0
+        return bytes([CASCADE_SYNC]) + body + bytes([x]), events
+
+
+def parse(frame: bytes):
+    """Mirror of cascade_check() / cascade_record(): (hops, age_us, records) or None."""
+    if (len(frame) < frame_len(0) or frame[0] != CASCADE_SYNC or frame[1] > 2 * CASCADE_SLOTS
+            or len(frame) != frame_len(frame[1])):
+        return None
+    x = 0
+    for b in frame[1:-1]:
+        x ^= b
+    if x != frame[-1]:
+        return None
+    count, hops, age = struct.unpack_from("<BBH", frame, 1)
+    recs = [struct.unpack_from("<BBhh", frame, HEADER_LEN + k * RECORD_LEN) for k in range(count)]
+    return hops, age, recs
+
+
+def golden(path: str) -> None:
+    """Replay a frame script from test_cascade (see tests/test_cascade.c)."""
+    tx, bad, lines = Tx(), 0, 0
+    with open(path) as f:
+        for n, line in enumerate(f, 1):
+            op, _, rest = line.partition(": ")
+            args, _, want = rest.partition(" -> ")
+            want = want.strip()
+            if op == "add":
+                slot, buttons, dx, dy, wheel, pan, origin, hops = (int(v) for v in args.split())
+                tx.add(slot, buttons, dx, dy, origin, hops, [], wheel, pan)
+            elif op == "frame":
+                got, _ = tx.frame(int(args))
+                got = got.hex(" ").upper() if got else "-"
+            elif op == "rx":
+                got = "bad" if parse(bytes.fromhex(args)) is None else "ok"
+            else:
+                continue
+            lines += 1
+            if op != "add" and got != want:
+                print(f"{path}:{n}: {op} gives {got}, the firmware {want}")
+                bad += 1
+    print(f"{path}: {lines} lines, " + (f"{bad} differ" if bad else "every frame and check as the firmware"))
+    if bad:
+        raise SystemExit(1)
+
+
+class Event:
+    __slots__ = ("origin", "node", "slot", "dx", "dy", "t_in", "hop_t", "head_t")
+
+    def __init__(self, origin, node, slot, dx, dy):
+        self.origin, self.node, self.slot, self.dx, self.dy = origin, node, slot, dx, dy
+        self.t_in = origin   # entered the current node's cascade path
+        self.hop_t = []      # per link crossed: (link, wait, wire, poll)
+        self.head_t = None
+
+
+class Node:
+    def __init__(self, k, args, rng):
+        self.k = k
+        self.tx = Tx()
+        self.mice = [[0, 0, []] for _ in range(args.mice)]   # dx, dy, events (g_mice)
+        self.next_frame = rng.uniform(0, args.frame_us)
+        self.rx = []        # (arrival_us, byte) from the node below, in order
+        self.rx_pos = 0
+        self.rx_buf = b""
+        self.out = b""      # frame being written (g_cascade_buf)
+        self.out_pos = 0
+        self.out_events = []
+        self.out_built = 0.0
+        self.line_free = 0.0   # when the last byte handed to the UART finishes
+        self.fifo = []         # start times of bytes handed to the UART, pending shift-out
+        self.bytes_sent = 0
+
+
+def pct(vals, p):
+    if not vals:
+        return 0.0
+    s = sorted(vals)
+    return s[min(len(s) - 1, int(p / 100.0 * len(s)))]
+
+
+def stats_line(name, vals):
+    if not vals:
+        return f"  {name:<14} -"
+    return (f"  {name:<14} mean {sum(vals) / len(vals):8.1f}  p50 {pct(vals, 50):8.1f}  "
+            f"p99 {pct(vals, 99):8.1f}  max {max(vals):8.1f}")
+
+
+def main() -> None:
+    ap = argparse.ArgumentParser(description="Simulate a UART cascade of amplified mouse Picos")
+    ap.add_argument("--nodes", type=int, default=3, help="Picos in the chain, head included (default 3)")
+    ap.add_argument("--mice", type=int, default=5, help="Mice on each Pico (default 5)")
+    ap.add_argument("--mode", choices=["slots", "combined"], default="slots",
+                    help="cascade_mode of the downstream Picos (default slots)")
+    ap.add_argument("--baud", type=int, default=1000000, help="UART baud (default 1000000)")
+    ap.add_argument("--frame-us", type=float, default=2000, help="Report frame period (default 2000)")
+    ap.add_argument("--loop-us", type=float, default=20, help="Main loop pass, mean (default 20)")
+    ap.add_argument("--rate", type=float, default=500, help="Motion events per second per mouse (default 500)")
+    ap.add_argument("--duration", type=float, default=2.0, help="Seconds of input (default 2)")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--golden", metavar="FILE", help="Replay a test_cascade frame script instead of simulating")
+    args = ap.parse_args()
+    if args.golden:
+        golden(args.golden)
+        return
+
+    if args.nodes < 2 or args.mice < 1:
+        raise SystemExit("need at least 2 nodes and 1 mouse each")
+    # Upstream slots: the head's own mice are 0..mice-1; node k's follow
+    per_node = args.mice if args.mode == "slots" else 1
+    base = [0] + [args.mice + (k - 1) * per_node for k in range(1, args.nodes)]
+    head_slots = args.mice + (args.nodes - 1) * per_node
+    if head_slots > CASCADE_SLOTS:
+        raise SystemExit(f"the head needs {head_slots} slots, more than {CASCADE_SLOTS}: "
+                         f"use --mode combined or fewer nodes")
+
+    rng = random.Random(args.seed)
+    byte_us = 10e6 / args.baud
+    nodes = [Node(k, args, rng) for k in range(args.nodes)]
+    end_us = args.duration * 1e6
+    drain_us = end_us + 50000
+
+    # Mouse motion: Poisson per mouse, small deltas (quadrature / UART-sized). Each mouse
+    # keeps one heading, so counts never cancel within a frame and every event is motion.
+    inputs = []
+    for n in nodes:
+        for m in range(args.mice):
+            sx, sy = rng.choice((-1, 1)), rng.choice((-1, 1))
+            t = rng.expovariate(args.rate) * 1e6
+            while t < end_us:
+                inputs.append((t, n.k, m, sx * rng.randint(1, 4), sy * rng.randint(0, 4)))
+                t += rng.expovariate(args.rate) * 1e6
+    inputs.sort()
+    in_pos = 0
+    sent = {}          # head slot -> [dx, dy] generated
+    got = {}           # head slot -> [dx, dy] applied at the head
+    age_err = []
+    head_events = []
+    head_frames = []   # head report frame times, for the last leg
+    bad = 0
+
+    heap = [(rng.uniform(0, args.loop_us), n.k) for n in nodes]
+    heapq.heapify(heap)
+    while heap:
+        now, k = heapq.heappop(heap)
+        if now > drain_us:
+            break
+        while in_pos < len(inputs) and inputs[in_pos][0] <= now:
+            t, nk, m, dx, dy = inputs[in_pos]
+            in_pos += 1
+            slot = m if nk == 0 else (base[nk] + m if args.mode == "slots" else base[nk])
+            ev = Event(t, nk, slot, dx, dy)
+            mouse = nodes[nk].mice[m]
+            mouse[0] += dx
+            mouse[1] += dy
+            mouse[2].append(ev)
+            s = sent.setdefault(slot, [0, 0])
+            s[0] += dx
+            s[1] += dy
+        n = nodes[k]
+
+        # UART RX: everything that has arrived, parsed as the firmware does
+        while n.rx_pos < len(n.rx) and n.rx[n.rx_pos][0] <= now:
+            arr, b, events = n.rx[n.rx_pos]
+            n.rx_pos += 1
+            if not n.rx_buf and b != CASCADE_SYNC:
+                continue
+            n.rx_buf += bytes([b])
+            if len(n.rx_buf) < 2 or len(n.rx_buf) < frame_len(n.rx_buf[1]):
+                continue
+            frame, n.rx_buf = n.rx_buf, b""
+            p = parse(frame)
+            if p is None:
+                bad += 1
+                continue
+            hops, age, recs = p
+            origin_est = now - (age + len(frame) * byte_us)
+            for ev in events:
+                link, built, done = ev.hop_t[-1]
+                ev.hop_t[-1] = (link, built - ev.t_in, done - built, now - done)
+                ev.t_in = now
+            if k == 0:
+                true_origin = min(ev.origin for ev in events) if events else origin_est
+                age_err.append(origin_est - true_origin)
+                for slot, _bt, a, b2 in recs:
+                    g = got.setdefault(slot & 0x3F, [0, 0])
+                    if not slot & CASCADE_SCROLL:
+                        g[0] += a
+                        g[1] += b2
+                for ev in events:
+                    ev.head_t = now
+                    head_events.append(ev)
+            else:
+                by_slot = {}
+                for ev in events:
+                    by_slot.setdefault(ev.slot, []).append(ev)
+                for slot, bt, a, b2 in recs:
+                    if slot & CASCADE_SCROLL:
+                        continue
+                    n.tx.add(slot, bt, a, b2, origin_est, hops, by_slot.pop(slot, []))
+
+        # Report frame: own mice into the cascade (downstream) or the HID output (head)
+        if now >= n.next_frame:
+            n.next_frame += args.frame_us
+            if k == 0:
+                head_frames.append(now)
+                for m in n.mice:
+                    for ev in m[2]:
+                        ev.head_t = now
+                        head_events.append(ev)
+                    m[0] = m[1] = 0
+                    m[2] = []
+            elif args.mode == "slots":
+                for i, m in enumerate(n.mice):
+                    origin = min((e.origin for e in m[2]), default=now)
+                    n.tx.add(base[k] + i, 0, m[0], m[1], origin, 0, m[2])
+                    m[0] = m[1] = 0
+                    m[2] = []
+            else:
+                dx = sum(m[0] for m in n.mice)
+                dy = sum(m[1] for m in n.mice)
+                evs = [e for m in n.mice for e in m[2]]
+                origin = min((e.origin for e in evs), default=now)
+                n.tx.add(base[k], 0, dx, dy, origin, 0, evs)
+                for m in n.mice:
+                    m[0] = m[1] = 0
+                    m[2] = []
+
+        # TX pump (cascade_pump): next frame once the FIFO has drained, then fill it
+        if k > 0:
+            n.fifo = [s for s in n.fifo if s > now]
+            if n.out_pos == len(n.out) and not n.fifo:
+                n.out, evs = n.tx.frame(now)
+                n.out = n.out or b""
+                n.out_pos = 0
+                n.out_built = now
+                n.out_events = evs
+            up = nodes[k - 1]
+            while n.out_pos < len(n.out) and len(n.fifo) < TX_FIFO:
+                start = max(now, n.line_free)
+                n.line_free = start + byte_us
+                n.fifo.append(start)
+                n.out_pos += 1
+                last = n.out_pos == len(n.out)
+                evs = n.out_events if last else []
+                if last:
+                    for ev in evs:
+                        ev.hop_t.append((k, n.out_built, n.line_free))
+                up.rx.append((n.line_free, n.out[n.out_pos - 1], evs))
+                n.bytes_sent += 1
+        heapq.heappush(heap, (now + rng.uniform(0.5, 1.5) * args.loop_us, k))
+
+    # Head's own mice arrive in its slots directly
+    for ev in head_events:
+        if ev.node == 0:
+            g = got.setdefault(ev.slot, [0, 0])
+            g[0] += ev.dx
+            g[1] += ev.dy
+
+    inputs_total = args.nodes * args.mice
+    print(f"{args.nodes} Picos x {args.mice} mice = {inputs_total} inputs, downstream mode {args.mode}, "
+          f"{head_slots} head slots, {args.baud} baud, {args.frame_us:.0f} us frames, "
+          f"~{args.loop_us:.0f} us main loop, {args.rate:.0f} events/s per mouse")
+    print(f"{len(inputs)} motion events over {args.duration:.1f} s\n")
+
+    links = {}
+    for ev in head_events:
+        for link, wait, wire, poll in ev.hop_t:
+            links.setdefault(link, ([], [], [], []))
+            for lst, v in zip(links[link], (wait, wire, poll, wait + wire + poll)):
+                lst.append(v)
+    for link in sorted(links, reverse=True):
+        wait, wire, poll, total = links[link]
+        util = nodes[link].bytes_sent * byte_us / drain_us * 100
+        print(f"Link {link} -> {link - 1} (us; {len(total)} events, {util:.1f}% of the line busy):")
+        print(stats_line("wait to send", wait))
+        print(stats_line("on the wire", wire))
+        print(stats_line("RX poll", poll))
+        print(stats_line("hop total", total))
+
+    print("\nEnd to end (us), by origin Pico:")
+    for k in range(args.nodes):
+        evs = [ev for ev in head_events if ev.node == k]
+        e2e = [ev.head_t - ev.origin for ev in evs]
+        print(stats_line(f"Pico {k} ({k} hop{'s' if k != 1 else ''})", e2e))
+    to_frame = []
+    fi = 0
+    for ev in sorted((e for e in head_events if e.node > 0), key=lambda e: e.head_t):
+        while fi < len(head_frames) and head_frames[fi] < ev.head_t:
+            fi += 1
+        if fi < len(head_frames):
+            to_frame.append(head_frames[fi] - ev.origin)
+    print(stats_line("to head frame", to_frame))
+
+    print("\nAge field: head's input time estimate minus the true oldest input (us):")
+    print(stats_line("error", age_err))
+
+    lost = {s: (sent[s][0] - got.get(s, [0, 0])[0], sent[s][1] - got.get(s, [0, 0])[1])
+            for s in sent if tuple(sent[s]) != tuple(got.get(s, [0, 0]))}
+    print(f"\nCounts: {len(sent)} slots, " + ("all delivered exactly" if not lost else f"MISMATCH {lost}") +
+          f", {bad} bad frames")
+    if lost or bad:
+        raise SystemExit(1)
+
+
+if __name__ == "__main__":
+    main()
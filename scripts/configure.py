@@ -17,9 +17,12 @@ LOGIC_MODES = {
     "sum": 0, "average": 1, "max": 2,
     "min": 3, "and": 4, "or": 5, "xor": 6,
     "nand": 7, "nor": 8, "xnor": 9,
+    "fusion": 10,
 }
-INPUT_MODES = {"uart": 0, "quadrature": 1, "both": 2}
-OUTPUT_MODES = {"combined": 0, "separate": 1}
+INPUT_MODES = {"uart": 0, "quadrature": 1, "both": 2, "spi": 3, "usb": 4}
+OUTPUT_MODES = {"combined": 0, "separate": 1, "absolute": 2, "composite": 3, "raw": 4}
+ACCEL_MODES = {"off": 0, "linear": 1, "exp": 2}
+QUAD_SAMPLERS = {"poll": 0, "irq": 1, "timer": 2}
 
 
 def load_yaml(path: Path) -> dict:
@@ -51,17 +54,31 @@ def load_yaml(path: Path) -> dict:
     return out
 
 
-def write_config_h(num_mice: int, logic_mode: int, input_mode: int, output_mode: int, amplify: float, quad_scale: int) -> None:
+def write_config_h(num_mice: int, logic_mode: int, input_mode: int, output_mode: int, amplify: float, quad_scale: int,
+                   accel: dict, quad_sampler: int = 0, quad_filter: int = 1,
+                   quad_rate_max_khz: int = 20, spi_cpi: int = 1600, max_mice: int = 6,
+                   uart_baud: int = 115200) -> None:
     content = f"""/* Generated by scripts/configure.py from config/config.yaml or CLI. Edit config/config.yaml and run scripts/configure.py to change. */
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#define MAX_MICE        {max_mice}
 #define NUM_MICE        {num_mice}
 #define LOGIC_MODE      {logic_mode}
 #define INPUT_MODE      {input_mode}
 #define OUTPUT_MODE     {output_mode}
 #define AMPLIFY         {float(amplify)}f
 #define QUAD_SCALE      {quad_scale}
+#define ACCEL_MODE      {accel["mode"]}
+#define ACCEL_WINDOW_MS {accel["window_ms"]}
+#define ACCEL_THRESHOLD {accel["threshold"]}
+#define ACCEL_RATE      {accel["rate"]}
+#define ACCEL_MAX       {float(accel["max"])}f
+#define QUAD_SAMPLER    {quad_sampler}
+#define QUAD_FILTER     {quad_filter}
+#define QUAD_RATE_MAX_KHZ {quad_rate_max_khz}
+#define SPI_CPI         {spi_cpi}
+#define UART_BAUD       {uart_baud}
 
 #endif
 """
@@ -71,12 +88,23 @@ def write_config_h(num_mice: int, logic_mode: int, input_mode: int, output_mode:
 
 def main() -> None:
     ap = argparse.ArgumentParser(description="Generate config.h for amplified mouse firmware")
-    ap.add_argument("--num-mice", type=int, metavar="N", help="Number of mice (2-6)")
-    ap.add_argument("--logic-mode", choices=list(LOGIC_MODES), metavar="MODE", help="Logic: sum, average, max, min, and, or, xor, nand, nor, xnor")
-    ap.add_argument("--input-mode", choices=list(INPUT_MODES), metavar="MODE", help="Input: uart, quadrature, both")
-    ap.add_argument("--output-mode", choices=list(OUTPUT_MODES), metavar="MODE", help="Output: combined (1 mouse) or separate (6 mice)")
+    ap.add_argument("--max-mice", type=int, metavar="N", help="Mouse slots compiled in (2-16, default 6)")
+    ap.add_argument("--num-mice", type=int, metavar="N", help="Number of mice (2 to max_mice)")
+    ap.add_argument("--logic-mode", choices=list(LOGIC_MODES), metavar="MODE", help="Logic: sum, average, max, min, and, or, xor, nand, nor, xnor, fusion")
+    ap.add_argument("--input-mode", choices=list(INPUT_MODES), metavar="MODE", help="Input: uart, quadrature, both, spi, usb")
+    ap.add_argument("--output-mode", choices=list(OUTPUT_MODES), metavar="MODE", help="Output: combined (1 mouse), separate (6 mice), absolute (multi-touch, 1 contact per mouse) composite (6 mice on 1 interface) or raw (vendor report, all mice)")
     ap.add_argument("--amplify", type=float, metavar="F", help="Amplification factor")
     ap.add_argument("--quad-scale", type=int, metavar="N", help="Quadrature scale")
+    ap.add_argument("--accel-mode", choices=list(ACCEL_MODES), metavar="MODE", help="Acceleration curve: off, linear, exp")
+    ap.add_argument("--accel-window", type=int, metavar="MS", help="Speed window in ms (4-64)")
+    ap.add_argument("--accel-threshold", type=int, metavar="N", help="Speed (counts per window) where acceleration starts")
+    ap.add_argument("--accel-rate", type=int, metavar="N", help="Curve steepness in thousandths per count")
+    ap.add_argument("--accel-max", type=float, metavar="F", help="Maximum acceleration gain (1.0-10.0)")
+    ap.add_argument("--quad-sampler", choices=list(QUAD_SAMPLERS), metavar="MODE", help="Quadrature sampling: poll, irq or timer")
+    ap.add_argument("--quad-filter", type=int, choices=[1, 3, 5], metavar="N", help="Quadrature glitch filter taps (1 = off, 3 or 5)")
+    ap.add_argument("--quad-rate-max", type=int, metavar="KHZ", help="Timer sampler ceiling in kHz (1-50)")
+    ap.add_argument("--spi-cpi", type=int, metavar="CPI", help="SPI optical sensor resolution (100-12000)")
+    ap.add_argument("--uart-baud", type=int, metavar="BAUD", help="UART baud (default 115200; 1000000 for a cascade chain)")
     ap.add_argument("--list", action="store_true", help="List options and exit")
     args = ap.parse_args()
 
@@ -84,10 +112,12 @@ def main() -> None:
         print("Logic modes:", ", ".join(LOGIC_MODES))
         print("Input modes:", ", ".join(INPUT_MODES))
         print("Output modes:", ", ".join(OUTPUT_MODES))
-        print("num_mice: 2-6, amplify: float, quad_scale: int")
+        print("Accel modes:", ", ".join(ACCEL_MODES))
+        print("max_mice: 2-16, num_mice: 2 to max_mice, amplify: float, quad_scale: int")
         return
 
     cfg = load_yaml(CONFIG_YAML)
+    max_mice = args.max_mice if args.max_mice is not None else int(cfg.get("max_mice", 6))
     num_mice = args.num_mice if args.num_mice is not None else int(cfg.get("num_mice", 6))
     logic_mode = LOGIC_MODES[args.logic_mode] if args.logic_mode is not None else LOGIC_MODES.get(
         str(cfg.get("logic_mode", "sum")).lower(), 0
@@ -101,12 +131,42 @@ def main() -> None:
     amplify = args.amplify if args.amplify is not None else float(cfg.get("amplify", 1.0))
     quad_scale = args.quad_scale if args.quad_scale is not None else int(cfg.get("quad_scale", 2))
 
-    if num_mice < 2 or num_mice > 6:
-        raise SystemExit("num_mice must be 2-6")
+    accel = {
+        "mode": ACCEL_MODES[args.accel_mode] if args.accel_mode is not None else ACCEL_MODES.get(
+            str(cfg.get("accel_mode", "off")).lower(), 0
+        ),
+        "window_ms": args.accel_window if args.accel_window is not None else int(cfg.get("accel_window_ms", 20)),
+        "threshold": args.accel_threshold if args.accel_threshold is not None else int(cfg.get("accel_threshold", 4)),
+        "rate": args.accel_rate if args.accel_rate is not None else int(cfg.get("accel_rate", 50)),
+        "max": args.accel_max if args.accel_max is not None else float(cfg.get("accel_max", 4.0)),
+    }
+
+    quad_sampler = QUAD_SAMPLERS[args.quad_sampler] if args.quad_sampler is not None else QUAD_SAMPLERS.get(
+        str(cfg.get("quad_sampler", "poll")).lower(), 0
+    )
+    quad_filter = args.quad_filter if args.quad_filter is not None else int(cfg.get("quad_filter", 1))
+    if quad_filter not in (1, 3, 5):
+        raise SystemExit("quad_filter must be 1, 3 or 5")
+    quad_rate_max = args.quad_rate_max if args.quad_rate_max is not None else int(cfg.get("quad_rate_max_khz", 20))
+    if quad_rate_max < 1 or quad_rate_max > 50:
+        raise SystemExit("quad_rate_max_khz must be 1-50")
+    spi_cpi = args.spi_cpi if args.spi_cpi is not None else int(cfg.get("spi_cpi", 1600))
+    if spi_cpi < 100 or spi_cpi > 12000:
+        raise SystemExit("spi_cpi must be 100-12000")
+
+    uart_baud = args.uart_baud if args.uart_baud is not None else int(cfg.get("uart_baud", 115200))
+    if uart_baud < 9600 or uart_baud > 3000000:
+        raise SystemExit("uart_baud must be 9600-3000000")
+
+    if max_mice < 2 or max_mice > 16:
+        raise SystemExit("max_mice must be 2-16")
+    if num_mice < 2 or num_mice > max_mice:
+        raise SystemExit(f"num_mice must be 2-{max_mice} (max_mice)")
     if quad_scale < 1:
         quad_scale = 1
 
-    write_config_h(num_mice, logic_mode, input_mode, output_mode, amplify, quad_scale)
+    write_config_h(num_mice, logic_mode, input_mode, output_mode, amplify, quad_scale, accel, quad_sampler, quad_filter,
+                   quad_rate_max, spi_cpi, max_mice, uart_baud)
 
 
 if __name__ == "__main__":
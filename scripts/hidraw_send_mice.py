@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""
+Push mouse frames to the Pico over its vendor raw HID interface (Linux hidraw,
+no libusb; the interface is there with output_mode raw). Each 64-byte OUT report
+is one frame, so a whole multi-mouse frame is one USB transfer (up to 1000 frames/s).
+
+  python3 scripts/hidraw_send_mice.py                       # random motion on slots 0-5, auto-detect /dev/hidrawN
+  python3 scripts/hidraw_send_mice.py --device /dev/hidraw3 --rate 1000 --duration 10
+  python3 scripts/hidraw_send_mice.py --slot 6 --mice 6     # slots 6-11 (a max_mice 12 or 16 build)
+
+Frame layout (read by host_raw_frame in src/host_rx.c; tests/test_host_rx.c checks it):
+  byte 0      record count (0-6: 2 header bytes and 6 records of 10 fill 62 of the 64)
+  byte 1      sequence number (increments per frame; the Pico counts gaps)
+  bytes 2...  count x (slot, buttons, dx, dy, wheel, pan), int16 little-endian,
+              wheel/pan in 1/120 detent; slot 0-15, records for slots the firmware
+              does not feed from the host are dropped
+  rest        zero padding to 64 bytes
+
+Mice past six need more than one frame: --slot picks the first slot this run sends to.
+
+Needs read/write access to the hidraw node (e.g. a udev rule for 2e8a:000a).
+"""
+import argparse
+import glob
+import os
+import random
+import struct
+import time
+
+VID = 0x2E8A
+PID = 0x000A
+FRAME_LEN = 64
+RECORD = struct.Struct("<BBhhhh")
+HEADER_LEN = 2
+RECORDS_MAX = (FRAME_LEN - HEADER_LEN) // RECORD.size   # 6
+NUM_SLOTS = 16                                          # max_mice 16
+VENDOR_USAGE_PAGE = bytes([0x06, 0x00, 0xFF])  # both vendor interfaces' report descriptors start with this
+OUTPUT_ITEM = bytes([0x91, 0x02])              # Output (Data, Var, Abs): only the raw input interface has one
+
+
+def build_frame(seq: int, records) -> bytes:
+    """records: list of (slot, buttons, dx, dy, wheel, pan)."""
+    if len(records) > RECORDS_MAX:
+        raise ValueError(f"at most {RECORDS_MAX} records fit in a {FRAME_LEN}-byte frame")
+    buf = bytearray(FRAME_LEN)
+    buf[0] = len(records)
+    buf[1] = seq & 0xFF
+    for k, rec in enumerate(records):
+        if not 0 <= rec[0] < NUM_SLOTS:
+            raise ValueError(f"slot {rec[0]} is not 0-{NUM_SLOTS - 1}")
+        RECORD.pack_into(buf, HEADER_LEN + k * RECORD.size, *rec)
+    return bytes(buf)
+
+
+def find_hidraw() -> str:
+    """Find the Pico's vendor raw interface by VID/PID and report descriptor (the raw
+    output interface next to it has no Output report)."""
+    for node in sorted(glob.glob("/sys/class/hidraw/hidraw*")):
+        try:
+            with open(os.path.join(node, "device", "uevent")) as f:
+                uevent = f.read()
+            with open(os.path.join(node, "device", "report_descriptor"), "rb") as f:
+                rdesc = f.read()
+        except OSError:
+            continue
+        if (f"{VID:08X}:{PID:08X}" in uevent.upper() and rdesc.startswith(VENDOR_USAGE_PAGE)
+                and OUTPUT_ITEM in rdesc):
+            return "/dev/" + os.path.basename(node)
+    raise SystemExit("Pico raw HID interface not found (is it plugged in with output_mode raw? try --device)")
+
+
+def random_records(first_slot: int, mice: int, magnitude: int):
+    return [(first_slot + i, 0, random.randint(-magnitude, magnitude), random.randint(-magnitude, magnitude), 0, 0)
+            for i in range(mice)]
+
+
+def main() -> None:
+    ap = argparse.ArgumentParser(description="Send mouse frames to the Pico over raw HID (hidraw)")
+    ap.add_argument("--device", "-d", metavar="DEV", help="hidraw node (default: auto-detect)")
+    ap.add_argument("--mice", type=int, default=RECORDS_MAX, help=f"Mice (records) per frame (1-{RECORDS_MAX})")
+    ap.add_argument("--slot", type=int, default=0, help=f"First slot to send to (0-{NUM_SLOTS - 1})")
+    ap.add_argument("--rate", type=float, default=500, help="Frames per second")
+    ap.add_argument("--duration", type=float, default=0, help="Run for N seconds (0 = until Ctrl+C)")
+    ap.add_argument("--magnitude", type=int, default=4, help="Max |dx|,|dy| per mouse per frame")
+    args = ap.parse_args()
+    mice = max(1, min(RECORDS_MAX, args.mice))
+    if not 0 <= args.slot <= NUM_SLOTS - mice:
+        ap.error(f"--slot {args.slot} with {mice} mice runs past slot {NUM_SLOTS - 1}")
+
+    dev = args.device or find_hidraw()
+    interval = 1.0 / args.rate
+    start = time.monotonic()
+    seq = 0
+    print(f"Sending slots {args.slot}-{args.slot + mice - 1} to {dev} at {args.rate:g} frames/s. Ctrl+C to stop.")
+    fd = os.open(dev, os.O_WRONLY)
+    try:
+        next_t = start
+        while not args.duration or time.monotonic() - start < args.duration:
+            # hidraw: first byte is the report ID (0 = none)
+            os.write(fd, b"\x00" + build_frame(seq, random_records(args.slot, mice, args.magnitude)))
+            seq += 1
+            next_t += interval
+            delay = next_t - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        os.close(fd)
+    secs = time.monotonic() - start
+    print(f"Sent {seq} frames in {secs:.1f} s ({seq / max(secs, 1e-3):.0f} frames/s)")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,7 +1,9 @@
 #!/usr/bin/env python3
 """
 Read 6 mice from Linux evdev and send aggregated packets over serial to the Pico.
-Usage: python3 host_send_mice.py /dev/ttyUSB0 [--baud 115200]
+Usage: python3 host_send_mice.py /dev/ttyUSB0 [--baud 115200] [--v2]
+With --v2, each mouse is sent in its own slot-addressed record (own buttons, 16-bit
+deltas, high-resolution wheel and horizontal pan).
 Requires: pyserial, evdev (pip install pyserial evdev). Run with access to /dev/input (e.g. user in group input).
 """
 import argparse
@@ -24,6 +26,24 @@ SYNC = 0xAA
 # Packet matches firmware: 1 sync + 6*(dx,dy) + buttons + wheel = 15 bytes. Firmware uses first config.NUM_MICE.
 PACKET_LEN = 15
 NUM_MICE_MAX = 6
+# Slot-addressed packet: 0xAB, count, count * (slot, buttons, dx, dy, wheel, pan as int16 LE), xor
+SYNC_V2 = 0xAB
+WHEEL_HIRES_MULT = 120  # wheel/pan units per detent (same as REL_WHEEL_HI_RES)
+
+
+def clamp16(v):
+    return max(-32768, min(32767, v))
+
+
+def make_packet_v2(records):
+    """records: list of (slot, buttons, dx, dy, wheel, pan); wheel/pan in 1/120 detent."""
+    body = bytearray([len(records)])
+    for slot, btns, dx, dy, wheel, pan in records:
+        body += struct.pack("<BBhhhh", slot, btns & 0x1F, clamp16(dx), clamp16(dy), clamp16(wheel), clamp16(pan))
+    x = 0
+    for b in body:
+        x ^= b
+    return bytes([SYNC_V2]) + bytes(body) + bytes([x])
 
 
 def find_mice(limit=6):
@@ -47,6 +67,7 @@ def main():
     ap = argparse.ArgumentParser(description="Send 6 mouse inputs to Pico over UART")
     ap.add_argument("port", help="Serial port (e.g. /dev/ttyUSB0)")
     ap.add_argument("--baud", type=int, default=115200, help="Baud rate")
+    ap.add_argument("--v2", action="store_true", help="Send slot-addressed packets with per-mouse buttons, hi-res wheel and pan")
     args = ap.parse_args()
 
     mice = find_mice(NUM_MICE_MAX)
@@ -57,6 +78,11 @@ def main():
 
     ser = serial.Serial(args.port, args.baud, timeout=0)
     state = [[0, 0, 0, 0] for _ in range(NUM_MICE_MAX)]
+    # --v2 only: hi-res wheel, pan (1/120 detent) and buttons last sent per mouse
+    hires = [[0, 0] for _ in range(NUM_MICE_MAX)]
+    sent_buttons = [0] * NUM_MICE_MAX
+    has_hires = [False] * NUM_MICE_MAX
+    HIRES = {getattr(evdev.ecodes, "REL_WHEEL_HI_RES", -1): 0, getattr(evdev.ecodes, "REL_HWHEEL_HI_RES", -1): 1}
 
     def make_packet():
         buf = bytearray(PACKET_LEN)
@@ -104,6 +130,17 @@ def main():
                             state[i][1] += event.value
                         elif event.code == evdev.ecodes.REL_WHEEL:
                             state[i][3] += event.value
+                            if not has_hires[i]:
+                                hires[i][0] += event.value * WHEEL_HIRES_MULT
+                        elif event.code == evdev.ecodes.REL_HWHEEL:
+                            if not has_hires[i]:
+                                hires[i][1] += event.value * WHEEL_HIRES_MULT
+                        elif event.code in HIRES:
+                            # Kernel sends both; once a mouse reports hi-res, ignore its detent events
+                            if not has_hires[i]:
+                                has_hires[i] = True
+                                hires[i] = [0, 0]
+                            hires[i][HIRES[event.code]] += event.value
                     elif event.type == evdev.ecodes.EV_KEY:
                         if event.code in (evdev.ecodes.BTN_LEFT, evdev.ecodes.BTN_RIGHT, evdev.ecodes.BTN_MIDDLE):
                             bit = {evdev.ecodes.BTN_LEFT: 0, evdev.ecodes.BTN_RIGHT: 1, evdev.ecodes.BTN_MIDDLE: 2}[event.code]
@@ -111,6 +148,19 @@ def main():
                                 state[i][2] |= 1 << bit
                             else:
                                 state[i][2] &= ~(1 << bit)
+        if args.v2:
+            records = [
+                (i, state[i][2], state[i][0], state[i][1], hires[i][0], hires[i][1])
+                for i in range(NUM_MICE_MAX)
+                if state[i][0] or state[i][1] or hires[i][0] or hires[i][1] or state[i][2] != sent_buttons[i]
+            ]
+            if records:
+                ser.write(make_packet_v2(records))
+            for i in range(NUM_MICE_MAX):
+                state[i][0] = state[i][1] = state[i][3] = 0
+                hires[i] = [0, 0]
+                sent_buttons[i] = state[i][2]
+            continue
         for i in range(NUM_MICE_MAX):
             for j in (0, 1):
                 if state[i][j] > 127:
@@ -0,0 +1,231 @@
+#!/usr/bin/env python3
+"""
+Query the Pico's runtime status over its USB serial (CDC) port and print it:
+per-mouse liveness (active / idle / dead), time since each mouse last moved,
+packet arrival rate, the report latency histogram (input arrival to the
+host collecting the HID report) for the output layout in use, and how evenly
+report frames run against the USB frame clock.
+
+  python3 scripts/query_status.py --port /dev/ttyACM0
+  python3 scripts/query_status.py --port /dev/cu.usbmodem101 --watch 1
+  python3 scripts/query_status.py --port /dev/ttyACM0 --reset-latency   # start a fresh measurement
+
+Requires: pyserial.
+"""
+import argparse
+import struct
+import sys
+import time
+
+SYNC1 = 0x55
+SYNC2 = 0xCF
+CMD_STATUS = 0x10
+CMD_PROFILE_RESET = 0x11
+STATUS_REPLY = 0x90
+
+TAG_INFO = 0x01
+TAG_LIVENESS = 0x02
+TAG_LATENCY = 0x03
+TAG_RAW_OUT = 0x04
+TAG_QUAD = 0x05
+TAG_SPI = 0x06
+TAG_CASCADE = 0x07
+TAG_FRAME = 0x08
+TAG_END = 0xFF
+
+LIVENESS_STATES = {0: "dead", 1: "idle", 2: "active"}
+LOGIC_MODES = ["sum", "average", "max", "min", "and", "or", "xor", "nand", "nor", "xnor", "fusion"]
+OUTPUT_MODES = ["combined", "separate", "absolute", "composite", "raw"]
+QUAD_SAMPLERS = ["poll", "irq", "timer"]
+CASCADE_MODES = ["off", "slots", "combined"]
+LATENCY_BUCKET0_US = 125  # bucket 0: < 125 us, bucket b: < 125 << b
+FRAME_JITTER0_US = 8  # jitter bucket 0: < 8 us, bucket b: < 8 << b
+
+
+def read_exact(ser, n: int) -> bytes:
+    buf = b""
+    while len(buf) < n:
+        chunk = ser.read(n - len(buf))
+        if not chunk:
+            raise TimeoutError("no reply from device")
+        buf += chunk
+    return buf
+
+
+def read_status(ser) -> dict:
+    """Send a status query and collect reply sections as {tag: bytes}."""
+    ser.reset_input_buffer()
+    ser.write(bytes([SYNC1, SYNC2, CMD_STATUS]))
+    # Skip anything (e.g. telemetry) until the reply header
+    window = b""
+    while window != bytes([SYNC1, SYNC2, STATUS_REPLY]):
+        window = (window + read_exact(ser, 1))[-3:]
+    sections = {}
+    while True:
+        tag, length = read_exact(ser, 2)
+        data = read_exact(ser, length) if length else b""
+        if tag == TAG_END:
+            return sections
+        sections[tag] = data
+
+
+def decode_info(data: bytes) -> str:
+    uptime, version, n, logic, output = struct.unpack_from("<IIBBB", data)
+    lm = LOGIC_MODES[logic] if logic < len(LOGIC_MODES) else str(logic)
+    om = OUTPUT_MODES[output] if output < len(OUTPUT_MODES) else str(output)
+    return f"  uptime {uptime / 1000:.1f} s, settings v{version}, num_mice={n}, logic={lm}, output={om}"
+
+
+def decode_liveness(data: bytes) -> str:
+    n = data[0]
+    lines = []
+    for i in range(n):
+        state, age, rate = struct.unpack_from("<BHH", data, 1 + i * 5)
+        age_s = "never" if age == 0xFFFF else f"{age} ms ago"
+        lines.append(f"  mouse {i}: {LIVENESS_STATES.get(state, state):6}  last moved {age_s:>12}  {rate:5} Hz")
+    return "\n".join(lines)
+
+
+def latency_percentile(hist, samples: int, q: float) -> str:
+    """Upper edge of the bucket holding the q-th percentile."""
+    target = q * samples
+    seen = 0
+    for b, count in enumerate(hist):
+        seen += count
+        if seen >= target:
+            return f"<{(LATENCY_BUCKET0_US << b) / 1000:g} ms" if b < len(hist) - 1 else "long"
+    return "-"
+
+
+def decode_latency(data: bytes) -> str:
+    mode, elapsed, frames, reports, samples, max_us = struct.unpack_from("<BIIIII", data)
+    hist = struct.unpack_from(f"<{(len(data) - 21) // 4}I", data, 21)
+    om = OUTPUT_MODES[mode] if mode < len(OUTPUT_MODES) else str(mode)
+    secs = max(elapsed / 1000, 1e-3)
+    lines = [f"  layout {om}, {elapsed / 1000:.1f} s: {frames / secs:.0f} frames/s, {reports / secs:.0f} reports/s"]
+    if samples:
+        lines.append(
+            f"  latency p50 {latency_percentile(hist, samples, 0.5)}, p99 {latency_percentile(hist, samples, 0.99)},"
+            f" max {max_us / 1000:.2f} ms ({samples} samples)"
+        )
+        for b, count in enumerate(hist):
+            if count:
+                lo = 0 if b == 0 else LATENCY_BUCKET0_US << (b - 1)
+                lines.append(f"    {lo / 1000:7.3f} ms+ {count:8}")
+    return "\n".join(lines)
+
+
+def decode_raw_out(data: bytes) -> str:
+    frames, gaps = struct.unpack_from("<II", data)
+    return f"  {frames} frames received, {gaps} sequence gaps"
+
+
+def decode_quad(data: bytes) -> str:
+    sampler, irqs, avg_cycles, max_cycles, clk_hz = struct.unpack_from("<BIIII", data)
+    name = QUAD_SAMPLERS[sampler] if sampler < len(QUAD_SAMPLERS) else str(sampler)
+    lines = [f"  sampler {name}, {irqs} edge IRQs"]
+    if irqs and avg_cycles:
+        # One IRQ per edge at worst: the handler cost caps the edge rate it can follow
+        lines.append(f"  {avg_cycles} cycles per IRQ (max {max_cycles}), "
+                     f"sustains ~{clk_hz // avg_cycles} edges/s at {clk_hz / 1e6:.0f} MHz "
+                     f"(worst case {clk_hz // max(max_cycles, 1)} edges/s)")
+    if len(data) >= 19:
+        taps, n = data[17], data[18]
+        illegal = struct.unpack_from(f"<{2 * n}I", data, 19)
+        lines.append(f"  glitch filter: {'off' if taps <= 1 else f'majority of {taps}'}")
+        lines.append("  illegal steps (both pins changed; sampling too slow): " + ", ".join(
+            f"m{i} X {illegal[2 * i]} Y {illegal[2 * i + 1]}" for i in range(n)))
+        if len(data) >= 27 + 8 * n:
+            rate_hz, ceiling_hz = struct.unpack_from("<II", data, 19 + 8 * n)
+            now = f"now {rate_hz} Hz, " if rate_hz else ""
+            lines.append(f"  timer sampler: {now}ceiling {ceiling_hz} Hz")
+    return "\n".join(lines)
+
+
+def decode_spi(data: bytes) -> str:
+    present, bursts, bad, lifted = struct.unpack_from("<BIIB", data)
+    found = ", ".join(f"m{i}" for i in range(8) if present & (1 << i)) or "none"
+    up = ", ".join(f"m{i}" for i in range(8) if lifted & (1 << i))
+    lines = [f"  sensors found: {found}", f"  {bursts} motion bursts, {bad} implausible (bus fault)"]
+    if up:
+        lines.append(f"  lifted: {up}")
+    return "\n".join(lines)
+
+
+def decode_cascade(data: bytes) -> str:
+    mode, slot, rx, bad, sent, hops, age_us, age_max_us = struct.unpack_from("<BBIIIBII", data)
+    name = CASCADE_MODES[mode] if mode < len(CASCADE_MODES) else str(mode)
+    lines = [f"  mode {name}" + (f", mice go up from slot {slot}, {sent} frames sent" if mode else "")]
+    if rx or bad:
+        lines.append(f"  {rx} frames from below ({bad} bad checksum), last crossed {hops} link(s), "
+                     f"input age on arrival {age_us} us (max {age_max_us} us)")
+    return "\n".join(lines)
+
+
+def decode_frame(data: bytes) -> str:
+    locked, lead_us, ppm, sofs, locks, intervals, jit_mean, jit_max, late_mean, late_max = \
+        struct.unpack_from("<BHiIIIIIII", data)
+    hist = struct.unpack_from(f"<{(len(data) - 35) // 4}I", data, 35)
+    clock = f"locked to USB SOF ({ppm:+d} ppm, {locks} lock(s))" if locked else "free-running (no SOF)"
+    lines = [f"  clock {clock}, frames {lead_us} us ahead of the SOF, {sofs} SOFs seen"]
+    if intervals:
+        lines.append(f"  interval jitter mean {jit_mean} us, max {jit_max} us; "
+                     f"frame start late mean {late_mean} us, max {late_max} us ({intervals} intervals)")
+        for b, count in enumerate(hist):
+            if count:
+                lo = 0 if b == 0 else FRAME_JITTER0_US << (b - 1)
+                lines.append(f"    {lo:5} us+ {count:8}")
+    return "\n".join(lines)
+
+
+DECODERS = {
+    TAG_INFO: ("Device", decode_info),
+    TAG_LIVENESS: ("Liveness", decode_liveness),
+    TAG_LATENCY: ("Report latency", decode_latency),
+    TAG_RAW_OUT: ("Raw HID input", decode_raw_out),
+    TAG_QUAD: ("Quadrature", decode_quad),
+    TAG_SPI: ("SPI sensors", decode_spi),
+    TAG_CASCADE: ("Cascade link", decode_cascade),
+    TAG_FRAME: ("Frame clock", decode_frame),
+}
+
+
+def print_status(sections: dict) -> None:
+    for tag, data in sections.items():
+        if tag in DECODERS:
+            title, fn = DECODERS[tag]
+            print(f"{title}:\n{fn(data)}")
+        else:
+            print(f"Section 0x{tag:02x}: {data.hex()}")
+
+
+def main() -> None:
+    ap = argparse.ArgumentParser(description="Query amplified mouse status over USB CDC")
+    ap.add_argument("--port", "-p", required=True, metavar="DEV", help="Pico USB serial port (e.g. /dev/ttyACM0)")
+    ap.add_argument("--watch", type=float, metavar="SEC", help="Repeat every SEC seconds until Ctrl+C")
+    ap.add_argument("--reset-latency", action="store_true", help="Clear the latency histogram before querying")
+    args = ap.parse_args()
+
+    try:
+        import serial
+    except ImportError:
+        print("pip install pyserial", file=sys.stderr)
+        raise SystemExit(1)
+
+    with serial.Serial(args.port, 115200, timeout=1) as ser:
+        if args.reset_latency:
+            ser.write(bytes([SYNC1, SYNC2, CMD_PROFILE_RESET]))
+            time.sleep(args.watch or 1.0)
+        try:
+            while True:
+                print_status(read_status(ser))
+                if not args.watch:
+                    break
+                time.sleep(args.watch)
+                print()
+        except KeyboardInterrupt:
+            pass
+
+
+if __name__ == "__main__":
+    main()
@@ -6,9 +6,11 @@ in RAM only (lost on reboot); default is to save to flash.
 
   python3 scripts/send_settings.py --port /dev/ttyACM0
   python3 scripts/send_settings.py --port /dev/cu.usbmodem101 --num-mice 4 --save
+  python3 scripts/send_settings.py --port /dev/ttyACM0 --rotate 1 90 --xform 2 -1 0 0 1
 """
 from pathlib import Path
 import argparse
+import math
 import re
 import sys
 
@@ -19,14 +21,38 @@ LOGIC_MODES = {
     "sum": 0, "average": 1, "max": 2,
     "min": 3, "and": 4, "or": 5, "xor": 6,
     "nand": 7, "nor": 8, "xnor": 9,
+    "fusion": 10,
 }
-INPUT_MODES = {"uart": 0, "quadrature": 1, "both": 2}
-OUTPUT_MODES = {"combined": 0, "separate": 1}
+INPUT_MODES = {"uart": 0, "quadrature": 1, "both": 2, "spi": 3, "usb": 4}
+OUTPUT_MODES = {"combined": 0, "separate": 1, "absolute": 2, "composite": 3, "raw": 4}
+QUAD_SAMPLERS = {"poll": 0, "irq": 1, "timer": 2}
 
 # UART config packet: 0x55 0xCF 0x01 N L I O A Q_lo Q_hi save (8 bytes payload)
 UART_CONFIG_SYNC1 = 0x55
 UART_CONFIG_SYNC2 = 0xCF
 UART_CONFIG_CMD = 0x01
+# Per-mouse transform: 0x55 0xCF 0x02 mouse xx xy yx yy (int16 LE, Q8: 256 = 1.0) save
+UART_CONFIG_CMD_XFORM = 0x02
+XFORM_ONE = 256
+XFORM_MAX = 32767  # settings.c clamps entries to +-32767 (SETTINGS_XFORM_MAX)
+# Acceleration: 0x55 0xCF 0x03 mode window_ms threshold rate(2) max_x100(2) save
+UART_CONFIG_CMD_ACCEL = 0x03
+ACCEL_MODES = {"off": 0, "linear": 1, "exp": 2}
+# Liveness timeout: 0x55 0xCF 0x04 stale_ms(2) save
+UART_CONFIG_CMD_STALE = 0x04
+# Button minimum hold: 0x55 0xCF 0x05 hold_ms save
+UART_CONFIG_CMD_BUTTONS = 0x05
+UART_CONFIG_CMD_QUAD = 0x06
+UART_CONFIG_CMD_QUAD_FILTER = 0x07
+UART_CONFIG_CMD_QUAD_RATE = 0x08
+# Slot sources: 0x55 0xCF 0x09 mask x NUM_MICE_MAX save (slots past the build's max_mice are ignored)
+UART_CONFIG_CMD_SLOT_SOURCES = 0x09
+SOURCES = {"host": 0x01, "uart": 0x01, "quad": 0x02, "quadrature": 0x02, "spi": 0x04, "usb": 0x08, "all": 0x0F}
+# Cascade: 0x55 0xCF 0x0A mode slot save (mode 0 off / head, 1 slots, 2 combined)
+UART_CONFIG_CMD_CASCADE = 0x0A
+CASCADE_MODES = {"off": 0, "slots": 1, "combined": 2}
+CASCADE_SLOTS = 16
+NUM_MICE_MAX = 16   # the most a build can have (max_mice in config.yaml)
 
 
 def load_yaml(path: Path) -> dict:
@@ -66,15 +92,141 @@ def build_packet(num_mice: int, logic_mode: int, input_mode: int, output_mode: i
     ])
 
 
+def build_xform_packet(mouse: int, m, save: bool) -> bytes:
+    """m: (xx, xy, yx, yy) as floats; out_x = xx*dx + xy*dy, out_y = yx*dx + yy*dy."""
+    q = [max(-XFORM_MAX, min(XFORM_MAX, int(round(v * XFORM_ONE)))) & 0xFFFF for v in m]
+    payload = [mouse & 0xFF]
+    for v in q:
+        payload += [v & 0xFF, v >> 8]
+    return bytes([UART_CONFIG_SYNC1, UART_CONFIG_SYNC2, UART_CONFIG_CMD_XFORM] + payload + [1 if save else 0])
+
+
+def build_accel_packet(mode: int, window_ms: int, threshold: int, rate: int, max_gain: float, save: bool) -> bytes:
+    max_x100 = max(100, min(1000, int(round(max_gain * 100))))
+    rate = max(0, min(10000, rate))
+    return bytes([
+        UART_CONFIG_SYNC1, UART_CONFIG_SYNC2, UART_CONFIG_CMD_ACCEL,
+        mode & 0xFF, window_ms & 0xFF, threshold & 0xFF,
+        rate & 0xFF, rate >> 8, max_x100 & 0xFF, max_x100 >> 8,
+        1 if save else 0,
+    ])
+
+
+def build_stale_packet(stale_ms: int, save: bool) -> bytes:
+    stale_ms = max(50, min(60000, stale_ms))
+    return bytes([UART_CONFIG_SYNC1, UART_CONFIG_SYNC2, UART_CONFIG_CMD_STALE,
+                  stale_ms & 0xFF, stale_ms >> 8, 1 if save else 0])
+
+
+def build_buttons_packet(hold_ms: int, save: bool) -> bytes:
+    hold_ms = max(0, min(100, hold_ms))
+    return bytes([UART_CONFIG_SYNC1, UART_CONFIG_SYNC2, UART_CONFIG_CMD_BUTTONS, hold_ms, 1 if save else 0])
+
+
+def build_quad_packet(sampler: int, save: bool) -> bytes:
+    return bytes([UART_CONFIG_SYNC1, UART_CONFIG_SYNC2, UART_CONFIG_CMD_QUAD, sampler, 1 if save else 0])
+
+
+def build_quad_filter_packet(taps: int, save: bool) -> bytes:
+    taps = max(1, min(5, taps))
+    return bytes([UART_CONFIG_SYNC1, UART_CONFIG_SYNC2, UART_CONFIG_CMD_QUAD_FILTER, taps, 1 if save else 0])
+
+
+def build_quad_rate_packet(khz: int, save: bool) -> bytes:
+    khz = max(1, min(50, khz))
+    return bytes([UART_CONFIG_SYNC1, UART_CONFIG_SYNC2, UART_CONFIG_CMD_QUAD_RATE, khz, 1 if save else 0])
+
+
+def build_slot_sources_packet(masks, save: bool) -> bytes:
+    return bytes([UART_CONFIG_SYNC1, UART_CONFIG_SYNC2, UART_CONFIG_CMD_SLOT_SOURCES, *masks, 1 if save else 0])
+
+
+def build_cascade_packet(mode: int, slot: int, save: bool) -> bytes:
+    return bytes([UART_CONFIG_SYNC1, UART_CONFIG_SYNC2, UART_CONFIG_CMD_CASCADE, mode, slot, 1 if save else 0])
+
+
+def parse_slot_sources(spec: str) -> list:
+    """'0-2=quad,3-5=host+usb' -> per-slot source masks; slots not named take every source."""
+    masks = [SOURCES["all"]] * NUM_MICE_MAX
+    for part in spec.replace(" ", "").split(","):
+        if not part:
+            continue
+        slots, _, names = part.partition("=")
+        lo, _, hi = slots.partition("-")
+        try:
+            lo, hi = int(lo), int(hi or lo)
+            mask = 0
+            for name in names.split("+"):
+                mask |= SOURCES[name.lower()]
+        except (ValueError, KeyError):
+            raise SystemExit(f"bad slot_sources entry '{part}': use SLOTS=SOURCE[+SOURCE], sources {', '.join(SOURCES)}")
+        if lo < 0 or hi >= NUM_MICE_MAX or lo > hi:
+            raise SystemExit(f"slot index must be 0-{NUM_MICE_MAX - 1}")
+        for i in range(lo, hi + 1):
+            masks[i] = mask
+    return masks
+
+
+def rotation_matrix(deg: float, gain: float = 1.0):
+    """Counter-clockwise rotation (screen Y points down, so positive deg turns right-to-up)."""
+    c, s = math.cos(math.radians(deg)) * gain, math.sin(math.radians(deg)) * gain
+    return (c, s, -s, c)
+
+
+def collect_xforms(cfg: dict, args) -> dict:
+    """Per-mouse matrices from config.yaml (mouseN_xform / mouseN_rotate) and CLI, CLI last."""
+    out = {}
+    for i in range(NUM_MICE_MAX):
+        if f"mouse{i}_rotate" in cfg:
+            out[i] = rotation_matrix(float(cfg[f"mouse{i}_rotate"]))
+        if f"mouse{i}_xform" in cfg:
+            vals = [float(v) for v in str(cfg[f"mouse{i}_xform"]).split()]
+            if len(vals) != 4:
+                raise SystemExit(f"mouse{i}_xform needs 4 values: xx xy yx yy")
+            out[i] = tuple(vals)
+    for mouse, deg in args.rotate or []:
+        out[int(mouse)] = rotation_matrix(deg)
+    for vals in args.xform or []:
+        out[int(vals[0])] = tuple(vals[1:])
+    for i in out:
+        if i < 0 or i >= NUM_MICE_MAX:
+            raise SystemExit(f"mouse index must be 0-{NUM_MICE_MAX - 1}")
+    return out
+
+
 def main() -> None:
     ap = argparse.ArgumentParser(description="Send settings to Pico over UART (setting file on device)")
     ap.add_argument("--port", "-p", required=True, metavar="DEV", help="Serial port (e.g. /dev/ttyACM0 or /dev/tty.usbmodem101)")
-    ap.add_argument("--num-mice", type=int, metavar="N", help="Number of mice (2-6)")
+    ap.add_argument("--num-mice", type=int, metavar="N", help="Number of mice (2 to the build's max_mice)")
     ap.add_argument("--logic-mode", choices=list(LOGIC_MODES), metavar="MODE", help="Logic mode")
     ap.add_argument("--input-mode", choices=list(INPUT_MODES), metavar="MODE", help="Input mode")
-    ap.add_argument("--output-mode", choices=list(OUTPUT_MODES), metavar="MODE", help="Output: combined (1 mouse) or separate (6 mice)")
+    ap.add_argument("--output-mode", choices=list(OUTPUT_MODES), metavar="MODE", help="Output: combined (1 mouse), separate (6 mice), absolute (multi-touch, 1 contact per mouse) composite (6 mice on 1 interface) or raw (vendor report, all mice)")
     ap.add_argument("--amplify", type=float, metavar="F", help="Amplification factor")
     ap.add_argument("--quad-scale", type=int, metavar="N", help="Quadrature scale")
+    ap.add_argument("--xform", type=float, nargs=5, action="append", metavar=("MOUSE", "XX", "XY", "YX", "YY"),
+                    help="Per-mouse 2x2 transform (gain, rotation, swap, invert); repeatable")
+    ap.add_argument("--rotate", type=float, nargs=2, action="append", metavar=("MOUSE", "DEG"),
+                    help="Rotate one mouse's motion by DEG degrees; repeatable")
+    ap.add_argument("--accel-mode", choices=list(ACCEL_MODES), metavar="MODE", help="Acceleration curve: off, linear, exp")
+    ap.add_argument("--accel-window", type=int, metavar="MS", help="Speed window in ms (4-64)")
+    ap.add_argument("--accel-threshold", type=int, metavar="N", help="Speed (counts per window) where acceleration starts")
+    ap.add_argument("--accel-rate", type=int, metavar="N", help="Curve steepness in thousandths per count")
+    ap.add_argument("--accel-max", type=float, metavar="F", help="Maximum acceleration gain (1.0-10.0)")
+    ap.add_argument("--stale-ms", type=int, metavar="MS", help="Mouse counts as dead/idle after MS without motion (default 1000)")
+    ap.add_argument("--button-min-hold", type=int, metavar="MS", help="Report each button state for at least MS (0-100, default 0)")
+    ap.add_argument("--quad-sampler", choices=list(QUAD_SAMPLERS), metavar="MODE",
+                    help="Quadrature sampling: poll (main loop), irq (GPIO edge interrupts) or timer (adaptive rate)")
+    ap.add_argument("--quad-filter", type=int, choices=[1, 3, 5], metavar="N",
+                    help="Quadrature glitch filter: each pin is the majority of N samples (1 = off, 3 or 5)")
+    ap.add_argument("--quad-rate-max", type=int, metavar="KHZ",
+                    help="Highest sample rate of the timer sampler in kHz (1-50, default 20)")
+    ap.add_argument("--slot-sources", metavar="SPEC",
+                    help="Which inputs feed which mouse slots, e.g. 0-2=quad,3-5=host (sources: host, quad, spi, usb, all; "
+                         "slots not named take all)")
+    ap.add_argument("--cascade", choices=list(CASCADE_MODES), metavar="MODE",
+                    help="Send this Pico's mice up the UART to another Pico: off (head of the chain), "
+                         "slots (one upstream slot per mouse) or combined (one slot for all)")
+    ap.add_argument("--cascade-slot", type=int, metavar="N", help="First upstream slot this Pico's mice take (0-15)")
     ap.add_argument("--no-save", action="store_true", help="Apply in RAM only (do not save to flash)")
     ap.add_argument("--baud", type=int, default=115200, help="UART baud (default 115200)")
     args = ap.parse_args()
@@ -99,15 +251,83 @@ def main() -> None:
     amplify = args.amplify if args.amplify is not None else float(cfg.get("amplify", 1.0))
     quad_scale = args.quad_scale if args.quad_scale is not None else int(cfg.get("quad_scale", 2))
 
-    if num_mice < 2 or num_mice > 6:
-        raise SystemExit("num_mice must be 2-6")
+    if num_mice < 2 or num_mice > NUM_MICE_MAX:
+        raise SystemExit(f"num_mice must be 2-{NUM_MICE_MAX}")
     if quad_scale < 1:
         quad_scale = 1
 
+    xforms = collect_xforms(cfg, args)
+    stale_ms = args.stale_ms if args.stale_ms is not None else cfg.get("stale_ms")
+    button_hold = args.button_min_hold if args.button_min_hold is not None else cfg.get("button_min_hold_ms")
+    quad_sampler = args.quad_sampler if args.quad_sampler is not None else cfg.get("quad_sampler")
+    if quad_sampler is not None:
+        quad_sampler = QUAD_SAMPLERS.get(str(quad_sampler).lower(), 0)
+    quad_filter = args.quad_filter if args.quad_filter is not None else cfg.get("quad_filter")
+    quad_rate_max = args.quad_rate_max if args.quad_rate_max is not None else cfg.get("quad_rate_max_khz")
+    slot_sources = args.slot_sources if args.slot_sources is not None else cfg.get("slot_sources")
+    if slot_sources is not None:
+        slot_sources = parse_slot_sources(str(slot_sources))
+    cascade = args.cascade if args.cascade is not None else cfg.get("cascade")
+    cascade_slot = args.cascade_slot if args.cascade_slot is not None else cfg.get("cascade_slot")
+    if cascade is not None or cascade_slot is not None:
+        cascade = CASCADE_MODES.get(str(cascade or "off").lower())
+        if cascade is None:
+            raise SystemExit(f"cascade must be {', '.join(CASCADE_MODES)}")
+        cascade_slot = int(cascade_slot or 0)
+        if cascade_slot < 0 or cascade_slot >= CASCADE_SLOTS:
+            raise SystemExit(f"cascade_slot must be 0-{CASCADE_SLOTS - 1}")
+    accel = None
+    if "accel_mode" in cfg or args.accel_mode is not None:
+        accel = (
+            ACCEL_MODES[args.accel_mode] if args.accel_mode is not None else ACCEL_MODES.get(
+                str(cfg.get("accel_mode", "off")).lower(), 0
+            ),
+            args.accel_window if args.accel_window is not None else int(cfg.get("accel_window_ms", 20)),
+            args.accel_threshold if args.accel_threshold is not None else int(cfg.get("accel_threshold", 4)),
+            args.accel_rate if args.accel_rate is not None else int(cfg.get("accel_rate", 50)),
+            args.accel_max if args.accel_max is not None else float(cfg.get("accel_max", 4.0)),
+        )
+
     packet = build_packet(num_mice, logic_mode, input_mode, output_mode, amplify, quad_scale, save=not args.no_save)
     with serial.Serial(args.port, args.baud, timeout=1) as ser:
         ser.write(packet)
+        for mouse, m in sorted(xforms.items()):
+            ser.write(build_xform_packet(mouse, m, save=not args.no_save))
+        if accel is not None:
+            ser.write(build_accel_packet(*accel, save=not args.no_save))
+        if stale_ms is not None:
+            ser.write(build_stale_packet(stale_ms, save=not args.no_save))
+        if button_hold is not None:
+            ser.write(build_buttons_packet(int(button_hold), save=not args.no_save))
+        if quad_sampler is not None:
+            ser.write(build_quad_packet(quad_sampler, save=not args.no_save))
+        if quad_filter is not None:
+            ser.write(build_quad_filter_packet(int(quad_filter), save=not args.no_save))
+        if quad_rate_max is not None:
+            ser.write(build_quad_rate_packet(int(quad_rate_max), save=not args.no_save))
+        if slot_sources is not None:
+            ser.write(build_slot_sources_packet(slot_sources, save=not args.no_save))
+        if cascade is not None:
+            ser.write(build_cascade_packet(cascade, cascade_slot, save=not args.no_save))
     print(f"Sent settings to {args.port}: num_mice={num_mice} logic={logic_mode} input={input_mode} output={output_mode} amplify={amplify} quad_scale={quad_scale} save={not args.no_save}")
+    for mouse, m in sorted(xforms.items()):
+        print(f"  mouse {mouse} xform: " + " ".join(f"{v:.3f}" for v in m))
+    if accel is not None:
+        print(f"  accel mode={accel[0]} window={accel[1]}ms threshold={accel[2]} rate={accel[3]} max={accel[4]}")
+    if stale_ms is not None:
+        print(f"  stale_ms={stale_ms}")
+    if button_hold is not None:
+        print(f"  button_min_hold_ms={button_hold}")
+    if quad_sampler is not None:
+        print(f"  quad_sampler={quad_sampler}")
+    if quad_filter is not None:
+        print(f"  quad_filter={quad_filter}")
+    if quad_rate_max is not None:
+        print(f"  quad_rate_max_khz={quad_rate_max}")
+    if slot_sources is not None:
+        print("  slot_sources=" + " ".join(f"0x{m:02x}" for m in slot_sources))
+    if cascade is not None:
+        print(f"  cascade={cascade} cascade_slot={cascade_slot}")
 
 
 if __name__ == "__main__":
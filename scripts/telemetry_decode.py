@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""
+Record the Pico's telemetry stream (one record per report frame) from its USB
+serial (CDC) port and write it as columns for analysis: CSV by default, or a
+NumPy .npz (one array per column) if the output name ends in .npz.
+
+  python3 scripts/telemetry_decode.py --port /dev/ttyACM0 --duration 10 -o run.csv
+  python3 scripts/telemetry_decode.py --port /dev/ttyACM0 -o run.npz        # needs numpy
+  python3 scripts/telemetry_decode.py --input capture.bin -o run.csv        # decode a raw capture
+
+Columns: t_us, dropped, num_mice, buttons, out_dx, out_dy, m0_dx, m0_dy, ... m5_dy.
+"dropped" counts records the Pico discarded because the host was not reading fast
+enough; a jump between rows means frames are missing there.
+
+Requires: pyserial (for --port).
+"""
+import argparse
+import csv
+import struct
+import sys
+import time
+
+SYNC1 = 0x55
+SYNC2 = 0xCF
+CMD_TELEMETRY = 0x12
+TELEMETRY_TAG = 0xA0
+NUM_MICE = 6
+HEADER = bytes([SYNC1, SYNC2, TELEMETRY_TAG])
+PAYLOAD = struct.Struct("<IIBB" + "hh" * NUM_MICE + "hh")
+COLUMNS = ["t_us", "dropped", "num_mice", "buttons", "out_dx", "out_dy"] + [
+    f"m{i}_{axis}" for i in range(NUM_MICE) for axis in ("dx", "dy")
+]
+
+
+def decode(buf: bytes):
+    """Yield rows (in COLUMNS order) from a byte stream; returns leftover bytes via StopIteration value."""
+    pos = 0
+    while True:
+        start = buf.find(HEADER, pos)
+        if start < 0 or start + len(HEADER) + PAYLOAD.size > len(buf):
+            return buf[start if start >= 0 else max(0, len(buf) - 2):]
+        t, dropped, n, buttons, *rest = PAYLOAD.unpack_from(buf, start + len(HEADER))
+        raw, out = rest[:2 * NUM_MICE], rest[2 * NUM_MICE:]
+        yield [t, dropped, n, buttons, out[0], out[1], *raw]
+        pos = start + len(HEADER) + PAYLOAD.size
+
+
+def decode_all(buf: bytes, rows: list) -> bytes:
+    gen = decode(buf)
+    while True:
+        try:
+            rows.append(next(gen))
+        except StopIteration as stop:
+            return stop.value or b""
+
+
+def write_output(path: str, rows: list) -> None:
+    if path.endswith(".npz"):
+        try:
+            import numpy as np
+        except ImportError:
+            raise SystemExit("numpy is needed for .npz output (pip install numpy)")
+        cols = list(zip(*rows)) if rows else [[] for _ in COLUMNS]
+        np.savez(path, **{name: np.asarray(col, dtype=np.int64) for name, col in zip(COLUMNS, cols)})
+    else:
+        with open(path, "w", newline="") as f:
+            w = csv.writer(f)
+            w.writerow(COLUMNS)
+            w.writerows(rows)
+
+
+def capture(port: str, duration: float) -> list:
+    try:
+        import serial
+    except ImportError:
+        print("pip install pyserial", file=sys.stderr)
+        raise SystemExit(1)
+    rows = []
+    pending = b""
+    with serial.Serial(port, 115200, timeout=0.1) as ser:
+        ser.write(bytes([SYNC1, SYNC2, CMD_TELEMETRY, 1]))
+        start = time.monotonic()
+        try:
+            while not duration or time.monotonic() - start < duration:
+                pending = decode_all(pending + ser.read(4096), rows)
+        except KeyboardInterrupt:
+            pass
+        finally:
+            ser.write(bytes([SYNC1, SYNC2, CMD_TELEMETRY, 0]))
+    return rows
+
+
+def main() -> None:
+    ap = argparse.ArgumentParser(description="Capture and decode amplified mouse telemetry")
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument("--port", "-p", metavar="DEV", help="Pico USB serial port (e.g. /dev/ttyACM0)")
+    src.add_argument("--input", "-i", metavar="FILE", help="Decode a raw byte capture instead")
+    ap.add_argument("--duration", type=float, default=0, help="Capture for N seconds (0 = until Ctrl+C)")
+    ap.add_argument("--output", "-o", default="telemetry.csv", help="Output file (.csv or .npz)")
+    args = ap.parse_args()
+
+    if args.input:
+        with open(args.input, "rb") as f:
+            rows = []
+            decode_all(f.read(), rows)
+    else:
+        rows = capture(args.port, args.duration)
+
+    write_output(args.output, rows)
+    dropped = rows[-1][1] - rows[0][1] if rows else 0
+    print(f"{len(rows)} records -> {args.output} ({dropped} dropped by the device during capture)")
+
+
+if __name__ == "__main__":
+    main()
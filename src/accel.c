@@ -0,0 +1,80 @@
+/**
+ * Pointer acceleration curve (see accel.h). No Pico SDK dependencies.
+ */
+#include "accel.h"
+#include <math.h>
+#include <string.h>
+
+float accel_eval(const settings_t *s, int speed) {
+  float over = (float)(speed - (int)s->accel_threshold);
+  float max_gain = (float)s->accel_max_x100 / 100.0f;
+  float k = (float)s->accel_rate / 1000.0f;
+  float g = 1.0f;
+  if (over <= 0.0f)
+    return 1.0f;
+  switch (s->accel_mode) {
+    case SETTINGS_ACCEL_LINEAR:
+      g = 1.0f + k * over;
+      break;
+    case SETTINGS_ACCEL_EXP:
+      /* Saturating exponential: slope (max-1)*k at the threshold, approaches max */
+      g = 1.0f + (max_gain - 1.0f) * (1.0f - expf(-k * over));
+      break;
+    default:
+      return 1.0f;
+  }
+  return g > max_gain ? max_gain : g;
+}
+
+void accel_build(accel_t *a, const settings_t *s, uint32_t version) {
+  for (int v = 0; v < ACCEL_LUT_SIZE; v++) {
+    float g = accel_eval(s, v) * 256.0f + 0.5f;
+    a->gain_q8[v] = g > 65535.0f ? 65535 : (uint16_t)g;
+  }
+  a->version = version;
+  a->window_ms = s->accel_window_ms;
+  memset(a->hist_ms, 0, sizeof(a->hist_ms));
+  memset(a->hist_mag, 0, sizeof(a->hist_mag));
+  a->hist_pos = 0;
+  a->res[0] = a->res[1] = 0;
+}
+
+/* Cheap Euclidean magnitude estimate: max + min/2 (within ~12%). */
+static uint16_t magnitude(int32_t dx, int32_t dy) {
+  uint32_t ax = (uint32_t)(dx < 0 ? -dx : dx);
+  uint32_t ay = (uint32_t)(dy < 0 ? -dy : dy);
+  uint32_t m = ax > ay ? ax + (ay >> 1) : ay + (ax >> 1);
+  return m > 0xFFFF ? 0xFFFF : (uint16_t)m;
+}
+
+static int32_t clamp_in(int32_t v) {
+  if (v > ACCEL_IN_MAX) return ACCEL_IN_MAX;
+  if (v < -ACCEL_IN_MAX) return -ACCEL_IN_MAX;
+  return v;
+}
+
+void accel_apply(accel_t *a, int32_t *dx, int32_t *dy, uint32_t now_ms) {
+  if (*dx == 0 && *dy == 0)
+    return;
+  *dx = clamp_in(*dx);
+  *dy = clamp_in(*dy);
+  /* Only moving reports are recorded; idle time simply ages them out */
+  a->hist_ms[a->hist_pos] = now_ms;
+  a->hist_mag[a->hist_pos] = magnitude(*dx, *dy);
+  a->hist_pos = (uint8_t)((a->hist_pos + 1) % ACCEL_HIST_LEN);
+
+  /* Speed = counts moved within the last window_ms */
+  uint32_t speed = 0;
+  for (int i = 0; i < ACCEL_HIST_LEN; i++)
+    if (now_ms - a->hist_ms[i] < a->window_ms)
+      speed += a->hist_mag[i];
+  if (speed >= ACCEL_LUT_SIZE) speed = ACCEL_LUT_SIZE - 1;
+
+  int32_t g = a->gain_q8[speed];
+  int32_t ox = *dx * g + a->res[0];
+  int32_t oy = *dy * g + a->res[1];
+  *dx = ox >> 8;
+  *dy = oy >> 8;
+  a->res[0] = ox - *dx * 256;
+  a->res[1] = oy - *dy * 256;
+}
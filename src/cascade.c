@@ -0,0 +1,111 @@
+/**
+ * Cascade link frames (see cascade.h). No Pico SDK dependencies.
+ */
+#include "cascade.h"
+#include <string.h>
+
+void cascade_tx_reset(cascade_tx_t *t) {
+  memset(t, 0, sizeof(*t));
+}
+
+static bool slot_pending(const cascade_acc_t *a) {
+  return a->dx != 0 || a->dy != 0 || a->wheel != 0 || a->pan != 0 || a->buttons != a->sent_buttons;
+}
+
+void cascade_tx_add(cascade_tx_t *t, int slot, uint8_t buttons, int32_t dx, int32_t dy,
+                    int32_t wheel, int32_t pan, uint32_t origin_us, uint8_t hops) {
+  if (slot < 0 || slot >= CASCADE_SLOTS) return;
+  cascade_acc_t *a = &t->acc[slot];
+  a->dx += dx;
+  a->dy += dy;
+  a->wheel += wheel;
+  a->pan += pan;
+  bool changed = dx != 0 || dy != 0 || wheel != 0 || pan != 0 || buttons != a->buttons;
+  a->buttons = buttons;
+  if (!changed) return;
+  if (!t->waiting || (int32_t)(origin_us - t->oldest_us) < 0)
+    t->oldest_us = origin_us;
+  t->waiting = true;
+  if (hops > t->hops)
+    t->hops = hops;
+}
+
+/* Take up to one int16 of *v. */
+static int16_t take_s16(int32_t *v) {
+  int32_t d = *v;
+  if (d > 32767) d = 32767;
+  if (d < -32768) d = -32768;
+  *v -= d;
+  return (int16_t)d;
+}
+
+static uint8_t *put_record(uint8_t *p, uint8_t slot, uint8_t buttons, int16_t a, int16_t b) {
+  p[0] = slot;
+  p[1] = buttons;
+  p[2] = (uint8_t)a;
+  p[3] = (uint8_t)((uint16_t)a >> 8);
+  p[4] = (uint8_t)b;
+  p[5] = (uint8_t)((uint16_t)b >> 8);
+  return p + CASCADE_RECORD_LEN;
+}
+
+int cascade_tx_frame(cascade_tx_t *t, uint8_t *out, uint32_t now_us) {
+  if (!t->waiting) return 0;
+  uint8_t *p = out + CASCADE_HEADER_LEN;
+  int count = 0;
+  bool rest = false;
+  for (int i = 0; i < CASCADE_SLOTS; i++) {
+    cascade_acc_t *a = &t->acc[i];
+    if (!slot_pending(a)) continue;
+    if (a->dx != 0 || a->dy != 0 || a->buttons != a->sent_buttons || (a->wheel == 0 && a->pan == 0)) {
+      int16_t dx = take_s16(&a->dx), dy = take_s16(&a->dy);
+      p = put_record(p, (uint8_t)i, a->buttons, dx, dy);
+      count++;
+    }
+    if (a->wheel != 0 || a->pan != 0) {
+      int16_t wh = take_s16(&a->wheel), pan = take_s16(&a->pan);
+      p = put_record(p, (uint8_t)(i | CASCADE_SCROLL), a->buttons, wh, pan);
+      count++;
+    }
+    a->sent_buttons = a->buttons;
+    rest |= slot_pending(a);
+  }
+
+  uint32_t age = now_us - t->oldest_us;
+  out[0] = CASCADE_SYNC;
+  out[1] = (uint8_t)count;
+  out[2] = (uint8_t)(t->hops < 0xFF ? t->hops + 1 : 0xFF);
+  if (age > CASCADE_AGE_MAX) age = CASCADE_AGE_MAX;
+  out[3] = (uint8_t)age;
+  out[4] = (uint8_t)(age >> 8);
+  int len = CASCADE_LEN(count);
+  uint8_t x = 0;
+  for (int k = 1; k < len - 1; k++)
+    x ^= out[k];
+  out[len - 1] = x;
+
+  if (!rest) {   /* else what is left keeps the (older) stamp */
+    t->waiting = false;
+    t->hops = 0;
+  }
+  return len;
+}
+
+bool cascade_check(const uint8_t *f, int len) {
+  if (len < CASCADE_LEN(0) || f[0] != CASCADE_SYNC || f[1] > CASCADE_RECORDS_MAX ||
+      len != CASCADE_LEN(f[1]))
+    return false;
+  uint8_t x = 0;
+  for (int k = 1; k < len - 1; k++)
+    x ^= f[k];
+  return x == f[len - 1];
+}
+
+void cascade_record(const uint8_t *f, int k, cascade_record_t *r) {
+  const uint8_t *p = f + CASCADE_HEADER_LEN + k * CASCADE_RECORD_LEN;
+  r->slot = p[0] & CASCADE_SLOT_MASK;
+  r->scroll = (p[0] & CASCADE_SCROLL) != 0;
+  r->buttons = p[1];
+  r->a = (int16_t)((uint16_t)p[2] | ((uint16_t)p[3] << 8));
+  r->b = (int16_t)((uint16_t)p[4] | ((uint16_t)p[5] << 8));
+}
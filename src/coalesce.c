@@ -0,0 +1,64 @@
+/**
+ * Report coalescing (see coalesce.h). No Pico SDK dependencies.
+ */
+#include "coalesce.h"
+#include <string.h>
+
+static int32_t sat(int32_t v, int32_t lim) {
+  if (v > lim) return lim;
+  if (v < -lim - 1) return -lim - 1;
+  return v;
+}
+
+void coalesce_reset(coalesce_t *c) {
+  memset(c, 0, sizeof(*c));
+}
+
+void coalesce_add(coalesce_t *c, int32_t dx, int32_t dy, int32_t wheel, int32_t pan) {
+  c->dx = sat(c->dx + dx, COALESCE_MAX);
+  c->dy = sat(c->dy + dy, COALESCE_MAX);
+  c->wheel = sat(c->wheel + wheel, COALESCE_MAX);
+  c->pan = sat(c->pan + pan, COALESCE_MAX);
+}
+
+void coalesce_buttons(coalesce_t *c, uint8_t level) {
+  uint8_t newest = c->queued > 0 ? c->queue[c->queued - 1] : c->sent;
+  if (level == newest) return;
+  if (c->queued < COALESCE_BUTTON_QUEUE)
+    c->queue[c->queued++] = level;
+  else if (c->queue[COALESCE_BUTTON_QUEUE - 2] == level)
+    c->queued--;   /* full: this edge undoes the newest one, drop the pair */
+  else
+    c->queue[COALESCE_BUTTON_QUEUE - 1] = level;
+}
+
+static bool button_due(const coalesce_t *c, uint32_t now_ms, uint8_t min_hold_ms) {
+  return c->queued > 0 && now_ms - c->sent_ms >= min_hold_ms;
+}
+
+bool coalesce_pending(const coalesce_t *c, uint32_t now_ms, uint8_t min_hold_ms) {
+  return c->dx != 0 || c->dy != 0 || c->wheel != 0 || c->pan != 0 || button_due(c, now_ms, min_hold_ms);
+}
+
+bool coalesce_take(coalesce_t *c, coalesce_report_t *r, uint32_t now_ms, uint8_t min_hold_ms) {
+  if (!coalesce_pending(c, now_ms, min_hold_ms)) return false;
+  int32_t dx = sat(c->dx, 127), dy = sat(c->dy, 127);
+  int32_t wh = sat(c->wheel, 32766), pan = sat(c->pan, 32766);  /* ±32767 per descriptor */
+  c->dx -= dx;
+  c->dy -= dy;
+  c->wheel -= wh;
+  c->pan -= pan;
+  r->dx = (int8_t)dx;
+  r->dy = (int8_t)dy;
+  r->wheel = (int16_t)wh;
+  r->pan = (int16_t)pan;
+  /* At most one button change per report, so the host sees every edge */
+  if (button_due(c, now_ms, min_hold_ms)) {
+    c->sent = c->queue[0];
+    c->sent_ms = now_ms;
+    c->queued--;
+    memmove(c->queue, c->queue + 1, c->queued);
+  }
+  r->buttons = c->sent;
+  return true;
+}
@@ -0,0 +1,22 @@
+/**
+ * Reciprocal division setup (see fastdiv.h). No Pico SDK dependencies.
+ */
+#include "fastdiv.h"
+
+/* With mul = ceil(2^k / d) and e = mul * d - 2^k, (n * mul) >> k == n / d for all
+ * 0 <= n <= N as long as e * N < 2^k. Take the smallest such k: that keeps mul, and
+ * so n * mul, as small as possible (n * mul < 2^32 for every d and n <= N). */
+void fastdiv_init(fastdiv_t *f, uint16_t d) {
+  if (d == 0) d = 1;
+  f->div = d;
+  for (uint8_t k = 0; k < 48; k++) {
+    uint64_t p = (uint64_t)1 << k;
+    uint64_t mul = (p + d - 1) / d;
+    uint64_t e = mul * d - p;
+    if (e * FASTDIV_N_MAX < p) {
+      f->mul = (uint32_t)mul;
+      f->shift = k;
+      return;
+    }
+  }
+}
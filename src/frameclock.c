@@ -0,0 +1,126 @@
+/**
+ * USB SOF-locked report frame clock (see frameclock.h). No Pico SDK dependencies.
+ */
+#include "frameclock.h"
+#include <string.h>
+
+#define PERIOD_NOMINAL_Q8  (FRAMECLOCK_SOF_US << 8)
+#define PERIOD_SPAN_Q8     (PERIOD_NOMINAL_Q8 / 1000 * FRAMECLOCK_PPM_MAX / 1000)
+
+void frameclock_init(frameclock_t *c, uint32_t tick_us, uint32_t lead_us, uint32_t now_us) {
+  memset(c, 0, sizeof(*c));
+  c->tick_us = tick_us;
+  c->ticks_sofs = tick_us / FRAMECLOCK_SOF_US;
+  if (c->ticks_sofs == 0) c->ticks_sofs = 1;
+  c->lead_us = lead_us;
+  c->period_q8 = PERIOD_NOMINAL_Q8;
+  c->next_us = now_us + tick_us;
+}
+
+/* Estimated local time of SOF n (within a few thousand SOFs of the reference). */
+static uint32_t sof_time(const frameclock_t *c, uint32_t n) {
+  return c->ref_us + (uint32_t)(((int32_t)(n - c->ref_frame) * c->period_q8) >> 8);
+}
+
+static uint32_t frame_due(const frameclock_t *c, uint32_t n) {
+  return sof_time(c, n) - c->lead_us;
+}
+
+void frameclock_sof(frameclock_t *c, uint32_t fn, uint32_t now_us) {
+  fn &= 0x7FF;
+  if (!c->have_sof || now_us - c->last_seen_us > FRAMECLOCK_LOST_US) {
+    /* First SOF, or the first after a gap: start over from this one */
+    c->have_sof = true;
+    c->locked = false;
+    c->frame = fn;
+    c->ref_frame = fn;
+    c->ref_us = now_us;
+    c->period_q8 = PERIOD_NOMINAL_Q8;
+    c->win_min = 0;
+    c->win_n = 0;
+  } else {
+    c->frame += (fn - c->last_fn) & 0x7FF;
+  }
+  c->last_fn = (uint16_t)fn;
+  c->last_seen_us = now_us;
+  c->sofs++;
+
+  /* Every sighting is the true SOF plus some delay, never minus: keep the earliest */
+  int32_t e = (int32_t)(now_us - sof_time(c, c->frame));
+  if (c->win_n == 0 || e < c->win_min)
+    c->win_min = e;
+  if (++c->win_n < FRAMECLOCK_WINDOW) return;
+
+  /* Window done: move the reference here, and steer the period by the phase it
+   * slipped (a quarter of it per window, so sighting noise barely moves it) */
+  uint32_t ref_us = sof_time(c, c->frame) + (uint32_t)c->win_min;
+  if (c->locked) {
+    c->period_q8 += c->win_min * 256 / (FRAMECLOCK_WINDOW * 4);
+    if (c->period_q8 > PERIOD_NOMINAL_Q8 + PERIOD_SPAN_Q8) c->period_q8 = PERIOD_NOMINAL_Q8 + PERIOD_SPAN_Q8;
+    if (c->period_q8 < PERIOD_NOMINAL_Q8 - PERIOD_SPAN_Q8) c->period_q8 = PERIOD_NOMINAL_Q8 - PERIOD_SPAN_Q8;
+  }
+  c->ref_frame = c->frame;
+  c->ref_us = ref_us;
+  c->win_n = 0;
+  if (!c->locked) {
+    /* Hand over from the free-running clock at the first SOF-aligned frame that
+     * is not much sooner than the free-running one would have been */
+    uint32_t n = c->frame + 1;
+    n += (c->phase + c->ticks_sofs - n % c->ticks_sofs) % c->ticks_sofs;
+    while ((int32_t)(frame_due(c, n) - (c->next_us - c->tick_us / 2)) < 0)
+      n += c->ticks_sofs;
+    c->next_frame = n;
+    c->next_us = frame_due(c, n);
+    c->locked = true;
+    c->locks++;
+  }
+}
+
+void frameclock_polled(frameclock_t *c) {
+  if (!c->locked || c->ticks_sofs == 1) return;
+  uint32_t phase = c->frame % c->ticks_sofs;
+  if (phase != c->poll_phase) {
+    c->poll_phase = phase;
+    c->poll_run = 0;
+  }
+  if (++c->poll_run < FRAMECLOCK_POLLS || phase == c->phase) return;
+  /* Reports wait a whole SOF period or more for the poll: move the frames to the
+   * polled SOFs (the next frame comes late by the difference, once) */
+  c->phase = phase;
+  c->next_frame += (phase + c->ticks_sofs - c->next_frame % c->ticks_sofs) % c->ticks_sofs;
+}
+
+bool frameclock_due(frameclock_t *c, uint32_t now_us, uint32_t *late_us) {
+  if (c->have_sof && now_us - c->last_seen_us > FRAMECLOCK_LOST_US) {
+    c->have_sof = false;   /* suspended or unplugged: free-run from the last frame time */
+    c->locked = false;
+  }
+  if (c->locked)
+    c->next_us = frame_due(c, c->next_frame);   /* follows every phase/period update */
+  int32_t d = (int32_t)(now_us - c->next_us);
+  if (d < 0) return false;
+  *late_us = (uint32_t)d;
+
+  if (c->locked) {
+    do
+      c->next_frame += c->ticks_sofs;
+    while ((int32_t)(now_us - frame_due(c, c->next_frame)) >= 0);
+    c->next_us = frame_due(c, c->next_frame);
+  } else {
+    c->next_us += c->tick_us;
+    if ((int32_t)(now_us - c->next_us) >= 0)
+      c->next_us = now_us + c->tick_us;
+  }
+  return true;
+}
+
+uint32_t frameclock_wait_us(frameclock_t *c, uint32_t now_us) {
+  if (c->locked)
+    c->next_us = frame_due(c, c->next_frame);
+  int32_t d = (int32_t)(c->next_us - now_us);
+  return d > 0 ? (uint32_t)d : 0;
+}
+
+int32_t frameclock_ppm(const frameclock_t *c) {
+  return c->locked ? (c->period_q8 - PERIOD_NOMINAL_Q8) * 125 / 32 : 0;
+}
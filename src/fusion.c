@@ -0,0 +1,85 @@
+/**
+ * Velocity-weighted sensor fusion (see fusion.h). No Pico SDK dependencies.
+ */
+#include "fusion.h"
+#include <string.h>
+
+static int32_t iabs(int32_t v) {
+  return v < 0 ? -v : v;
+}
+
+void fusion_reset(fusion_t *f) {
+  memset(f, 0, sizeof(*f));
+  for (int i = 0; i < FUSION_MAX_INPUTS; i++)
+    f->noise_q8[i] = FUSION_NOISE_FLOOR;
+}
+
+uint32_t fusion_dropped(const fusion_t *f, int n) {
+  uint32_t m = 0;
+  for (int i = 0; i < n && i < FUSION_MAX_INPUTS; i++)
+    if (f->stuck[i] >= FUSION_DROP_FRAMES)
+      m |= 1u << i;
+  return m;
+}
+
+void fusion_step(fusion_t *f, const int32_t *dx, const int32_t *dy, int n,
+                 uint32_t live_mask, int32_t *out_x, int32_t *out_y) {
+  if (n > FUSION_MAX_INPUTS) n = FUSION_MAX_INPUTS;
+  int32_t speed = iabs(f->vel_q8[0]) + iabs(f->vel_q8[1]);
+
+  /* Confidence weights: inverse of recent noise, zero for dropped inputs */
+  uint32_t w[FUSION_MAX_INPUTS];
+  uint32_t wsum = 0;
+  for (int i = 0; i < n; i++) {
+    bool zero = dx[i] == 0 && dy[i] == 0;
+    if (!zero || speed < FUSION_DROP_SPEED)
+      f->stuck[i] = 0;
+    else if (f->stuck[i] < 255)
+      f->stuck[i]++;
+    bool usable = (live_mask & (1u << i)) && f->stuck[i] < FUSION_DROP_FRAMES;
+    w[i] = usable ? (1u << 20) / (uint32_t)f->noise_q8[i] : 0;
+    wsum += w[i];
+  }
+
+  /* Weighted mean of the inputs (Q8); weights normalised to 256 total. Each weight
+   * is the step in the rounded running sum, so the rounding can't lose or add gain
+   * (three equal inputs are 85 + 86 + 85, not 3 * 85). */
+  int32_t zx = 0, zy = 0;
+  if (wsum > 0) {
+    uint32_t cum = 0;
+    int32_t prev = 0;
+    for (int i = 0; i < n; i++) {
+      cum += w[i];
+      int32_t upto = (int32_t)((cum * 256u + wsum / 2) / wsum);
+      int32_t wn = upto - prev;
+      prev = upto;
+      zx += wn * dx[i];
+      zy += wn * dy[i];
+    }
+  }
+
+  /* Update each usable input's noise from its disagreement with the fused value */
+  for (int i = 0; i < n; i++) {
+    if (w[i] == 0) continue;
+    int32_t e = iabs(dx[i] * 256 - zx) + iabs(dy[i] * 256 - zy);
+    f->noise_q8[i] += (e - f->noise_q8[i]) >> FUSION_NOISE_SHIFT;
+    if (f->noise_q8[i] < FUSION_NOISE_FLOOR) f->noise_q8[i] = FUSION_NOISE_FLOOR;
+  }
+
+  /* Alpha-beta filter on the integrated measurement; output whole counts */
+  int32_t z[2] = { zx, zy };
+  int32_t out[2];
+  for (int a = 0; a < 2; a++) {
+    f->meas_q8[a] += z[a];
+    int32_t pred = f->pos_q8[a] + f->vel_q8[a];
+    int32_t r = f->meas_q8[a] - pred;
+    f->pos_q8[a] = pred + (r >> FUSION_ALPHA_SHIFT);
+    f->vel_q8[a] += r >> FUSION_BETA_SHIFT;
+    out[a] = f->pos_q8[a] >> 8;
+    /* Keep state relative to what has been emitted so it never grows */
+    f->pos_q8[a] -= out[a] * 256;
+    f->meas_q8[a] -= out[a] * 256;
+  }
+  *out_x = out[0];
+  *out_y = out[1];
+}
@@ -0,0 +1,271 @@
+/**
+ * HID mouse report layout and extraction (see hid_mouse.h). No Pico SDK dependencies.
+ */
+#include "hid_mouse.h"
+#include <string.h>
+
+/* Item tags (HID 1.11, 6.2.2): (tag << 4) | (type << 2) with the size bits cleared */
+#define ITEM_INPUT          0x80
+#define ITEM_COLLECTION     0xA0
+#define ITEM_END_COLLECTION 0xC0
+#define ITEM_USAGE_PAGE     0x04
+#define ITEM_LOGICAL_MIN    0x14
+#define ITEM_REPORT_SIZE    0x74
+#define ITEM_REPORT_ID      0x84
+#define ITEM_REPORT_COUNT   0x94
+#define ITEM_PUSH           0xA4
+#define ITEM_POP            0xB4
+#define ITEM_USAGE          0x08
+#define ITEM_USAGE_MIN      0x18
+#define ITEM_USAGE_MAX      0x28
+#define ITEM_LONG           0xFE
+
+#define INPUT_CONSTANT      0x01
+#define INPUT_VARIABLE      0x02
+#define INPUT_RELATIVE      0x04
+
+#define PAGE_DESKTOP        0x01
+#define PAGE_BUTTON         0x09
+#define PAGE_CONSUMER       0x0C
+#define USAGE_MOUSE         0x02
+#define USAGE_X             0x30
+#define USAGE_Y             0x31
+#define USAGE_WHEEL         0x38
+#define USAGE_AC_PAN        0x0238
+#define COLLECTION_APPLICATION 0x01
+
+#define USAGES_MAX   16
+#define REPORT_IDS   8    /* report IDs whose running bit offset is tracked */
+#define STACK_DEPTH  4
+
+typedef struct {
+  uint16_t page;
+  int32_t logical_min;
+  uint32_t size, count;
+  uint8_t report_id;
+} globals_t;
+
+void hid_mouse_boot_layout(hid_mouse_layout_t *l) {
+  memset(l, 0, sizeof(*l));
+  l->buttons = (hid_field_t){ 0, 5, false };
+  l->x = (hid_field_t){ 8, 8, true };
+  l->y = (hid_field_t){ 16, 8, true };
+  l->wheel = (hid_field_t){ 24, 8, true };
+}
+
+static uint32_t item_u32(const uint8_t *d, int n) {
+  uint32_t v = 0;
+  for (int k = 0; k < n; k++)
+    v |= (uint32_t)d[k] << (8 * k);
+  return v;
+}
+
+static int32_t item_s32(const uint8_t *d, int n) {
+  uint32_t v = item_u32(d, n);
+  if (n > 0 && n < 4 && (v & (1u << (8 * n - 1))))
+    v |= ~0u << (8 * n);
+  return (int32_t)v;
+}
+
+/* Running bit offset for report ID id (0 when reports have no ID). */
+static uint16_t *id_offset(uint8_t *ids, uint16_t *offs, int *n, uint8_t id) {
+  for (int k = 0; k < *n; k++)
+    if (ids[k] == id)
+      return &offs[k];
+  if (*n == REPORT_IDS)
+    return NULL;
+  ids[*n] = id;
+  offs[*n] = 0;
+  return &offs[(*n)++];
+}
+
+bool hid_mouse_parse(const uint8_t *desc, size_t len, hid_mouse_layout_t *l) {
+  globals_t g = { 0 }, stack[STACK_DEPTH];
+  int sp = 0;
+  uint32_t usages[USAGES_MAX];   /* extended: page << 16 | usage */
+  int nusages = 0;
+  uint32_t umin = 0, umax = 0;
+  bool have_range = false;
+  int depth = 0, mouse_depth = -1;   /* collection depth of the Mouse application */
+  bool done = false;
+  uint8_t ids[REPORT_IDS];
+  uint16_t offs[REPORT_IDS];
+  int nids = 0;
+
+  memset(l, 0, sizeof(*l));
+  size_t i = 0;
+  while (i < len && !done) {
+    uint8_t b = desc[i];
+    if (b == ITEM_LONG) {
+      if (i + 1 >= len) break;
+      i += 3u + desc[i + 1];
+      continue;
+    }
+    int n = (b & 3) == 3 ? 4 : (b & 3);
+    if (i + 1 + (size_t)n > len) break;
+    const uint8_t *d = desc + i + 1;
+    i += 1u + (size_t)n;
+    uint32_t u = item_u32(d, n);
+
+    switch (b & 0xFC) {
+      case ITEM_USAGE_PAGE:   g.page = (uint16_t)u; break;
+      case ITEM_LOGICAL_MIN:  g.logical_min = item_s32(d, n); break;
+      case ITEM_REPORT_SIZE:  g.size = u; break;
+      case ITEM_REPORT_COUNT: g.count = u; break;
+      case ITEM_REPORT_ID:    g.report_id = (uint8_t)u; break;
+      case ITEM_PUSH:         if (sp < STACK_DEPTH) stack[sp++] = g; break;
+      case ITEM_POP:          if (sp > 0) g = stack[--sp]; break;
+      case ITEM_USAGE:
+        if (nusages < USAGES_MAX)
+          usages[nusages++] = n == 4 ? u : ((uint32_t)g.page << 16 | u);
+        break;
+      case ITEM_USAGE_MIN:
+        umin = n == 4 ? u : ((uint32_t)g.page << 16 | u);
+        have_range = true;
+        break;
+      case ITEM_USAGE_MAX:
+        umax = n == 4 ? u : ((uint32_t)g.page << 16 | u);
+        break;
+
+      case ITEM_COLLECTION:
+        if (mouse_depth < 0 && u == COLLECTION_APPLICATION && nusages > 0 &&
+            usages[0] == ((uint32_t)PAGE_DESKTOP << 16 | USAGE_MOUSE)) {
+          mouse_depth = depth;
+          l->report_id = g.report_id;   /* may still come inside the collection */
+        }
+        depth++;
+        nusages = 0;
+        have_range = false;
+        break;
+
+      case ITEM_END_COLLECTION:
+        depth--;
+        if (depth == mouse_depth)
+          done = true;   /* first mouse collection only */
+        nusages = 0;
+        have_range = false;
+        break;
+
+      case ITEM_INPUT: {
+        uint16_t *off = id_offset(ids, offs, &nids, g.report_id);
+        if (!off) return false;
+        uint32_t bits = g.size * g.count;
+        bool mine = mouse_depth >= 0 && (l->report_id == g.report_id || l->x.size == 0);
+        if (mine && !(u & INPUT_CONSTANT) && (u & INPUT_VARIABLE) && g.size <= 32) {
+          l->report_id = g.report_id;
+          for (uint32_t k = 0; k < g.count; k++) {
+            uint32_t usage;
+            if (have_range && umin + k <= umax)
+              usage = umin + k;
+            else if (nusages > 0)
+              usage = usages[k < (uint32_t)nusages ? k : (uint32_t)nusages - 1];
+            else
+              break;
+            hid_field_t f = { (uint16_t)(*off + k * g.size), (uint8_t)g.size, g.logical_min < 0 };
+            uint16_t page = (uint16_t)(usage >> 16), id = (uint16_t)usage;
+            if (page == PAGE_BUTTON) {
+              /* Buttons 1..N as one run of 1-bit fields, possibly over several items */
+              hid_field_t *bt = &l->buttons;
+              if (g.size != 1) {
+                /* multi-bit button fields (pressure) aren't buttons we can report */
+              } else if (id == 1) {
+                *bt = f;
+                bt->is_signed = false;
+              } else if (bt->size && id == bt->size + 1u && f.offset == bt->offset + bt->size &&
+                         bt->size < HID_MOUSE_BUTTONS_MAX) {
+                bt->size++;
+              }
+            } else if (page == PAGE_DESKTOP && !(u & INPUT_RELATIVE)) {
+              if (id == USAGE_X || id == USAGE_Y)
+                return false;   /* absolute pointer (tablet, touch screen) */
+            } else if (page == PAGE_DESKTOP) {
+              if (id == USAGE_X) l->x = f;
+              else if (id == USAGE_Y) l->y = f;
+              else if (id == USAGE_WHEEL) l->wheel = f;
+            } else if (page == PAGE_CONSUMER && id == USAGE_AC_PAN) {
+              l->pan = f;
+            }
+          }
+        }
+        *off = (uint16_t)(*off + bits);
+        nusages = 0;
+        have_range = false;
+        break;
+      }
+
+      default:   /* Output, Feature, and items that don't affect input layout */
+        if ((b & 0x0C) == 0) {   /* main item: locals are used up */
+          nusages = 0;
+          have_range = false;
+        }
+        break;
+    }
+  }
+  return l->x.size > 0 && l->y.size > 0;
+}
+
+static void compile_field(const hid_field_t *f, hid_op_t *op) {
+  memset(op, 0, sizeof(*op));
+  if (f->size == 0 || f->size > 32) return;
+  op->byte = (uint8_t)(f->offset >> 3);
+  op->shift = (uint8_t)(f->offset & 7);
+  op->size = f->size;
+  op->nbytes = (uint8_t)((op->shift + f->size + 7) >> 3);   /* 1..5 */
+  op->is_signed = f->is_signed;
+}
+
+void hid_mouse_compile(const hid_mouse_layout_t *l, hid_mouse_plan_t *p) {
+  p->report_id = l->report_id;
+  compile_field(&l->buttons, &p->buttons);
+  compile_field(&l->x, &p->x);
+  compile_field(&l->y, &p->y);
+  compile_field(&l->wheel, &p->wheel);
+  compile_field(&l->pan, &p->pan);
+  uint32_t ex = (uint32_t)p->x.byte + p->x.nbytes, ey = (uint32_t)p->y.byte + p->y.nbytes;
+  p->min_len = (uint8_t)(ex > ey ? ex : ey);
+}
+
+/* Run one op on report data d (len bytes); 0 if the field is absent or cut off. */
+static int32_t op_get(const hid_op_t *op, const uint8_t *d, size_t len) {
+  if (op->nbytes == 0 || (size_t)op->byte + op->nbytes > len)
+    return 0;
+  d += op->byte;
+  uint32_t v;
+  if (op->nbytes <= 4) {
+    v = d[0];
+    if (op->nbytes > 1) v |= (uint32_t)d[1] << 8;
+    if (op->nbytes > 2) v |= (uint32_t)d[2] << 16;
+    if (op->nbytes > 3) v |= (uint32_t)d[3] << 24;
+    v >>= op->shift;
+  } else {   /* a 26..32-bit field straddling five bytes */
+    v = (uint32_t)((d[0] | (uint64_t)d[1] << 8 | (uint64_t)d[2] << 16 | (uint64_t)d[3] << 24 |
+                    (uint64_t)d[4] << 32) >> op->shift);
+  }
+  uint8_t pad = (uint8_t)(32 - op->size);
+  if (op->is_signed)
+    return pad ? (int32_t)(v << pad) >> pad : (int32_t)v;
+  if (pad)
+    v &= ~0u >> pad;
+  return v > (uint32_t)INT32_MAX ? INT32_MAX : (int32_t)v;
+}
+
+static int16_t clamp_s16(int32_t v) {
+  if (v > 32767) return 32767;
+  if (v < -32768) return -32768;
+  return (int16_t)v;
+}
+
+bool hid_mouse_extract(const hid_mouse_plan_t *p, const uint8_t *report, size_t len, hid_mouse_report_t *out) {
+  if (p->report_id) {
+    if (len < 1 || report[0] != p->report_id) return false;
+    report++;
+    len--;
+  }
+  if (len < p->min_len) return false;
+  out->buttons = (uint16_t)op_get(&p->buttons, report, len);
+  out->dx = clamp_s16(op_get(&p->x, report, len));
+  out->dy = clamp_s16(op_get(&p->y, report, len));
+  out->wheel = clamp_s16(op_get(&p->wheel, report, len));
+  out->pan = clamp_s16(op_get(&p->pan, report, len));
+  return true;
+}
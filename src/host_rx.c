@@ -0,0 +1,32 @@
+/**
+ * Slot-addressed host records (see host_rx.h). No Pico SDK dependencies.
+ */
+#include "host_rx.h"
+
+static int16_t get_s16(const uint8_t *p) {
+  return (int16_t)((uint16_t)p[0] | ((uint16_t)p[1] << 8));
+}
+
+int host_raw_frame(host_raw_rx_t *rx, const uint8_t *p, int len) {
+  if (len < HOST_RAW_HEADER_LEN) return -1;
+  int count = p[0];
+  if (count > HOST_RAW_RECORDS_MAX || HOST_RAW_HEADER_LEN + count * HOST_RECORD_LEN > len)
+    return -1;
+  if (rx->frames > 0 && p[1] != (uint8_t)(rx->seq + 1))
+    rx->gaps++;
+  rx->seq = p[1];
+  rx->frames++;
+  return count;
+}
+
+bool host_record(const uint8_t *rec, int k, uint32_t slots, host_record_t *r) {
+  const uint8_t *b = rec + k * HOST_RECORD_LEN;
+  if (b[0] >= 32 || !(slots & (1u << b[0]))) return false;
+  r->slot = b[0];
+  r->buttons = b[1];
+  r->dx = get_s16(b + 2);
+  r->dy = get_s16(b + 4);
+  r->wheel = get_s16(b + 6);
+  r->pan = get_s16(b + 8);
+  return true;
+}
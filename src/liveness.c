@@ -0,0 +1,68 @@
+/**
+ * Per-mouse liveness tracking (see liveness.h). No Pico SDK dependencies.
+ */
+#include "liveness.h"
+#include <string.h>
+
+static liveness_slot_t g_slots[LIVENESS_MAX_SLOTS];
+
+void liveness_reset(void) {
+  memset(g_slots, 0, sizeof(g_slots));
+}
+
+void liveness_mark(int slot, bool active, uint32_t now_ms) {
+  if (slot < 0 || slot >= LIVENESS_MAX_SLOTS) return;
+  liveness_slot_t *l = &g_slots[slot];
+  if (l->packets > 0) {
+    uint32_t dt = now_ms - l->last_packet_ms;
+    uint32_t dt_q4 = dt > 4095 ? 65535 : dt << 4;
+    /* EWMA, weight 1/8; first interval seeds it */
+    if (l->packets == 1)
+      l->interval_q4 = (uint16_t)dt_q4;
+    else
+      l->interval_q4 = (uint16_t)((int32_t)l->interval_q4 + (((int32_t)dt_q4 - (int32_t)l->interval_q4) >> 3));
+  }
+  l->last_packet_ms = now_ms;
+  if (active) {
+    l->last_active_ms = now_ms;
+    l->moved = true;
+  }
+  l->packets++;
+}
+
+uint8_t liveness_state(int slot, uint32_t now_ms, uint16_t stale_ms) {
+  if (slot < 0 || slot >= LIVENESS_MAX_SLOTS) return LIVENESS_DEAD;
+  const liveness_slot_t *l = &g_slots[slot];
+  if (l->packets == 0 || now_ms - l->last_packet_ms >= stale_ms)
+    return LIVENESS_DEAD;
+  if (!l->moved || now_ms - l->last_active_ms >= stale_ms)
+    return LIVENESS_IDLE;
+  return LIVENESS_ACTIVE;
+}
+
+uint32_t liveness_mask(int n, uint32_t now_ms, uint16_t stale_ms) {
+  uint32_t m = 0;
+  for (int i = 0; i < n && i < LIVENESS_MAX_SLOTS; i++)
+    if (liveness_state(i, now_ms, stale_ms) == LIVENESS_ACTIVE)
+      m |= 1u << i;
+  return m;
+}
+
+uint32_t liveness_present_mask(int n, uint32_t now_ms, uint16_t stale_ms) {
+  uint32_t m = 0;
+  for (int i = 0; i < n && i < LIVENESS_MAX_SLOTS; i++)
+    if (liveness_state(i, now_ms, stale_ms) != LIVENESS_DEAD)
+      m |= 1u << i;
+  return m;
+}
+
+uint16_t liveness_rate_hz(int slot) {
+  if (slot < 0 || slot >= LIVENESS_MAX_SLOTS) return 0;
+  const liveness_slot_t *l = &g_slots[slot];
+  if (l->packets < 2 || l->interval_q4 == 0) return 0;
+  return (uint16_t)(16000u / l->interval_q4);
+}
+
+const liveness_slot_t *liveness_get(int slot) {
+  return &g_slots[slot];
+}
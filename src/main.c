@@ -1,11 +1,14 @@
 /**
- * 6-input amplified mouse for Raspberry Pi Pico
+ * Multi-input amplified mouse for Raspberry Pi Pico
  *
- * Aggregates up to 6 mouse inputs (dx, dy, buttons, wheel) into one
- * HID mouse with optional amplification. Input can come from:
+ * Aggregates up to MAX_MICE mouse inputs (dx, dy, buttons, wheel; 6 by default, up to
+ * 16) into one HID mouse with optional amplification, or passes them on as separate
+ * mice, touch contacts or a raw report. Input can come from:
  * - UART (e.g. host PC/RPi sending packed deltas)
  * - Quadrature encoders (6 ball mice wired directly: 4 pins per mouse)
- * - Future: USB host (MAX3421E + hub) or SPI optical sensors
+ * - SPI optical sensors (PMW3360-class, one chip select per mouse)
+ * - USB mice through a hub on a PIO-USB host port (USB_HOST_PIO builds)
+ * - Other Picos chained on the UART (cascade; see cascade.h)
  *
  * Build: Pico SDK, TinyUSB device (HID mouse).
  */
@@ -14,275 +17,1151 @@
 #include <string.h>
 #include "pico/stdlib.h"
 #include "pico/stdio.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/spi.h"
+#include "hardware/sync.h"
+#include "hardware/structs/iobank0.h"
+#include "hardware/structs/systick.h"
 #include "tusb_config.h"
 #include "bsp/board_api.h"
 #include "tusb.h"
 #include "usb_descriptors.h"
-
-#define NUM_MICE_MAX    6     /* max mice (array sizes, UART packet) */
-
-/* Logic and input mode symbols (values come from config.h) */
-#define LOGIC_MODE_SUM      0
-#define LOGIC_MODE_AVERAGE  1
-#define LOGIC_MODE_MAX      2
-#define LOGIC_MODE_2_MIN    3
-#define LOGIC_MODE_2_AND    4
-#define LOGIC_MODE_2_OR     5
-#define LOGIC_MODE_2_XOR    6
-#define LOGIC_MODE_2_NAND   7
-#define LOGIC_MODE_2_NOR    8
-#define LOGIC_MODE_2_XNOR   9
-#define INPUT_MODE_UART         0
-#define INPUT_MODE_QUADRATURE   1
-#define INPUT_MODE_BOTH         2
+#if USB_HOST_PIO
+#include "pio_usb.h"
+#endif
 
 #include "config.h"
 #include "settings.h"
+#include "accel.h"
+#include "fusion.h"
+#include "liveness.h"
+#include "coalesce.h"
+#include "profiler.h"
+#include "telemetry.h"
+#include "plan.h"
+#include "quad.h"
+#include "pmw3360.h"
+#include "hid_mouse.h"
+#include "cascade.h"
+#include "frameclock.h"
+#include "host_rx.h"
+
+#define NUM_MICE_MAX    SETTINGS_NUM_MICE_MAX   /* mouse slots compiled in (array sizes) */
 
 #if NUM_MICE < 2 || NUM_MICE > NUM_MICE_MAX
-#error "NUM_MICE must be between 2 and NUM_MICE_MAX (6). Run configure.py."
+#error "NUM_MICE must be between 2 and MAX_MICE. Run configure.py."
 #endif
 
+/* Settings snapshot for this main loop iteration (see settings_acquire), and the
+ * execution plan derived from it (rebuilt only when the settings version moves). */
+static settings_t g_cfg;
+static plan_t g_plan;
+
+static void settings_refresh(void) {
+  settings_acquire(&g_cfg);
+  if (g_plan.version != g_cfg.version)
+    plan_build(&g_plan, &g_cfg);
+}
+
 static inline int get_num_mice(void) {
-  return (int)settings_get()->num_mice;
+  return (int)g_cfg.num_mice;
 }
 
 #define UART_ID         uart0
-#define UART_BAUD       115200
+#ifndef UART_BAUD
+#define UART_BAUD       115200   /* config.h uart_baud; a cascade chain wants 1000000 */
+#endif
 #define UART_TX_PIN     0
 #define UART_RX_PIN     1
-#define HID_POLL_MS     2      /* send HID report every 2 ms when there is movement */
-
-/* Quadrature: 6 mice × 4 pins (X_A, X_B, Y_A, Y_B). Pico GPIO numbers. */
-static const uint8_t QUAD_PINS[NUM_MICE_MAX][4] = {
-  { 2,  3,  4,  5 },  /* Mouse 0: X_A, X_B, Y_A, Y_B */
-  { 6,  7,  8,  9 },  /* Mouse 1 */
-  { 10, 11, 12, 13 }, /* Mouse 2 */
-  { 14, 15, 16, 17 }, /* Mouse 3 */
-  { 18, 19, 20, 21 }, /* Mouse 4 */
-  { 22, 23, 24, 25 }, /* Mouse 5 */
-};
+#define FRAME_US        (HID_POLL_MS * 1000)   /* HID_POLL_MS: usb_descriptors.h */
+#ifndef FRAME_LEAD_US
+#define FRAME_LEAD_US   250    /* run a report frame this long before the SOF it is for */
+#endif
+#ifndef FRAME_SPIN_US
+#define FRAME_SPIN_US   30     /* a frame this close: wait for it rather than loop again */
+#endif
 
-/* Per-mouse state (from UART or host) */
+/* Quadrature: 6 mice × 4 pins (X_A, X_B, Y_A, Y_B) on consecutive GPIOs: mouse 0 on
+ * 2..5, mouse 1 on 6..9, ... mouse 5 on 22..25. gpio_get_all() >> QUAD_PIN_BASE is then
+ * one packed sample of every encoder, in the layout quad_step() takes. */
+#define QUAD_PIN_BASE   2
+#define QUAD_PIN(i, j)  (QUAD_PIN_BASE + 4 * (i) + (j))
+
+/* SPI optical sensors (input_mode = spi) on SPI0, sensor i selected by SPI_CS_BASE + i.
+ * These overlap the quadrature pins, which are not in use in this mode. */
+#define SPI_PORT        spi0
+#define SPI_BAUD        2000000   /* PMW3360 maximum */
+#define SPI_MISO_PIN    16
+#define SPI_SCK_PIN     18
+#define SPI_MOSI_PIN    19
+#define SPI_CS_BASE     2
+#ifndef SPI_CPI
+#define SPI_CPI         1600
+#endif
+
+/* USB host (input_mode = usb): PIO-USB D+ on USB_HOST_DP_PIN, D- on the next pin. */
+#define USB_HOST_DP_PIN 16
+
+/* Arrival time of the oldest input waiting in a pipeline stage (for the latency profiler) */
+typedef struct {
+  uint32_t us;
+  bool valid;
+} stamp_t;
+
+static void stamp_merge(stamp_t *dst, const stamp_t *src) {
+  if (src->valid && (!dst->valid || (int32_t)(src->us - dst->us) < 0))
+    *dst = *src;
+}
+
+/* Per-mouse input (from UART or quadrature). Sources add to it; it is drained
+ * once per report frame, so packets arriving between frames are not lost. */
 typedef struct {
-  int8_t dx;
-  int8_t dy;
-  uint8_t buttons;
-  int8_t wheel;
+  int16_t dx;
+  int16_t dy;
+  uint8_t buttons;   /* current level; changes are queued on the output immediately */
+  int16_t wheel;     /* wheel and pan in 1/WHEEL_HIRES_MULT detents */
+  int16_t pan;
+  stamp_t stamp;     /* first input since the last frame */
 } mouse_input_t;
 
 static mouse_input_t g_mice[NUM_MICE_MAX];
-static int16_t g_combined_dx, g_combined_dy;
-static uint8_t g_combined_buttons;
 static int16_t g_combined_wheel;
-static bool g_has_report;
+static int16_t g_combined_pan;
+
+/* Output accumulator per HID instance; holds motion while the endpoint is busy */
+static coalesce_t g_out[CFG_TUD_HID];
+static uint8_t g_out_mode;
+static stamp_t g_out_stamp[CFG_TUD_HID];   /* oldest input still in g_out[slot] */
+static stamp_t g_inflight[CFG_TUD_HID];    /* report handed to USB, per slot */
+static frameclock_t g_clock;               /* when report frames run (SOF-locked) */
+
+static void input_stamp_at(int i, uint32_t us) {
+  if (!g_mice[i].stamp.valid) {
+    g_mice[i].stamp.us = us;
+    g_mice[i].stamp.valid = true;
+  }
+}
+
+static void input_stamp(int i) {
+  input_stamp_at(i, time_us_32());
+}
+
+/* Output slot of mouse i in the per-mouse layouts (separate, composite, absolute, raw):
+ * past USB_MOUSE_OUTPUTS, mice share them, i % USB_MOUSE_OUTPUTS (without a divide). */
+static inline int out_slot(int i) {
+  while (i >= USB_MOUSE_OUTPUTS)
+    i -= USB_MOUSE_OUTPUTS;
+  return i;
+}
+
+/* Output slots in use for n mice. */
+static inline int out_count(int n) {
+  return n < USB_MOUSE_OUTPUTS ? n : USB_MOUSE_OUTPUTS;
+}
+
+/* Set one mouse's button level and queue the change on the instance that reports it:
+ * its own in separate mode (or its contact in absolute mode), instance 0 (OR of all mice)
+ * in combined mode. Called per packet, so press/release pairs shorter than a report
+ * interval are kept in order. */
+static void buttons_set(int i, uint8_t level) {
+  g_mice[i].buttons = level;
+  if (g_out_mode != SETTINGS_OUTPUT_COMBINED) {
+    int o = out_slot(i);
+    uint8_t all = 0;
+    for (int j = o; j < NUM_MICE_MAX; j += USB_MOUSE_OUTPUTS)   /* the mice sharing output o */
+      all |= g_mice[j].buttons;
+    coalesce_buttons(&g_out[o], all);
+  } else {
+    uint8_t all = 0;
+    for (int j = 0; j < NUM_MICE_MAX; j++)
+      all |= g_mice[j].buttons;
+    coalesce_buttons(&g_out[0], all);
+  }
+}
+
+static int16_t add_s16(int16_t a, int32_t b) {
+  int32_t v = (int32_t)a + b;
+  if (v > 32767) return 32767;
+  if (v < -32768) return -32768;
+  return (int16_t)v;
+}
+
+static int16_t get_s16(const uint8_t *p) {
+  return (int16_t)((uint16_t)p[0] | ((uint16_t)p[1] << 8));
+}
+
+static void put_u16(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v & 0xFF);
+  p[1] = (uint8_t)((v >> 8) & 0xFF);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+  put_u16(p, v & 0xFFFF);
+  put_u16(p + 2, v >> 16);
+}
+
+/* Resolution Multiplier feature value the host set for each output slot (0 after reset) */
+static uint8_t g_res_mult[CFG_TUD_HID];
+#define RES_MULT_WHEEL  0x01
+#define RES_MULT_PAN    0x04
+
+/* Sub-detent wheel/pan left over per output slot while the host reports whole detents */
+static int32_t wheel_res[CFG_TUD_HID][2];
+
+/* Convert wheel (axis 0) or pan (axis 1) from 1/WHEEL_HIRES_MULT detents to the units
+ * output slot inst reports in. Without the multiplier, the remainder waits for the next frame. */
+static int32_t wheel_units(int inst, int axis, int32_t v) {
+  int32_t total = wheel_res[inst][axis] + v;
+  if (g_out_mode == SETTINGS_OUTPUT_RAW ||
+      (g_res_mult[inst] & (axis == 0 ? RES_MULT_WHEEL : RES_MULT_PAN))) {
+    wheel_res[inst][axis] = 0;
+    return total;
+  }
+  int32_t detents = total / WHEEL_HIRES_MULT;
+  wheel_res[inst][axis] = total - detents * WHEEL_HIRES_MULT;
+  return detents;
+}
 
 /* UART protocol: sync 0xAA then 6 × (dx, dy) then 1 byte buttons, 1 byte wheel (signed).
- * Total 1 + 12 + 1 + 1 = 15 bytes. */
+ * Total 1 + 12 + 1 + 1 = 15 bytes, whatever MAX_MICE is; mice past the sixth need the
+ * slot-addressed packet below. */
 #define UART_SYNC       0xAA
-#define UART_PACKET_LEN (1 + NUM_MICE_MAX * 2 + 1 + 1)
+#define UART_PACKET_MICE 6
+#define UART_PACKET_LEN (1 + UART_PACKET_MICE * 2 + 1 + 1)
+
+/* Slot-addressed packet: sync 0xAB, count, then count × (slot, buttons, dx, dy, wheel, pan)
+ * with int16 little-endian fields, then XOR of every byte after the sync. Wheel and pan
+ * are in 1/WHEEL_HIRES_MULT detents. Only mice that changed need a record. */
+#define UART_SYNC_V2       0xAB
+#define UART_V2_RECORD_LEN HOST_RECORD_LEN
+#define UART_V2_LEN(count) (2 + (count) * UART_V2_RECORD_LEN + 1)
+#define UART_BUF_LEN       (UART_V2_LEN(NUM_MICE_MAX) > CASCADE_LEN_MAX ? UART_V2_LEN(NUM_MICE_MAX) : CASCADE_LEN_MAX)
+
+static uint8_t uart_buf[UART_BUF_LEN];
 
-static uint8_t uart_buf[UART_PACKET_LEN];
+/* Raw HID OUT frames: count, sequence, then records as in the 0xAB packet (see host_rx.h) */
+static host_raw_rx_t g_raw_out;
 static int uart_len;
 
-/* Config packet: 0x55 0xCF 0x01 then 8 bytes (num_mice, logic, input, output_mode, amplify_x100, quad_lo, quad_hi, save). */
+/* Cascade link (0xAC frames, see cascade.h): received from the Pico below, and, when
+ * cascade_mode is on, sent up to the next one on UART TX. */
+static cascade_tx_t g_cascade_tx;
+static uint8_t g_cascade_buf[CASCADE_LEN_MAX];   /* frame being written to the UART */
+static int g_cascade_len, g_cascade_pos;
+static uint32_t g_cascade_rx, g_cascade_bad, g_cascade_sent;
+static uint8_t g_cascade_hops;                    /* links the last frame received crossed */
+static uint32_t g_cascade_age_us, g_cascade_age_max_us;   /* age of its input on arrival */
+
+/* Config packet: 0x55 0xCF <cmd> then a fixed-length payload per command:
+ * 0x01: 8 bytes (num_mice, logic, input, output_mode, amplify_x100, quad_lo, quad_hi, save)
+ * 0x02: 10 bytes (mouse, xx, xy, yx, yy as int16 little-endian Q8, save)
+ * 0x03: 8 bytes (accel mode, window_ms, threshold, rate lo/hi, max_x100 lo/hi, save)
+ * 0x04: 3 bytes (stale_ms lo/hi, save)
+ * 0x05: 2 bytes (button_min_hold_ms, save)
+ * 0x06: 2 bytes (quad_sampler, save)
+ * 0x07: 2 bytes (quad_filter taps: 1, 3 or 5, save)
+ * 0x08: 2 bytes (quad_rate_max_khz: timer sampler ceiling, save)
+ * 0x09: 17 bytes (slot 0..15 source masks: SETTINGS_SRC_* bits, save; past MAX_MICE ignored)
+ * 0x0A: 3 bytes (cascade_mode: 0 off, 1 slots, 2 combined, cascade_slot, save)
+ * 0x10: no payload; status query, answered over USB CDC (see status_reply)
+ * 0x11: no payload; reset the latency profiler, quadrature stats and the cascade max age
+ * 0x12: 1 byte (1 = stream telemetry over USB CDC, 0 = stop) */
 #define UART_CONFIG_HEADER_LEN  3
-#define UART_CONFIG_PAYLOAD_LEN 8
+#define UART_CONFIG_PAYLOAD_MAX 17
+#define UART_CONFIG_SLOTS       SETTINGS_NUM_MICE_LIMIT   /* masks in a 0x09 packet */
 static int uart_config_state;
 static int uart_config_len;
-static uint8_t uart_config_buf[UART_CONFIG_PAYLOAD_LEN];
+static uint8_t uart_config_cmd;
+static uint8_t uart_config_buf[UART_CONFIG_PAYLOAD_MAX];
 
-/* Quadrature decode: prev_ab and curr_ab are 2-bit (A=bit0, B=bit1). Returns -1, 0, or +1. */
-static const int8_t quad_table[16] = {
-  0, 1, -1, 0,  -1, 0, 0, 1,  1, 0, 0, -1,  0, -1, 1, 0
-};
-static uint8_t quad_prev[NUM_MICE_MAX][2];  /* [mouse][0]=X_ab, [1]=Y_ab */
-static int16_t quad_acc[NUM_MICE_MAX][2];   /* accumulated counts [mouse][dx,dy] */
+/* Quadrature state is shared with the edge IRQ or the sampling timer (quad_sampler =
+ * irq or timer); the main loop only touches it with interrupts off in those modes. */
+static quad_state_t g_quad;
+static quad_filter_t g_quad_filter;
+static uint32_t g_quad_pins;                 /* packed-sample bits of the mice set up */
+static uint8_t g_quad_sampler;               /* SETTINGS_QUAD_* in effect */
+static bool g_quad_irq_installed;
+static uint32_t g_quad_irq_ack[4];           /* edge status bits of those pins, per intr register */
+static uint8_t g_quad_stamped;               /* mice whose first edge time is held below */
+static uint32_t g_quad_edge_us[QUAD_MICE];
+static repeating_timer_t g_quad_timer;
+static quad_rate_t g_quad_rate;
+static uint32_t g_quad_rate_max_hz;          /* ceiling g_quad_rate was set up with */
 
-static void quadrature_init(void) {
+/* Edge IRQ cost, for the status reply: the edge rate the IRQ can keep up with is
+ * clk_sys / cycles per IRQ (one IRQ per edge at worst; close edges share one). */
+static uint32_t g_quad_irqs;
+static uint64_t g_quad_irq_cycles;
+static uint32_t g_quad_irq_cycles_max;
+
+static inline uint32_t quad_sample(void) {
+  return (gpio_get_all() >> QUAD_PIN_BASE) & g_quad_pins;
+}
+
+/* Filtered sample. Polled: majority over successive polls. In the IRQ there is no
+ * next sample until the next edge, so it votes over back-to-back reads instead. */
+static inline uint32_t quad_sample_filtered(bool in_irq) {
+  if (!in_irq)
+    return quad_filter(&g_quad_filter, quad_sample());
+  uint32_t s[QUAD_TAPS_MAX];
+  int taps = g_quad_filter.taps;
+  for (int i = 0; i < taps; i++)
+    s[i] = quad_sample();
+  return quad_vote(s, taps);
+}
+
+static void quad_stats_reset(void) {
+  uint32_t irq = save_and_disable_interrupts();
+  g_quad_irqs = 0;
+  g_quad_irq_cycles = 0;
+  g_quad_irq_cycles_max = 0;
+  memset(g_quad.illegal, 0, sizeof(g_quad.illegal));
+  restore_interrupts(irq);
+}
+
+/* Hold the time of each mouse's first count until the main loop takes it. */
+static inline void quad_note_moved(uint32_t moved) {
+  moved &= QUAD_MOVED_MASK & ~(uint32_t)g_quad_stamped;
+  if (!moved) return;
+  uint32_t now = time_us_32();
+  for (int i = 0; i < QUAD_MICE; i++)
+    if (moved & (1u << i))
+      g_quad_edge_us[i] = now;
+  g_quad_stamped |= (uint8_t)moved;
+}
+
+/* Acknowledge every pending quadrature edge, then decode one sample of all pins.
+ * An edge that lands after the sample raises the IRQ again, so none are lost. Only
+ * the quadrature pins' edge bits are cleared: edges on other pins belong to their own
+ * handlers on the shared bank interrupt. */
+static void __not_in_flash_func(quad_irq)(void) {
+  uint32_t t0 = systick_hw->cvr;
+  for (int r = 0; r < 4; r++) {
+    uint32_t st = iobank0_hw->proc0_irq_ctrl.ints[r] & g_quad_irq_ack[r];
+    if (st)
+      iobank0_hw->intr[r] = st;
+  }
+  quad_note_moved(quad_step(&g_quad, quad_sample_filtered(true)));
+  uint32_t cycles = (t0 - systick_hw->cvr) & 0xFFFFFFu;   /* SysTick counts down */
+  g_quad_irqs++;
+  g_quad_irq_cycles += cycles;
+  if (cycles > g_quad_irq_cycles_max)
+    g_quad_irq_cycles_max = cycles;
+}
+
+/* Timer sampler: one filtered sample per tick, and the next tick is scheduled at the
+ * rate the controller picks from what this one saw. */
+static bool __not_in_flash_func(quad_timer_cb)(repeating_timer_t *rt) {
+  uint32_t sample = quad_sample_filtered(false);
+  bool changed = sample != g_quad.prev;
+  uint32_t r = quad_step(&g_quad, sample);
+  quad_note_moved(r);
+  uint32_t period = quad_rate_step(&g_quad_rate, changed, (r & QUAD_STEP_ILLEGAL) != 0);
+  rt->delay_us = -(int64_t)period;   /* negative: from the start of this tick */
+  return true;
+}
+
+/* Encoders on the first num_mice slots that have pins (QUAD_MICE of them). */
+static int quad_mice(void) {
   int n = get_num_mice();
+  return n < QUAD_MICE ? n : QUAD_MICE;
+}
+
+static void quadrature_init(void) {
+  int n = quad_mice();
   for (int i = 0; i < n; i++) {
     for (int j = 0; j < 4; j++) {
-      gpio_init(QUAD_PINS[i][j]);
-      gpio_set_dir(QUAD_PINS[i][j], GPIO_IN);
-      gpio_pull_up(QUAD_PINS[i][j]);
+      gpio_init(QUAD_PIN(i, j));
+      gpio_set_dir(QUAD_PIN(i, j), GPIO_IN);
+      gpio_pull_up(QUAD_PIN(i, j));
     }
-    quad_prev[i][0] = (uint8_t)((gpio_get(QUAD_PINS[i][0]) ? 1u : 0u) | (gpio_get(QUAD_PINS[i][1]) ? 2u : 0u));
-    quad_prev[i][1] = (uint8_t)((gpio_get(QUAD_PINS[i][2]) ? 1u : 0u) | (gpio_get(QUAD_PINS[i][3]) ? 2u : 0u));
-    quad_acc[i][0] = quad_acc[i][1] = 0;
+  }
+  g_quad_pins = (1u << (n * 4)) - 1u;
+  quad_reset(&g_quad, quad_sample());
+  quad_filter_reset(&g_quad_filter, 1, quad_sample());
+  g_quad_sampler = SETTINGS_QUAD_POLL;
+}
+
+static void quad_irq_enable(bool on) {
+  if (on && !g_quad_irq_installed) {
+    /* Four status bits per GPIO, eight GPIOs per register: EDGE_LOW, EDGE_HIGH are 2, 3 */
+    for (int b = 0; b < QUAD_BITS; b++)
+      if (g_quad_pins & (1u << b)) {
+        unsigned gpio = (unsigned)(QUAD_PIN_BASE + b);
+        g_quad_irq_ack[gpio / 8] |= 0xCu << (4 * (gpio % 8));
+      }
+    systick_hw->rvr = 0xFFFFFFu;   /* free-running cycle counter for quad_irq's cost */
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5u;        /* enable, processor clock, no interrupt */
+    gpio_add_raw_irq_handler_masked(g_quad_pins << QUAD_PIN_BASE, quad_irq);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+    g_quad_irq_installed = true;
+  }
+  for (int b = 0; b < QUAD_BITS; b++)
+    if (g_quad_pins & (1u << b))
+      gpio_set_irq_enabled((unsigned)(QUAD_PIN_BASE + b), GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, on);
+}
+
+/* Switch between main-loop polling, edge interrupts and the adaptive timer, and set
+ * the glitch filter and the timer's ceiling. */
+static void quad_sampler_apply(uint8_t sampler, uint8_t taps, uint32_t rate_max_hz) {
+  if (g_quad_pins == 0) return;
+  if (taps != g_quad_filter.taps) {
+    uint32_t saved = save_and_disable_interrupts();
+    quad_filter_reset(&g_quad_filter, taps, g_quad.prev);
+    restore_interrupts(saved);
+  }
+  if (sampler == SETTINGS_QUAD_TIMER && sampler == g_quad_sampler && rate_max_hz != g_quad_rate_max_hz) {
+    uint32_t saved = save_and_disable_interrupts();
+    quad_rate_init(&g_quad_rate, rate_max_hz);   /* next tick picks the new ceiling up */
+    g_quad_rate_max_hz = rate_max_hz;
+    restore_interrupts(saved);
+  }
+  if (sampler == g_quad_sampler) return;
+
+  if (g_quad_sampler == SETTINGS_QUAD_IRQ)
+    quad_irq_enable(false);
+  else if (g_quad_sampler == SETTINGS_QUAD_TIMER)
+    cancel_repeating_timer(&g_quad_timer);
+
+  uint32_t saved = save_and_disable_interrupts();
+  quad_step(&g_quad, quad_sample_filtered(sampler == SETTINGS_QUAD_IRQ));   /* catch up */
+  g_quad_sampler = sampler;
+  restore_interrupts(saved);
+
+  if (sampler == SETTINGS_QUAD_IRQ) {
+    quad_irq_enable(true);
+  } else if (sampler == SETTINGS_QUAD_TIMER) {
+    quad_rate_init(&g_quad_rate, rate_max_hz);
+    g_quad_rate_max_hz = rate_max_hz;
+    add_repeating_timer_us(-(int64_t)g_quad_rate.period_us, quad_timer_cb, NULL, &g_quad_timer);
   }
 }
 
 static void quadrature_poll(void) {
-  int n = get_num_mice();
-  uint16_t qs = settings_get()->quad_scale;
-  for (int i = 0; i < n; i++) {
-    uint8_t x_ab = (uint8_t)((gpio_get(QUAD_PINS[i][0]) ? 1u : 0u) | (gpio_get(QUAD_PINS[i][1]) ? 2u : 0u));
-    uint8_t y_ab = (uint8_t)((gpio_get(QUAD_PINS[i][2]) ? 1u : 0u) | (gpio_get(QUAD_PINS[i][3]) ? 2u : 0u));
-    int8_t dx = quad_table[(quad_prev[i][0] << 2) | x_ab];
-    int8_t dy = quad_table[(quad_prev[i][1] << 2) | y_ab];
-    quad_prev[i][0] = x_ab;
-    quad_prev[i][1] = y_ab;
-    quad_acc[i][0] += dx;
-    quad_acc[i][1] += dy;
-  }
-  /* Convert accumulated counts to g_mice deltas (with scaling) */
+  int n = quad_mice();
+  int16_t qs = g_plan.quad_scale;
+  bool irq = g_quad_sampler != SETTINGS_QUAD_POLL;   /* counts arrive from an interrupt */
+  uint32_t now = board_millis();
+  uint32_t saved = 0;
+  if (irq)
+    saved = save_and_disable_interrupts();
+  else
+    quad_step(&g_quad, quad_sample_filtered(false));
+  uint32_t moved = g_quad.moved;
+  g_quad.moved = 0;
+  uint32_t stamped = g_quad_stamped;
+  g_quad_stamped = 0;
+  uint32_t slots = g_plan.src_slots[PLAN_SRC_QUAD];
+
+  /* Convert accumulated counts to g_mice deltas (with scaling); encoders on slots
+   * mapped to other sources are still decoded, but their counts are dropped */
   for (int i = 0; i < n; i++) {
-    int16_t ax = quad_acc[i][0], ay = quad_acc[i][1];
-    int8_t dx = 0, dy = 0;
-    if (qs > 0) {
-      if (ax >= (int16_t)qs) { dx = (int8_t)(ax / (int16_t)qs); quad_acc[i][0] = (int16_t)(ax % (int16_t)qs); }
-      else if (ax <= -(int16_t)qs) { dx = (int8_t)(ax / (int16_t)qs); quad_acc[i][0] = (int16_t)(ax % (int16_t)qs); }
-      if (ay >= (int16_t)qs) { dy = (int8_t)(ay / (int16_t)qs); quad_acc[i][1] = (int16_t)(ay % (int16_t)qs); }
-      else if (ay <= -(int16_t)qs) { dy = (int8_t)(ay / (int16_t)qs); quad_acc[i][1] = (int16_t)(ay % (int16_t)qs); }
+    if (!(slots & (1u << i))) {
+      g_quad.acc[i][0] = g_quad.acc[i][1] = 0;
+      continue;
+    }
+    int16_t ax = g_quad.acc[i][0], ay = g_quad.acc[i][1];
+    int32_t dx = 0, dy = 0;   /* up to 32768 counts at quad_scale 1: not int8 */
+    if (ax >= qs || ax <= -qs) {
+      dx = fastdiv_s32(&g_plan.quad_div, ax);
+      g_quad.acc[i][0] = (int16_t)(ax - dx * qs);
+    }
+    if (ay >= qs || ay <= -qs) {
+      dy = fastdiv_s32(&g_plan.quad_div, ay);
+      g_quad.acc[i][1] = (int16_t)(ay - dy * qs);
     }
     if (dx != 0 || dy != 0) {
-      g_mice[i].dx += dx;
-      g_mice[i].dy += dy;
-      if (g_mice[i].dx > 127) g_mice[i].dx = 127;
-      if (g_mice[i].dx < -128) g_mice[i].dx = -128;
-      if (g_mice[i].dy > 127) g_mice[i].dy = 127;
-      if (g_mice[i].dy < -128) g_mice[i].dy = -128;
+      g_mice[i].dx = add_s16(g_mice[i].dx, dx);
+      g_mice[i].dy = add_s16(g_mice[i].dy, dy);
+    }
+  }
+  if (irq)
+    restore_interrupts(saved);
+
+  moved &= slots;
+  for (int i = 0; i < n; i++) {
+    if (!(moved & (1u << i))) continue;
+    liveness_mark(i, true, now);
+    if (stamped & (1u << i))
+      input_stamp_at(i, g_quad_edge_us[i]);   /* time of the first edge, not of this poll */
+    else
+      input_stamp(i);
+  }
+}
+
+/* SPI sensors: register access is plain blocking SPI; a motion burst is one DMA
+ * transfer (a TX channel clocking out zeros, an RX channel filling the burst buffer),
+ * so the main loop only checks on it between passes. */
+static pmw_t g_pmw;
+static int g_spi_dma_tx, g_spi_dma_rx;
+static dma_channel_config g_spi_dma_tx_cfg, g_spi_dma_rx_cfg;
+
+static void spi_bus_select(void *ctx, int sensor, bool on) {
+  (void)ctx;
+  gpio_put((unsigned)(SPI_CS_BASE + sensor), !on);
+}
+
+static void spi_bus_write(void *ctx, const uint8_t *buf, size_t n) {
+  (void)ctx;
+  spi_write_blocking(SPI_PORT, buf, n);
+}
+
+static void spi_bus_read(void *ctx, uint8_t *buf, size_t n) {
+  static const uint8_t zero = 0;
+  (void)ctx;
+  dma_channel_configure(g_spi_dma_rx, &g_spi_dma_rx_cfg, buf, &spi_get_hw(SPI_PORT)->dr, n, false);
+  dma_channel_configure(g_spi_dma_tx, &g_spi_dma_tx_cfg, &spi_get_hw(SPI_PORT)->dr, &zero, n, false);
+  dma_start_channel_mask((1u << g_spi_dma_tx) | (1u << g_spi_dma_rx));
+}
+
+static bool spi_bus_busy(void *ctx) {
+  (void)ctx;
+  return dma_channel_is_busy((unsigned)g_spi_dma_rx);
+}
+
+static void spi_bus_delay(void *ctx, uint32_t us) {
+  (void)ctx;
+  busy_wait_us_32(us);
+}
+
+static const pmw_bus_t g_pmw_bus = {
+  spi_bus_select, spi_bus_write, spi_bus_read, spi_bus_busy, spi_bus_delay, NULL
+};
+
+/* Power up every chip select's sensor (~55 ms each), so num_mice can change later. */
+static void spi_sensors_init(void) {
+  spi_init(SPI_PORT, SPI_BAUD);
+  spi_set_format(SPI_PORT, 8, SPI_CPOL_1, SPI_CPHA_1, SPI_MSB_FIRST);
+  gpio_set_function(SPI_MISO_PIN, GPIO_FUNC_SPI);
+  gpio_set_function(SPI_SCK_PIN, GPIO_FUNC_SPI);
+  gpio_set_function(SPI_MOSI_PIN, GPIO_FUNC_SPI);
+  for (int i = 0; i < PMW_SENSORS_MAX; i++) {
+    gpio_init((unsigned)(SPI_CS_BASE + i));
+    gpio_put((unsigned)(SPI_CS_BASE + i), 1);
+    gpio_set_dir((unsigned)(SPI_CS_BASE + i), GPIO_OUT);
+  }
+
+  g_spi_dma_tx = dma_claim_unused_channel(true);
+  g_spi_dma_rx = dma_claim_unused_channel(true);
+  g_spi_dma_tx_cfg = dma_channel_get_default_config((unsigned)g_spi_dma_tx);
+  channel_config_set_transfer_data_size(&g_spi_dma_tx_cfg, DMA_SIZE_8);
+  channel_config_set_dreq(&g_spi_dma_tx_cfg, spi_get_dreq(SPI_PORT, true));
+  channel_config_set_read_increment(&g_spi_dma_tx_cfg, false);
+  channel_config_set_write_increment(&g_spi_dma_tx_cfg, false);
+  g_spi_dma_rx_cfg = dma_channel_get_default_config((unsigned)g_spi_dma_rx);
+  channel_config_set_transfer_data_size(&g_spi_dma_rx_cfg, DMA_SIZE_8);
+  channel_config_set_dreq(&g_spi_dma_rx_cfg, spi_get_dreq(SPI_PORT, false));
+  channel_config_set_read_increment(&g_spi_dma_rx_cfg, false);
+  channel_config_set_write_increment(&g_spi_dma_rx_cfg, true);
+
+  pmw_init(&g_pmw, &g_pmw_bus, PMW_SENSORS_MAX, SPI_CPI);
+}
+
+/* SPI has left the plan: end any burst, free the DMA channels and the SPI block, and
+ * hand the pins back (the chip selects are quadrature pins). spi_sensors_init powers
+ * the sensors up again if SPI comes back. */
+static void spi_sensors_stop(void) {
+  dma_channel_abort((unsigned)g_spi_dma_rx);
+  dma_channel_abort((unsigned)g_spi_dma_tx);
+  dma_channel_unclaim((unsigned)g_spi_dma_rx);
+  dma_channel_unclaim((unsigned)g_spi_dma_tx);
+  spi_deinit(SPI_PORT);
+  gpio_deinit(SPI_MISO_PIN);
+  gpio_deinit(SPI_SCK_PIN);
+  gpio_deinit(SPI_MOSI_PIN);
+  for (int i = 0; i < PMW_SENSORS_MAX; i++)
+    gpio_deinit((unsigned)(SPI_CS_BASE + i));
+}
+
+static void spi_sensors_poll(void) {
+  uint32_t slots = g_plan.src_slots[PLAN_SRC_SPI];
+  pmw_poll(&g_pmw, time_us_32());
+  uint32_t moved = g_pmw.moved;
+  if (!moved) return;
+  g_pmw.moved = 0;
+  uint32_t now = board_millis();
+  for (int i = 0; i < PMW_SENSORS_MAX; i++) {
+    if (!(moved & (1u << i))) continue;
+    if (slots & (1u << i)) {
+      g_mice[i].dx = add_s16(g_mice[i].dx, g_pmw.acc[i][0]);
+      g_mice[i].dy = add_s16(g_mice[i].dy, g_pmw.acc[i][1]);
+      input_stamp(i);
+      liveness_mark(i, true, now);
+    }
+    g_pmw.acc[i][0] = g_pmw.acc[i][1] = 0;
+  }
+}
+
+/* Sub-count remainder of each mouse's transform (Q8), carried into the next report. */
+static int32_t xform_res[NUM_MICE_MAX][2];
+
+/* Apply mouse i's Q8 matrix to (dx, dy). Only called for mice set in xform_mask. */
+static void xform_apply(const settings_t *s, int i, int32_t *dx, int32_t *dy) {
+  plan_xform(s->xform[i], xform_res[i], dx, dy);
+}
+
+static accel_t g_accel;
+static fusion_t g_fusion;
+
+/* Absolute output: each mouse integrated into a contact position, 0..ABS_LOGICAL_MAX.
+ * One count moves PLAN_ABS_UNITS_PER_COUNT units (times amplify); contacts start centred. */
+static uint16_t g_abs_pos[ABS_CONTACTS][2];
+static int32_t g_abs_res[ABS_CONTACTS][2];  /* sub-unit remainder, Q8 */
+static uint32_t g_abs_live;                 /* in-range (not dead) mask last sent */
+static bool g_abs_dirty;
+
+static void abs_reset(void) {
+  for (int i = 0; i < ABS_CONTACTS; i++) {
+    g_abs_pos[i][0] = g_abs_pos[i][1] = (ABS_LOGICAL_MAX + 1) / 2;
+    g_abs_res[i][0] = g_abs_res[i][1] = 0;
+  }
+  g_abs_live = 0;
+  g_abs_dirty = true;
+}
+
+static void abs_move(int i, int axis, int32_t d, int32_t gain_q8) {
+  int32_t units = plan_abs_units(d, gain_q8, &g_abs_res[i][axis]);
+  if (units == 0) return;
+  int32_t p = (int32_t)g_abs_pos[i][axis] + units;
+  if (p < 0) p = 0;
+  if (p > ABS_LOGICAL_MAX) p = ABS_LOGICAL_MAX;
+  if (p != g_abs_pos[i][axis]) {
+    g_abs_pos[i][axis] = (uint16_t)p;
+    g_abs_dirty = true;
+  }
+}
+
+/* Output layout in use: the one the host enumerated. A settings change that needs a
+ * different layout re-enumerates (usb_profile_poll), and applies once that is done. */
+static uint8_t output_mode_now(void) {
+  return usb_output_mode();
+}
+
+/* Disconnect and reconnect when the settings call for a different descriptor profile,
+ * so the host only polls the interfaces in use. */
+#define USB_REENUM_MS  50
+static void usb_profile_poll(void) {
+  static bool disconnected;
+  static uint32_t since;
+  if (disconnected) {
+    if (board_millis() - since >= USB_REENUM_MS) {
+      tud_connect();
+      disconnected = false;
     }
+  } else if (usb_profile_stale()) {
+    tud_disconnect();
+    disconnected = true;
+    since = board_millis();
   }
 }
 
 static void inputs_reset(void) {
   memset(g_mice, 0, sizeof(g_mice));
-  g_combined_dx = g_combined_dy = 0;
-  g_combined_buttons = 0;
+  memset(wheel_res, 0, sizeof(wheel_res));
   g_combined_wheel = 0;
-  g_has_report = false;
-}
-
-/* 2-ball logic: compute one axis from A and B (signed 8-bit). Returns combined value. */
-static int32_t logic2_axis(uint8_t mode, int8_t A, int8_t B) {
-  int32_t a = (int32_t)A, b = (int32_t)B;
-  int32_t aa = a < 0 ? -a : a, ab = b < 0 ? -b : b;
-  switch (mode) {
-    case LOGIC_MODE_2_MIN:  return aa <= ab ? a : b;
-    case LOGIC_MODE_2_AND:
-      if (a == 0 || b == 0) return 0;
-      if ((a > 0) != (b > 0)) return 0;
-      return aa <= ab ? a : b;
-    case LOGIC_MODE_2_OR:   return a + b;
-    case LOGIC_MODE_2_XOR:
-      if (a == 0) return b;
-      if (b == 0) return a;
-      return a - b;
-    case LOGIC_MODE_2_NAND:
-      if (a != 0 && b != 0) return 0;
-      return a + b;
-    case LOGIC_MODE_2_NOR:  return 0;
-    case LOGIC_MODE_2_XNOR:
-      if (a == 0 && b == 0) return 0;
-      if (a == 0) return b;
-      if (b == 0) return a;
-      if ((a > 0) != (b > 0)) return 0;
-      return (a + b) / 2;
-    default: return a + b;
-  }
-}
-
-static void aggregate_and_amplify(void) {
-  int32_t dx = 0, dy = 0;
-  const settings_t *s = settings_get();
-  int n = get_num_mice();
-  uint8_t lm = s->logic_mode;
+  g_combined_pan = 0;
+  for (int i = 0; i < CFG_TUD_HID; i++)
+    coalesce_reset(&g_out[i]);
+  fusion_reset(&g_fusion);
+  liveness_reset();
+  abs_reset();
+  memset(g_out_stamp, 0, sizeof(g_out_stamp));
+  memset(g_inflight, 0, sizeof(g_inflight));
+  profiler_reset(board_millis());
+}
 
-  if (lm == LOGIC_MODE_SUM) {
-    for (int i = 0; i < n; i++) {
-      dx += g_mice[i].dx;
-      dy += g_mice[i].dy;
-    }
-  } else if (lm == LOGIC_MODE_AVERAGE) {
-    for (int i = 0; i < n; i++) {
-      dx += g_mice[i].dx;
-      dy += g_mice[i].dy;
-    }
-    if (n > 0) {
-      dx /= n;
-      dy /= n;
-    }
-  } else if (lm == LOGIC_MODE_MAX) {
-    int32_t best_dx = 0, best_dy = 0;
-    int32_t best_adx = 0, best_ady = 0;
-    for (int i = 0; i < n; i++) {
-      int32_t adx = (int32_t)g_mice[i].dx;
-      int32_t ady = (int32_t)g_mice[i].dy;
-      if (adx < 0) adx = -adx;
-      if (ady < 0) ady = -ady;
-      if (adx >= best_adx) { best_adx = adx; best_dx = (int32_t)g_mice[i].dx; }
-      if (ady >= best_ady) { best_ady = ady; best_dy = (int32_t)g_mice[i].dy; }
-    }
-    dx = best_dx;
-    dy = best_dy;
-  } else if (lm >= LOGIC_MODE_2_MIN && lm <= LOGIC_MODE_2_XNOR) {
-    dx = logic2_axis(lm, g_mice[0].dx, g_mice[1].dx);
-    dy = logic2_axis(lm, g_mice[0].dy, g_mice[1].dy);
-  } else {
-    for (int i = 0; i < n; i++) {
-      dx += g_mice[i].dx;
-      dy += g_mice[i].dy;
-    }
+/* Combine all mice into one delta: per-mouse transform, then the logic stage. */
+static void aggregate(int32_t *out_dx, int32_t *out_dy) {
+  const plan_t *p = &g_plan;
+  int n = p->num_mice;
+
+  /* Per-mouse transform first, so every logic mode sees rotated/scaled inputs */
+  int32_t mx[NUM_MICE_MAX], my[NUM_MICE_MAX];
+  for (int i = 0; i < n; i++) {
+    mx[i] = g_mice[i].dx;
+    my[i] = g_mice[i].dy;
+    if (p->xform_mask & (1u << i))
+      xform_apply(&g_cfg, i, &mx[i], &my[i]);
   }
 
-  dx = (int32_t)((float)dx * s->amplify);
-  dy = (int32_t)((float)dy * s->amplify);
-  if (dx > 127) dx = 127;
-  if (dx < -128) dx = -128;
-  if (dy > 127) dy = 127;
-  if (dy < -128) dy = -128;
-  g_combined_dx = (int16_t)dx;
-  g_combined_dy = (int16_t)dy;
-  g_has_report = (dx != 0 || dy != 0 || g_combined_wheel != 0 || g_combined_buttons != 0);
+  uint32_t live = p->needs_live ? liveness_mask(n, board_millis(), g_cfg.stale_ms) : 0;
+  if (p->logic)
+    p->logic(p, mx, my, live, out_dx, out_dy);
+  else
+    fusion_step(&g_fusion, mx, my, n, live, out_dx, out_dy);
+}
+
+/* Combined mode: the aggregate, accelerated and amplified. */
+static void aggregate_and_amplify(int32_t *out_dx, int32_t *out_dy) {
+  const plan_t *p = &g_plan;
+  int32_t dx, dy;
+  aggregate(&dx, &dy);
+
+  if (p->accel_on) {
+    if (g_accel.version != p->version)
+      accel_build(&g_accel, &g_cfg, p->version);
+    accel_apply(&g_accel, &dx, &dy, board_millis());
+  }
+
+  *out_dx = plan_amplify(p, dx);
+  *out_dy = plan_amplify(p, dy);
 }
 
 #define UART_CONFIG_SYNC1  0x55
 #define UART_CONFIG_SYNC2  0xCF
 #define UART_CONFIG_CMD    0x01
 
-/* Process one byte of config packet (0x55 0xCF 0x01 + 8 bytes). Call from UART or USB CDC. */
-static void config_process_byte(uint8_t b) {
+#define UART_CONFIG_CMD_XFORM  0x02
+#define UART_CONFIG_CMD_ACCEL  0x03
+#define UART_CONFIG_CMD_STALE   0x04
+#define UART_CONFIG_CMD_BUTTONS 0x05
+#define UART_CONFIG_CMD_QUAD    0x06
+#define UART_CONFIG_CMD_QUAD_FILTER 0x07
+#define UART_CONFIG_CMD_QUAD_RATE   0x08
+#define UART_CONFIG_CMD_SLOT_SOURCES 0x09
+#define UART_CONFIG_CMD_CASCADE 0x0A
+#define UART_CONFIG_CMD_STATUS  0x10
+#define UART_CONFIG_CMD_PROFILE_RESET 0x11
+#define UART_CONFIG_CMD_TELEMETRY     0x12
+
+/* Status reply: 0x55 0xCF 0x90 then sections (tag, len, data), ending with tag 0xFF len 0. */
+#define STATUS_REPLY           0x90
+#define STATUS_TAG_INFO        0x01  /* uptime_ms(4), settings version(4), num_mice, logic, output_mode */
+#define STATUS_TAG_LIVENESS    0x02  /* n, then n x (state, motion_age_ms(2), rate_hz(2)) */
+#define STATUS_TAG_LATENCY     0x03  /* output mode in use, elapsed_ms(4), frames(4), reports(4),
+                                        samples(4), max_us(4), PROFILER_BUCKETS x count(4) */
+#define STATUS_TAG_RAW_OUT     0x04  /* raw HID OUT frames(4), sequence gaps(4) */
+#define STATUS_TAG_QUAD        0x05  /* sampler, edge IRQs(4), avg cycles per IRQ(4), max cycles(4), clk_sys Hz(4),
+                                        filter taps, n, n x illegal steps(4) for X then Y,
+                                        timer sampler rate Hz(4) (0 unless quad_sampler = timer), ceiling Hz(4) */
+#define STATUS_TAG_SPI         0x06  /* sensors found (mask), bursts(4), bad bursts(4), lifted (mask) */
+#define STATUS_TAG_CASCADE     0x07  /* cascade_mode, cascade_slot, frames received(4), bad(4), frames sent(4),
+                                        last hops, last age_us(4), max age_us(4) */
+#define STATUS_TAG_FRAME       0x08  /* locked to SOF, lead_us(2), SOF period ppm(4, signed), SOFs(4), locks(4),
+                                        intervals(4), mean/max jitter_us(4+4), mean/max late_us(4+4),
+                                        PROFILER_JITTER_BUCKETS x count(4) */
+#define STATUS_TAG_END         0xFF
+
+/* Section payload lengths, and the longest reply: header, every section at the most
+ * mice (SPI included), end marker. */
+#define STATUS_LEN_INFO        11
+#define STATUS_LEN_LIVENESS(n) (1 + (n) * 5)
+#define STATUS_LEN_LATENCY     (21 + PROFILER_BUCKETS * 4)
+#define STATUS_LEN_RAW_OUT     8
+#define STATUS_LEN_QUAD(nq)    (27 + (nq) * 8)
+#define STATUS_LEN_SPI         10
+#define STATUS_LEN_CASCADE     23
+#define STATUS_LEN_FRAME       (35 + PROFILER_JITTER_BUCKETS * 4)
+#define STATUS_SECTIONS        9   /* counting the end marker */
+#define STATUS_REPLY_LEN_MAX   (3 + STATUS_SECTIONS * 2 + STATUS_LEN_INFO + STATUS_LEN_LIVENESS(NUM_MICE_MAX) + \
+                                STATUS_LEN_LATENCY + STATUS_LEN_RAW_OUT + STATUS_LEN_QUAD(QUAD_MICE) + \
+                                STATUS_LEN_SPI + STATUS_LEN_CASCADE + STATUS_LEN_FRAME)
+
+/* Payload length for a config command, or -1 if the command is unknown. */
+static int config_payload_len(uint8_t cmd) {
+  switch (cmd) {
+    case UART_CONFIG_CMD:        return 8;
+    case UART_CONFIG_CMD_XFORM:  return 10;
+    case UART_CONFIG_CMD_ACCEL:  return 8;
+    case UART_CONFIG_CMD_STALE:  return 3;
+    case UART_CONFIG_CMD_BUTTONS: return 2;
+    case UART_CONFIG_CMD_QUAD:   return 2;
+    case UART_CONFIG_CMD_QUAD_FILTER: return 2;
+    case UART_CONFIG_CMD_QUAD_RATE: return 2;
+    case UART_CONFIG_CMD_SLOT_SOURCES: return UART_CONFIG_SLOTS + 1;
+    case UART_CONFIG_CMD_CASCADE: return 3;
+    case UART_CONFIG_CMD_STATUS: return 0;
+    case UART_CONFIG_CMD_PROFILE_RESET: return 0;
+    case UART_CONFIG_CMD_TELEMETRY: return 1;
+    default:                     return -1;
+  }
+}
+
+static void status_section(uint8_t tag, const uint8_t *data, uint8_t len) {
+  uint8_t hdr[2] = { tag, len };
+  tud_cdc_write(hdr, 2);
+  if (len > 0)
+    tud_cdc_write(data, len);
+}
+
+/* Answer a status query over USB CDC. See scripts/query_status.py. */
+static void status_reply(void) {
+  if (!tud_cdc_connected()) return;
+  const settings_t *s = &g_cfg;
+  uint32_t now = board_millis();
+  int n = get_num_mice(), nq = quad_mice();
+  uint8_t buf[STATUS_LEN_LATENCY];   /* the longest section */
+  _Static_assert(STATUS_LEN_LIVENESS(NUM_MICE_MAX) <= sizeof(buf), "liveness section too long");
+  _Static_assert(STATUS_LEN_QUAD(QUAD_MICE) <= sizeof(buf), "quadrature section too long");
+  _Static_assert(STATUS_LEN_FRAME <= sizeof(buf), "frame clock section too long");
+
+  static const uint8_t head[3] = { UART_CONFIG_SYNC1, UART_CONFIG_SYNC2, STATUS_REPLY };
+  tud_cdc_write(head, sizeof(head));
+
+  put_u32(buf, now);
+  put_u32(buf + 4, s->version);
+  buf[8] = (uint8_t)n;
+  buf[9] = s->logic_mode;
+  buf[10] = s->output_mode;
+  status_section(STATUS_TAG_INFO, buf, STATUS_LEN_INFO);
+
+  buf[0] = (uint8_t)n;
+  for (int i = 0; i < n; i++) {
+    const liveness_slot_t *l = liveness_get(i);
+    uint32_t age = l->moved ? now - l->last_active_ms : 0xFFFF;
+    buf[1 + i * 5] = liveness_state(i, now, s->stale_ms);
+    put_u16(buf + 2 + i * 5, age > 0xFFFF ? 0xFFFF : age);
+    put_u16(buf + 4 + i * 5, liveness_rate_hz(i));
+  }
+  status_section(STATUS_TAG_LIVENESS, buf, (uint8_t)STATUS_LEN_LIVENESS(n));
+
+  const profiler_stats_t *p = profiler_get();
+  buf[0] = g_out_mode;
+  put_u32(buf + 1, now - p->start_ms);
+  put_u32(buf + 5, p->frames);
+  put_u32(buf + 9, p->reports);
+  put_u32(buf + 13, p->samples);
+  put_u32(buf + 17, p->max_us);
+  for (int b = 0; b < PROFILER_BUCKETS; b++)
+    put_u32(buf + 21 + b * 4, p->hist[b]);
+  status_section(STATUS_TAG_LATENCY, buf, STATUS_LEN_LATENCY);
+
+  put_u32(buf, g_raw_out.frames);
+  put_u32(buf + 4, g_raw_out.gaps);
+  status_section(STATUS_TAG_RAW_OUT, buf, STATUS_LEN_RAW_OUT);
+
+  uint32_t saved = save_and_disable_interrupts();
+  uint32_t irqs = g_quad_irqs;
+  uint64_t cycles = g_quad_irq_cycles;
+  uint32_t cycles_max = g_quad_irq_cycles_max;
+  uint32_t illegal[QUAD_MICE][2];
+  memcpy(illegal, g_quad.illegal, sizeof(illegal));
+  uint32_t period = g_quad_rate.period_us;
+  restore_interrupts(saved);
+  buf[0] = g_quad_sampler;
+  put_u32(buf + 1, irqs);
+  put_u32(buf + 5, irqs ? (uint32_t)(cycles / irqs) : 0);
+  put_u32(buf + 9, cycles_max);
+  put_u32(buf + 13, clock_get_hz(clk_sys));
+  buf[17] = g_quad_filter.taps;
+  buf[18] = (uint8_t)nq;
+  for (int i = 0; i < nq; i++) {
+    put_u32(buf + 19 + i * 8, illegal[i][0]);
+    put_u32(buf + 23 + i * 8, illegal[i][1]);
+  }
+  bool timer = g_quad_sampler == SETTINGS_QUAD_TIMER && period > 0;
+  put_u32(buf + 19 + nq * 8, timer ? 1000000u / period : 0);
+  put_u32(buf + 23 + nq * 8, g_plan.quad_rate_max_hz);
+  status_section(STATUS_TAG_QUAD, buf, (uint8_t)STATUS_LEN_QUAD(nq));
+
+  if (g_plan.sources & SETTINGS_SRC_SPI) {
+    buf[0] = g_pmw.present;
+    put_u32(buf + 1, g_pmw.bursts);
+    put_u32(buf + 5, g_pmw.bad);
+    buf[9] = g_pmw.lifted;
+    status_section(STATUS_TAG_SPI, buf, STATUS_LEN_SPI);
+  }
+
+  buf[0] = s->cascade_mode;
+  buf[1] = s->cascade_slot;
+  put_u32(buf + 2, g_cascade_rx);
+  put_u32(buf + 6, g_cascade_bad);
+  put_u32(buf + 10, g_cascade_sent);
+  buf[14] = g_cascade_hops;
+  put_u32(buf + 15, g_cascade_age_us);
+  put_u32(buf + 19, g_cascade_age_max_us);
+  status_section(STATUS_TAG_CASCADE, buf, STATUS_LEN_CASCADE);
+
+  buf[0] = g_clock.locked;
+  put_u16(buf + 1, FRAME_LEAD_US);
+  put_u32(buf + 3, (uint32_t)frameclock_ppm(&g_clock));
+  put_u32(buf + 7, g_clock.sofs);
+  put_u32(buf + 11, g_clock.locks);
+  put_u32(buf + 15, p->intervals);
+  put_u32(buf + 19, p->intervals ? (uint32_t)(p->jitter_sum_us / p->intervals) : 0);
+  put_u32(buf + 23, p->jitter_max_us);
+  put_u32(buf + 27, p->frames ? (uint32_t)(p->late_sum_us / p->frames) : 0);
+  put_u32(buf + 31, p->late_max_us);
+  for (int b = 0; b < PROFILER_JITTER_BUCKETS; b++)
+    put_u32(buf + 35 + b * 4, p->jitter_hist[b]);
+  status_section(STATUS_TAG_FRAME, buf, STATUS_LEN_FRAME);
+
+  status_section(STATUS_TAG_END, NULL, 0);
+  tud_cdc_write_flush();
+}
+
+static void config_apply(uint8_t cmd, const uint8_t *p) {
+  bool save = false;
+  switch (cmd) {
+    case UART_CONFIG_CMD:
+      settings_apply_uart(p[0], p[1], p[2], p[3], p[4],
+                          (uint16_t)p[5] | ((uint16_t)p[6] << 8));
+      save = p[7] != 0;
+      break;
+    case UART_CONFIG_CMD_XFORM:
+      settings_set_xform(p[0],
+                         get_s16(p + 1), get_s16(p + 3), get_s16(p + 5), get_s16(p + 7));
+      if (p[0] < NUM_MICE_MAX)
+        xform_res[p[0]][0] = xform_res[p[0]][1] = 0;
+      save = p[9] != 0;
+      break;
+    case UART_CONFIG_CMD_ACCEL:
+      settings_set_accel(p[0], p[1], p[2],
+                         (uint16_t)p[3] | ((uint16_t)p[4] << 8),
+                         (uint16_t)p[5] | ((uint16_t)p[6] << 8));
+      save = p[7] != 0;
+      break;
+    case UART_CONFIG_CMD_STALE:
+      settings_set_stale_ms((uint16_t)p[0] | ((uint16_t)p[1] << 8));
+      save = p[2] != 0;
+      break;
+    case UART_CONFIG_CMD_BUTTONS:
+      settings_set_button_min_hold(p[0]);
+      save = p[1] != 0;
+      break;
+    case UART_CONFIG_CMD_QUAD:
+      settings_set_quad_sampler(p[0]);
+      save = p[1] != 0;
+      break;
+    case UART_CONFIG_CMD_QUAD_FILTER:
+      settings_set_quad_filter(p[0]);
+      save = p[1] != 0;
+      break;
+    case UART_CONFIG_CMD_QUAD_RATE:
+      settings_set_quad_rate_max(p[0]);
+      save = p[1] != 0;
+      break;
+    case UART_CONFIG_CMD_SLOT_SOURCES:
+      settings_set_slot_sources(p);
+      save = p[UART_CONFIG_SLOTS] != 0;
+      break;
+    case UART_CONFIG_CMD_CASCADE:
+      settings_set_cascade(p[0], p[1]);
+      save = p[2] != 0;
+      break;
+    case UART_CONFIG_CMD_STATUS:
+      status_reply();
+      break;
+    case UART_CONFIG_CMD_PROFILE_RESET:
+      profiler_reset(board_millis());
+      quad_stats_reset();
+      g_cascade_age_max_us = 0;
+      break;
+    case UART_CONFIG_CMD_TELEMETRY:
+      if (p[0] && !telemetry_enabled())
+        telemetry_reset();
+      telemetry_enable(p[0] != 0);
+      break;
+    default:
+      break;
+  }
+  if (save)
+    settings_save_to_flash();
+  settings_refresh();   /* this loop is the only writer: pick up its own change now */
+}
+
+/* Process one byte of config packet (0x55 0xCF <cmd> + payload). Call from UART or USB CDC.
+ * Returns true if the byte belonged to a config packet. */
+static bool config_process_byte(uint8_t b) {
   if (uart_config_state == 1) {
     uart_config_state = (b == UART_CONFIG_SYNC2) ? 2 : 0;
-    return;
+    return uart_config_state != 0;
   }
   if (uart_config_state == 2) {
-    uart_config_state = (b == UART_CONFIG_CMD) ? 3 : 0;
-    if (uart_config_state == 3) uart_config_len = 0;
-    return;
+    int len = config_payload_len(b);
+    uart_config_state = 0;
+    if (len == 0) {
+      config_apply(b, uart_config_buf);
+    } else if (len > 0) {
+      uart_config_state = 3;
+      uart_config_cmd = b;
+      uart_config_len = 0;
+    }
+    return len >= 0;
   }
   if (uart_config_state == 3) {
     uart_config_buf[uart_config_len++] = b;
-    if (uart_config_len >= UART_CONFIG_PAYLOAD_LEN) {
+    if (uart_config_len >= config_payload_len(uart_config_cmd)) {
       uart_config_state = 0;
-      settings_apply_uart(
-        uart_config_buf[0],
-        uart_config_buf[1],
-        uart_config_buf[2],
-        uart_config_buf[3],
-        uart_config_buf[4],
-        (uint16_t)uart_config_buf[5] | ((uint16_t)uart_config_buf[6] << 8)
-      );
-      if (uart_config_buf[7] != 0)
-        settings_save_to_flash();
+      config_apply(uart_config_cmd, uart_config_buf);
     }
-    return;
+    return true;
   }
   if (b == UART_CONFIG_SYNC1) {
     uart_config_state = 1;
+    return true;
+  }
+  return false;
+}
+
+/* Add one host record to mouse i; the input happened at origin_us. */
+static void input_add_at(int i, uint8_t bt, int16_t dx, int16_t dy, int16_t wh, int16_t pan,
+                         uint32_t origin_us, uint32_t now_ms) {
+  g_mice[i].dx    = add_s16(g_mice[i].dx, dx);
+  g_mice[i].dy    = add_s16(g_mice[i].dy, dy);
+  g_mice[i].wheel = add_s16(g_mice[i].wheel, wh);
+  g_mice[i].pan   = add_s16(g_mice[i].pan, pan);
+  g_combined_wheel = add_s16(g_combined_wheel, wh);
+  g_combined_pan   = add_s16(g_combined_pan, pan);
+  if (dx != 0 || dy != 0 || wh != 0 || pan != 0 || bt != g_mice[i].buttons)
+    input_stamp_at(i, origin_us);
+  buttons_set(i, bt);
+  liveness_mark(i, dx != 0 || dy != 0 || bt != 0 || wh != 0 || pan != 0, now_ms);
+}
+
+/* Apply count slot-addressed records (UART_V2_RECORD_LEN bytes each), as carried by
+ * the 0xAB packet and the raw HID OUT frame. */
+static void input_records(const uint8_t *rec, int count) {
+  uint32_t slots = g_plan.src_slots[PLAN_SRC_HOST];
+  uint32_t now = board_millis(), now_us = time_us_32();
+  for (int k = 0; k < count; k++) {
+    host_record_t r;
+    if (!host_record(rec, k, slots, &r)) continue;
+    input_add_at(r.slot, r.buttons & 0x1F, r.dx, r.dy, r.wheel, r.pan, now_us, now);
+  }
+}
+
+/* Cascade frame from the Pico below (len bytes, sync included), received over a UART
+ * at baud (0 = USB CDC, no wire time). Its input was moved age_us before the frame
+ * was sent, plus the time the frame took on the wire. The head of the chain adds the
+ * records to its host slots, stamped with that time; a node that cascades itself
+ * passes them on up. */
+static void cascade_rx_frame(const uint8_t *f, int len, uint32_t baud) {
+  if (!cascade_check(f, len)) {
+    g_cascade_bad++;
     return;
   }
+  uint32_t age = cascade_age_us(f) + cascade_wire_us(len, baud);
+  uint32_t now = board_millis(), origin_us = time_us_32() - age;
+  uint8_t hops = cascade_hops(f);
+  g_cascade_rx++;
+  g_cascade_hops = hops;
+  g_cascade_age_us = age;
+  if (age > g_cascade_age_max_us)
+    g_cascade_age_max_us = age;
+
+  uint32_t slots = g_plan.src_slots[PLAN_SRC_HOST];
+  for (int k = 0; k < cascade_count(f); k++) {
+    cascade_record_t r;
+    cascade_record(f, k, &r);
+    int16_t dx = r.scroll ? 0 : r.a, dy = r.scroll ? 0 : r.b;
+    int16_t wh = r.scroll ? r.a : 0, pan = r.scroll ? r.b : 0;
+    if (g_plan.cascade) {
+      cascade_tx_add(&g_cascade_tx, r.slot, r.buttons, dx, dy, wh, pan, origin_us, hops);
+      continue;
+    }
+    int i = r.slot;
+    if (i >= NUM_MICE_MAX || !(slots & (1u << i))) continue;
+    input_add_at(i, r.buttons & 0x1F, dx, dy, wh, pan, origin_us, now);
+  }
 }
 
-static void uart_process_byte(uint8_t b) {
-  config_process_byte(b);
-  if (uart_config_state != 0)
+#if USB_HOST_PIO
+/* USB host mice: each HID interface that parses as a mouse takes the first free slot
+ * when it mounts (below num_mice) and gives it back when it goes. Interfaces that
+ * are still in boot protocol are read with the boot layout; the layout is compiled
+ * once, at mount, into the plan each report is read with. */
+typedef struct {
+  uint8_t dev_addr;    /* 0 = slot free */
+  uint8_t instance;
+  hid_mouse_plan_t plan;
+} usb_mouse_t;
+
+static usb_mouse_t g_usb_mice[NUM_MICE_MAX];
+
+static int usb_mouse_slot(uint8_t dev_addr, uint8_t instance) {
+  for (int i = 0; i < NUM_MICE_MAX; i++)
+    if (g_usb_mice[i].dev_addr == dev_addr && g_usb_mice[i].instance == instance)
+      return i;
+  return -1;
+}
+
+static void usb_host_init(void) {
+  pio_usb_configuration_t cfg = PIO_USB_DEFAULT_CONFIG;
+  cfg.pin_dp = USB_HOST_DP_PIN;
+  tuh_configure(BOARD_TUH_RHPORT, TUH_CFGID_RPI_PIO_USB_CONFIGURATION, &cfg);
+  tuh_init(BOARD_TUH_RHPORT);
+}
+
+void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const *desc_report, uint16_t desc_len) {
+  hid_mouse_layout_t layout;
+  if (tuh_hid_interface_protocol(dev_addr, instance) == HID_ITF_PROTOCOL_MOUSE &&
+      tuh_hid_get_protocol(dev_addr, instance) == HID_PROTOCOL_BOOT)
+    hid_mouse_boot_layout(&layout);
+  else if (!hid_mouse_parse(desc_report, desc_len, &layout))
+    return;   /* keyboard, vendor or absolute interface */
+  uint32_t slots = g_plan.src_slots[PLAN_SRC_USB];
+  int slot = 0, n = get_num_mice();
+  while (slot < n && (g_usb_mice[slot].dev_addr != 0 || !(slots & (1u << slot))))
+    slot++;
+  if (slot == n)
+    return;   /* more mice than slots mapped to USB */
+  g_usb_mice[slot].dev_addr = dev_addr;
+  g_usb_mice[slot].instance = instance;
+  hid_mouse_compile(&layout, &g_usb_mice[slot].plan);
+  tuh_hid_receive_report(dev_addr, instance);
+}
+
+void tuh_hid_umount_cb(uint8_t dev_addr, uint8_t instance) {
+  int i = usb_mouse_slot(dev_addr, instance);
+  if (i < 0) return;
+  g_usb_mice[i].dev_addr = 0;
+  buttons_set(i, 0);   /* release anything held when it was unplugged */
+}
+
+void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance, uint8_t const *report, uint16_t len) {
+  int i = usb_mouse_slot(dev_addr, instance);
+  hid_mouse_report_t r;
+  if (i >= 0 && (g_plan.src_slots[PLAN_SRC_USB] & (1u << i)) &&
+      hid_mouse_extract(&g_usb_mice[i].plan, report, len, &r)) {
+    uint8_t bt = r.buttons & 0x1F;
+    int32_t wh = (int32_t)r.wheel * WHEEL_HIRES_MULT, pan = (int32_t)r.pan * WHEEL_HIRES_MULT;
+    bool moved = r.dx != 0 || r.dy != 0 || wh != 0 || pan != 0;
+    g_mice[i].dx    = add_s16(g_mice[i].dx, r.dx);
+    g_mice[i].dy    = add_s16(g_mice[i].dy, r.dy);
+    g_mice[i].wheel = add_s16(g_mice[i].wheel, wh);
+    g_mice[i].pan   = add_s16(g_mice[i].pan, pan);
+    g_combined_wheel = add_s16(g_combined_wheel, wh);
+    g_combined_pan   = add_s16(g_combined_pan, pan);
+    if (moved || bt != g_mice[i].buttons)
+      input_stamp(i);
+    buttons_set(i, bt);
+    liveness_mark(i, moved || bt != 0, board_millis());
+  }
+  tuh_hid_receive_report(dev_addr, instance);
+}
+#endif
+
+static void uart_v2_packet(const uint8_t *p) {
+  int count = p[1];
+  int len = UART_V2_LEN(count);
+  uint8_t x = 0;
+  for (int k = 1; k < len - 1; k++)
+    x ^= p[k];
+  if (x != p[len - 1]) return;
+  input_records(p + 2, count);
+}
+
+/* Raw HID OUT frame (vendor interface, one 64-byte transfer): the records are applied
+ * straight from the endpoint buffer. */
+static void raw_out_frame(const uint8_t *p, uint16_t len) {
+  int count = host_raw_frame(&g_raw_out, p, len);
+  if (count > 0)
+    input_records(p + HOST_RAW_HEADER_LEN, count);
+}
+
+/* One byte from the host link: UART at baud, or USB CDC (baud 0). */
+static void uart_process_byte(uint8_t b, uint32_t baud) {
+  /* Config packets are only recognised between mouse packets, so a 0x55 inside
+   * mouse data is not taken for a config header */
+  if (uart_len == 0 && config_process_byte(b))
     return;
   /* Mouse packet on UART */
   if (uart_len == 0) {
-    if (b == UART_SYNC) {
+    if (b == UART_SYNC || b == UART_SYNC_V2 || b == CASCADE_SYNC) {
       uart_buf[0] = b;
       uart_len = 1;
     }
@@ -290,131 +1169,515 @@ static void uart_process_byte(uint8_t b) {
   }
 
   uart_buf[uart_len++] = b;
+  if (uart_buf[0] == UART_SYNC_V2) {
+    if (uart_len == 2 && b > NUM_MICE_MAX)
+      uart_len = 0;
+    else if (uart_len >= 2 && uart_len >= UART_V2_LEN(uart_buf[1])) {
+      uart_len = 0;
+      uart_v2_packet(uart_buf);
+    }
+    return;
+  }
+  if (uart_buf[0] == CASCADE_SYNC) {
+    if (uart_len == 2 && b > CASCADE_RECORDS_MAX)
+      uart_len = 0;
+    else if (uart_len >= 2 && uart_len >= CASCADE_LEN(uart_buf[1])) {
+      uart_len = 0;
+      cascade_rx_frame(uart_buf, CASCADE_LEN(uart_buf[1]), baud);
+    }
+    return;
+  }
   if (uart_len >= UART_PACKET_LEN) {
     uart_len = 0;
     if (uart_buf[0] != UART_SYNC) return;
 
-    int n = get_num_mice();
-    uint8_t bt = uart_buf[1 + NUM_MICE_MAX * 2] & 0x07;
-    int8_t wh = (int8_t)uart_buf[1 + NUM_MICE_MAX * 2 + 1];
-    for (int i = 0; i < n; i++) {
-      g_mice[i].dx      = (int8_t)uart_buf[1 + i * 2 + 0];
-      g_mice[i].dy      = (int8_t)uart_buf[1 + i * 2 + 1];
-      g_mice[i].buttons = bt;
-      g_mice[i].wheel   = wh;
+    uint32_t slots = g_plan.src_slots[PLAN_SRC_HOST];
+    if (!slots) return;
+    uint32_t now = board_millis();
+    uint8_t bt = uart_buf[1 + UART_PACKET_MICE * 2] & 0x07;
+    int16_t wh = (int16_t)((int8_t)uart_buf[1 + UART_PACKET_MICE * 2 + 1] * WHEEL_HIRES_MULT);
+    for (int i = 0; i < UART_PACKET_MICE && i < NUM_MICE_MAX; i++) {
+      if (!(slots & (1u << i))) continue;
+      int8_t dx = (int8_t)uart_buf[1 + i * 2 + 0];
+      int8_t dy = (int8_t)uart_buf[1 + i * 2 + 1];
+      g_mice[i].dx       = add_s16(g_mice[i].dx, dx);
+      g_mice[i].dy       = add_s16(g_mice[i].dy, dy);
+      g_mice[i].wheel    = add_s16(g_mice[i].wheel, wh);
+      if (dx != 0 || dy != 0 || wh != 0 || bt != g_mice[i].buttons)
+        input_stamp(i);
+      buttons_set(i, bt);
+      liveness_mark(i, dx != 0 || dy != 0 || bt != 0 || wh != 0, now);
     }
-    g_combined_buttons = bt;
-    g_combined_wheel   = wh;
+    g_combined_wheel    = add_s16(g_combined_wheel, wh);
   }
 }
 
+static void uart_pins_init(void) {
+  uart_init(UART_ID, UART_BAUD);
+  gpio_set_function(UART_TX_PIN, GPIO_FUNC_UART);
+  gpio_set_function(UART_RX_PIN, GPIO_FUNC_UART);
+}
+
 static void uart_poll(void) {
   while (uart_is_readable(UART_ID)) {
     uint8_t c = (uint8_t)uart_getc(UART_ID);
-    uart_process_byte(c);
+    uart_process_byte(c, UART_BAUD);
   }
 }
 
-static void send_mouse_report(void) {
-  const settings_t *s = settings_get();
-  uint8_t out_mode = s->output_mode;
+static void quadrature_source_poll(void) {
+  quad_sampler_apply(g_plan.quad_sampler, g_plan.quad_filter, g_plan.quad_rate_max_hz);
+  quadrature_poll();
+}
 
-  if (out_mode == SETTINGS_OUTPUT_SEPARATE) {
-    /* Six separate mice: send each g_mice[i] to HID instance i. */
-    int n = get_num_mice();
+/* Quadrature has left the plan, or num_mice changed under it: with nothing polling it,
+ * an edge IRQ or sampling timer would go on counting into g_quad, so fall back to
+ * main-loop sampling, take the IRQ handler off the pins and hand them back (the SPI
+ * chip selects are on them). What was counted is dropped. quadrature_init sets the
+ * pins up again, and the next quadrature_source_poll the configured sampler. */
+static void quadrature_stop(void) {
+  quad_sampler_apply(SETTINGS_QUAD_POLL, g_quad_filter.taps, g_quad_rate_max_hz);
+  if (g_quad_irq_installed) {
+    gpio_remove_raw_irq_handler_masked(g_quad_pins << QUAD_PIN_BASE, quad_irq);
+    memset(g_quad_irq_ack, 0, sizeof(g_quad_irq_ack));
+    g_quad_irq_installed = false;
+  }
+  for (int b = 0; b < QUAD_BITS; b++)
+    if (g_quad_pins & (1u << b)) {
+      gpio_disable_pulls((unsigned)(QUAD_PIN_BASE + b));
+      gpio_deinit((unsigned)(QUAD_PIN_BASE + b));
+    }
+  g_quad_pins = 0;
+  quad_reset(&g_quad, 0);
+  g_quad_stamped = 0;
+}
+
+/* Input sources: each is set up when the plan starts running it (at boot for the
+ * configured input mode), polled every main loop pass while it does, and stopped when
+ * it leaves the plan. A source adds only into the slots its plan mask gives it
+ * (g_plan.src_slots), so sources sharing a build never feed the same mouse unless
+ * slot_sources says so. USB CDC and raw HID packets come in through USB device
+ * handling whatever the input mode; the host entry here is the UART pins. */
+typedef struct {
+  uint8_t src;           /* SETTINGS_SRC_* */
+  void (*init)(void);
+  void (*poll)(void);
+  void (*stop)(void);    /* stop work that runs outside poll, release pins (NULL: none) */
+} input_source_t;
+
+static const input_source_t g_sources[] = {
+  { SETTINGS_SRC_SPI,  spi_sensors_init, spi_sensors_poll,       spi_sensors_stop },   /* slow power-up: first */
+  { SETTINGS_SRC_HOST, uart_pins_init,   uart_poll,              NULL },
+  { SETTINGS_SRC_QUAD, quadrature_init,  quadrature_source_poll, quadrature_stop },
+#if USB_HOST_PIO
+  { SETTINGS_SRC_USB,  usb_host_init,    tuh_task,               NULL },   /* reports arrive in tuh_hid_report_received_cb */
+#endif
+};
+#define NUM_SOURCES  (int)(sizeof(g_sources) / sizeof(g_sources[0]))
+
+static plan_sources_t g_sources_up;
+
+/* Stop the sources the plan no longer runs, then set up the ones it starts running.
+ * Quadrature sets up pins for num_mice encoders, so a num_mice change restarts it. */
+static void sources_apply(void) {
+  uint8_t stop, start;
+  plan_sources_step(&g_sources_up, &g_plan, SETTINGS_SRC_QUAD, &stop, &start);
+  if (!stop && !start) return;
+  for (int k = 0; k < NUM_SOURCES; k++)
+    if ((stop & g_sources[k].src) && g_sources[k].stop)
+      g_sources[k].stop();
+  for (int k = 0; k < NUM_SOURCES; k++)
+    if (start & g_sources[k].src)
+      g_sources[k].init();
+}
+
+/* Cascade: this frame's mice go up the chain instead of to the HID output. They are
+ * transformed here (each Pico knows how its own mice sit); acceleration, amplify and
+ * the output layout are the head's. Per-slot mode sends mouse i as slot
+ * cascade_slot + i; combined mode sends the logic stage's output as one slot. */
+static void cascade_take_mice(int n) {
+  const plan_t *p = &g_plan;
+  uint32_t now_us = time_us_32();
+  if (p->cascade == SETTINGS_CASCADE_COMBINED) {
+    int32_t dx, dy;
+    uint8_t bt = 0;
+    stamp_t st = { 0 };
+    aggregate(&dx, &dy);
     for (int i = 0; i < n; i++) {
-      if (!tud_mounted() || !tud_hid_n_ready(i)) continue;
-      if (g_mice[i].dx == 0 && g_mice[i].dy == 0 && g_mice[i].wheel == 0 && g_mice[i].buttons == 0)
-        continue;
-      tud_hid_n_mouse_report(i, REPORT_ID_MOUSE,
-                            g_mice[i].buttons,
-                            g_mice[i].dx, g_mice[i].dy,
-                            g_mice[i].wheel, 0);
-      g_mice[i].dx = g_mice[i].dy = g_mice[i].wheel = 0;
-      g_mice[i].buttons = 0;
+      bt |= g_mice[i].buttons;
+      stamp_merge(&st, &g_mice[i].stamp);
     }
+    cascade_tx_add(&g_cascade_tx, p->cascade_slot, bt, dx, dy, g_combined_wheel, g_combined_pan,
+                   st.valid ? st.us : now_us, 0);
     return;
   }
+  for (int i = 0; i < n && p->cascade_slot + i < CASCADE_SLOTS; i++) {
+    int32_t dx = g_mice[i].dx, dy = g_mice[i].dy;
+    if (p->xform_mask & (1u << i))
+      xform_apply(&g_cfg, i, &dx, &dy);
+    cascade_tx_add(&g_cascade_tx, p->cascade_slot + i, g_mice[i].buttons, dx, dy,
+                   g_mice[i].wheel, g_mice[i].pan,
+                   g_mice[i].stamp.valid ? g_mice[i].stamp.us : now_us, 0);
+  }
+}
+
+/* Cascade: keep the UART TX FIFO fed from the frame being sent. The next frame is
+ * built only once the FIFO has drained, so everything that arrived meanwhile goes in
+ * it and its age field is still right when it leaves. */
+static void cascade_pump(void) {
+  if (g_cascade_pos == g_cascade_len) {
+    if (!(uart_get_hw(UART_ID)->fr & UART_UARTFR_TXFE_BITS)) return;
+    g_cascade_len = cascade_tx_frame(&g_cascade_tx, g_cascade_buf, time_us_32());
+    g_cascade_pos = 0;
+    if (g_cascade_len == 0) return;
+    g_cascade_sent++;
+  }
+  while (g_cascade_pos < g_cascade_len && uart_is_writable(UART_ID))
+    uart_putc_raw(UART_ID, (char)g_cascade_buf[g_cascade_pos++]);
+}
 
-  /* Combined: single mouse on instance 0. */
-  if (!tud_mounted() || !tud_hid_n_ready(0)) return;
-  if (!g_has_report && g_combined_dx == 0 && g_combined_dy == 0 &&
-      g_combined_wheel == 0) return;
+/* Move this frame's input into the output accumulators. Runs once per HID_POLL_MS
+ * (late_us after g_clock said so), whether or not the endpoints are ready, so
+ * per-frame stages see a steady rate. */
+static void report_frame(uint32_t late_us) {
+  const settings_t *s = &g_cfg;
+  int n = get_num_mice();
+  uint8_t mode = output_mode_now();
 
-  tud_hid_n_mouse_report(0, REPORT_ID_MOUSE,
-                         g_combined_buttons,
-                         (int8_t)g_combined_dx,
-                         (int8_t)g_combined_dy,
-                         (int8_t)g_combined_wheel,
-                         0);
+  if (mode != g_out_mode) {
+    for (int i = 0; i < CFG_TUD_HID; i++)
+      coalesce_reset(&g_out[i]);
+    memset(wheel_res, 0, sizeof(wheel_res));
+    memset(g_out_stamp, 0, sizeof(g_out_stamp));
+    g_out_mode = mode;
+    for (int i = 0; i < NUM_MICE_MAX; i++)
+      buttons_set(i, g_mice[i].buttons);
+    profiler_reset(board_millis());   /* latency stats are per layout */
+  }
+  profiler_frame(time_us_32(), FRAME_US, late_us);
 
-  g_combined_dx = g_combined_dy = 0;
-  g_combined_wheel = 0;
-  g_has_report = false;
-  memset(g_mice, 0, sizeof(g_mice));
+  telemetry_record_t rec;
+  bool tele = telemetry_enabled();
+  if (tele) {
+    memset(&rec, 0, sizeof(rec));
+    rec.time_us = time_us_32();
+    rec.num_mice = (uint8_t)n;
+    for (int i = 0; i < n; i++) {
+      if (i < TELEMETRY_MICE) {
+        rec.raw[i][0] = g_mice[i].dx;
+        rec.raw[i][1] = g_mice[i].dy;
+      }
+      rec.buttons |= g_mice[i].buttons;
+    }
+  }
+  int32_t out_dx = 0, out_dy = 0;
+
+  if (g_plan.cascade) {
+    cascade_take_mice(n);
+  } else if (mode == SETTINGS_OUTPUT_ABSOLUTE) {
+    /* One contact per mouse; wheel and pan have no equivalent and are dropped.
+     * Button edges still go through g_out[i], which carries no motion here. */
+    int32_t gain = g_plan.abs_gain_q8;
+    for (int i = 0; i < n; i++) {
+      int32_t dx = g_mice[i].dx, dy = g_mice[i].dy;
+      int o = out_slot(i);
+      if (s->xform_mask & (1u << i))
+        xform_apply(s, i, &dx, &dy);
+      abs_move(o, 0, dx, gain);
+      abs_move(o, 1, dy, gain);
+      out_dx += dx;
+      out_dy += dy;
+      stamp_merge(&g_out_stamp[o], &g_mice[i].stamp);
+    }
+    /* In range while the mouse is connected (delivering data, still or not), so a mouse
+     * at rest hovers; a shared contact is in range while any of its mice is */
+    uint32_t live = 0;
+    for (uint32_t m = liveness_present_mask(n, board_millis(), s->stale_ms); m; m >>= USB_MOUSE_OUTPUTS)
+      live |= m & ((1u << USB_MOUSE_OUTPUTS) - 1u);
+    if (live != g_abs_live) {
+      g_abs_live = live;
+      g_abs_dirty = true;
+    }
+  } else if (mode != SETTINGS_OUTPUT_COMBINED) {
+    /* Separate mice: g_mice[i] feeds output slot o = out_slot(i) (HID instance o, report
+     * ID REPORT_ID_COMPOSITE_MOUSE(o) in composite mode, record o of the raw report). */
+    for (int i = 0; i < n; i++) {
+      int32_t dx = g_mice[i].dx, dy = g_mice[i].dy;
+      int o = out_slot(i);
+      if (s->xform_mask & (1u << i))
+        xform_apply(s, i, &dx, &dy);
+      coalesce_add(&g_out[o], dx, dy, wheel_units(o, 0, g_mice[i].wheel), wheel_units(o, 1, g_mice[i].pan));
+      stamp_merge(&g_out_stamp[o], &g_mice[i].stamp);
+      out_dx += dx;
+      out_dy += dy;
+    }
+  } else {
+    /* Combined: single mouse on instance 0. */
+    int32_t dx, dy;
+    aggregate_and_amplify(&dx, &dy);
+    coalesce_add(&g_out[0], dx, dy, wheel_units(0, 0, g_combined_wheel), wheel_units(0, 1, g_combined_pan));
+    for (int i = 0; i < n; i++)
+      stamp_merge(&g_out_stamp[0], &g_mice[i].stamp);
+    out_dx = dx;
+    out_dy = dy;
+  }
+
+  if (tele) {
+    rec.out_dx = add_s16(0, out_dx);
+    rec.out_dy = add_s16(0, out_dy);
+    telemetry_push(&rec);   /* drops (and counts) if the host is behind */
+  }
+
+  for (int i = 0; i < n; i++) {
+    g_mice[i].dx = g_mice[i].dy = g_mice[i].wheel = g_mice[i].pan = 0;
+    g_mice[i].stamp.valid = false;
+  }
+  g_combined_wheel = g_combined_pan = 0;
+}
+
+/* Absolute mode: all contacts in one report, sent when a position, in-range state or
+ * queued button edge changed. Tip switch = left button, in range = mouse not dead. */
+static void send_touch_report(uint32_t now, uint8_t hold) {
+  int n = out_count(get_num_mice());
+  bool due = g_abs_dirty;
+  for (int i = 0; i < n && !due; i++)
+    due = coalesce_pending(&g_out[i], now, hold);
+  if (!due || !tud_hid_n_ready(0)) return;
+
+  uint8_t rep[TOUCH_REPORT_LEN] = { 0 };
+  g_inflight[0].valid = false;
+  for (int i = 0; i < n; i++) {
+    coalesce_report_t r;
+    uint8_t *c = rep + i * TOUCH_CONTACT_LEN;
+    coalesce_take(&g_out[i], &r, now, hold);
+    stamp_merge(&g_inflight[0], &g_out_stamp[i]);
+    g_out_stamp[i].valid = false;
+    c[0] = (uint8_t)((g_out[i].sent & 0x01) | ((g_abs_live >> i) & 1u) << 1);
+    c[1] = (uint8_t)i;
+    put_u16(c + 2, g_abs_pos[i][0]);
+    put_u16(c + 4, g_abs_pos[i][1]);
+  }
+  rep[TOUCH_REPORT_LEN - 1] = (uint8_t)n;
+  tud_hid_n_report(0, REPORT_ID_TOUCH, rep, sizeof(rep));
+  g_abs_dirty = false;
+}
+
+/* Take output slot i's next coalesced report into rep (MOUSE_REPORT_LEN bytes) and
+ * move its latency stamp to in-flight slot f. */
+static void take_slot(int i, int f, uint8_t *rep, uint32_t now, uint8_t hold) {
+  coalesce_report_t r;
+  if (!coalesce_take(&g_out[i], &r, now, hold)) {
+    memset(&r, 0, sizeof(r));
+    r.buttons = g_out[i].sent;
+  }
+  stamp_merge(&g_inflight[f], &g_out_stamp[i]);
+  if (!coalesce_pending(&g_out[i], now, hold))
+    g_out_stamp[i].valid = false;   /* else the rest keeps its (older) stamp */
+  rep[0] = r.buttons;
+  rep[1] = (uint8_t)r.dx;
+  rep[2] = (uint8_t)r.dy;
+  put_u16(rep + 3, (uint16_t)r.wheel);
+  put_u16(rep + 5, (uint16_t)r.pan);
+}
+
+/* Move queued telemetry records to USB CDC, as many as fit without blocking. The last
+ * TELEMETRY_CDC_RESERVE bytes of the CDC buffer are left for a whole status reply. */
+#define TELEMETRY_CDC_RESERVE  STATUS_REPLY_LEN_MAX
+_Static_assert(TELEMETRY_CDC_RESERVE + TELEMETRY_WIRE_LEN <= CFG_TUD_CDC_TX_BUFSIZE,
+               "CDC TX buffer too small for a status reply and a telemetry record");
+static void telemetry_drain(void) {
+  uint8_t wire[TELEMETRY_WIRE_LEN];
+  telemetry_record_t rec;
+  bool sent = false;
+  if (!tud_cdc_connected()) return;
+  while (tud_cdc_write_available() >= TELEMETRY_CDC_RESERVE + TELEMETRY_WIRE_LEN && telemetry_pop(&rec)) {
+    telemetry_encode(&rec, wire);
+    tud_cdc_write(wire, sizeof(wire));
+    sent = true;
+  }
+  if (sent)
+    tud_cdc_write_flush();
+}
+
+/* Send output slot i's next coalesced report on a HID instance. */
+static void send_slot(int i, uint8_t instance, uint8_t report_id, uint32_t now, uint8_t hold) {
+  uint8_t rep[MOUSE_REPORT_LEN];
+  g_inflight[i].valid = false;
+  take_slot(i, i, rep, now, hold);
+  tud_hid_n_report(instance, report_id, rep, sizeof(rep));
+}
+
+/* Raw: every mouse in one vendor report per free endpoint, so a whole frame is one transfer */
+static void send_raw_report(uint32_t now, uint8_t hold) {
+  int n = out_count(get_num_mice());
+  bool due = false;
+  for (int i = 0; i < n && !due; i++)
+    due = coalesce_pending(&g_out[i], now, hold);
+  if (!due || !tud_hid_n_ready(0)) return;
+
+  uint8_t rep[RAW_REPORT_LEN] = { (uint8_t)n };
+  g_inflight[0].valid = false;
+  for (int i = 0; i < n; i++)
+    take_slot(i, 0, rep + 1 + i * MOUSE_REPORT_LEN, now, hold);
+  tud_hid_n_report(0, REPORT_ID_RAW, rep, sizeof(rep));
+}
+
+/* Composite: one endpoint for all mice, so one report per free endpoint, taking
+ * the slots round-robin so a busy mouse cannot starve the others. */
+static void send_composite_report(uint32_t now, uint8_t hold) {
+  static int next;
+  int n = out_count(get_num_mice());
+  if (!tud_hid_n_ready(0)) return;
+  for (int k = 0; k < n; k++) {
+    int i = (next + k) % n;
+    if (!coalesce_pending(&g_out[i], now, hold)) continue;
+    send_slot(i, 0, (uint8_t)REPORT_ID_COMPOSITE_MOUSE(i), now, hold);
+    next = (i + 1) % n;
+    return;
+  }
+}
+
+/* Send one coalesced report on each instance that has something pending and a free endpoint. */
+static void send_mouse_report(void) {
+  if (!tud_mounted() || g_plan.cascade) {   /* cascading: buttons went up the chain */
+    for (int i = 0; i < CFG_TUD_HID; i++)
+      coalesce_reset(&g_out[i]);
+    return;
+  }
+  uint32_t now = board_millis();
+  uint8_t hold = g_cfg.button_min_hold_ms;
+  if (g_out_mode == SETTINGS_OUTPUT_ABSOLUTE) {
+    send_touch_report(now, hold);
+    return;
+  }
+  if (g_out_mode == SETTINGS_OUTPUT_COMPOSITE) {
+    send_composite_report(now, hold);
+    return;
+  }
+  if (g_out_mode == SETTINGS_OUTPUT_RAW) {
+    send_raw_report(now, hold);
+    return;
+  }
+  int count = g_out_mode == SETTINGS_OUTPUT_SEPARATE ? get_num_mice() : 1;
+  if (count > usb_profile()->hid_count)
+    count = usb_profile()->hid_count;
+  for (int i = 0; i < count; i++) {
+    if (!coalesce_pending(&g_out[i], now, hold) || !tud_hid_n_ready((uint8_t)i)) continue;
+    send_slot(i, (uint8_t)i, REPORT_ID_MOUSE, now, hold);
+  }
+}
+
+/* The host collected a report: count it, record its input-to-host latency, and tell
+ * the frame clock which frames the host polls in. */
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const *report, uint16_t len) {
+  int slot = instance;
+  if (instance == usb_vendor_instance()) return;
+  frameclock_polled(&g_clock);
+  if (g_out_mode == SETTINGS_OUTPUT_COMPOSITE && len > 0)
+    slot = report[0] - REPORT_ID_COMPOSITE_MOUSE(0);
+  if (slot < 0 || slot >= CFG_TUD_HID) return;
+  profiler_report();
+  if (g_inflight[slot].valid) {
+    profiler_latency(time_us_32() - g_inflight[slot].us);
+    g_inflight[slot].valid = false;
+  }
+}
+
+/* Resolution Multiplier feature report -> output slot it belongs to, or -1 */
+static int multiplier_slot(uint8_t instance, uint8_t report_id) {
+  if (report_id == REPORT_ID_MULTIPLIER)
+    return instance;
+  if (report_id >= REPORT_ID_COMPOSITE_MULT(0) && report_id < REPORT_ID_COMPOSITE_MULT(CFG_TUD_HID))
+    return report_id - REPORT_ID_COMPOSITE_MULT(0);
+  return -1;
 }
 
 void tud_mount_cb(void) {}
-void tud_umount_cb(void) {}
+void tud_umount_cb(void) { memset(g_res_mult, 0, sizeof(g_res_mult)); }
 void tud_suspend_cb(bool remote_wakeup_en) { (void)remote_wakeup_en; }
 void tud_resume_cb(void) {}
 
+/* From tud_task, so up to a main loop pass after the SOF; frameclock filters that out. */
+void tud_sof_cb(uint32_t frame_count) {
+  frameclock_sof(&g_clock, frame_count, time_us_32());
+}
+
+/* Feature reports: Resolution Multiplier (mice) and Contact Count Maximum (touch).
+ * TinyUSB adds/strips the report ID byte. */
 uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t *buffer, uint16_t reqlen) {
-  (void)instance;
-  (void)report_id;
-  (void)report_type;
-  (void)buffer;
-  (void)reqlen;
+  if (report_type != HID_REPORT_TYPE_FEATURE || instance >= CFG_TUD_HID || reqlen < 1)
+    return 0;
+  int slot = multiplier_slot(instance, report_id);
+  if (slot >= 0) {
+    buffer[0] = g_res_mult[slot];
+    return 1;
+  }
+  if (report_id == REPORT_ID_TOUCH_MAX) {
+    buffer[0] = ABS_CONTACTS;
+    return 1;
+  }
   return 0;
 }
 
 void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const *buffer, uint16_t bufsize) {
-  (void)instance;
-  (void)report_id;
-  (void)report_type;
-  (void)buffer;
-  (void)bufsize;
+  /* Vendor interface: OUT endpoint data (or a SET_REPORT output) is a mouse frame */
+  if (instance == usb_vendor_instance()) {
+    if (report_type != HID_REPORT_TYPE_FEATURE)
+      raw_out_frame(buffer, bufsize);
+    return;
+  }
+  int slot = multiplier_slot(instance, report_id);
+  if (report_type == HID_REPORT_TYPE_FEATURE && slot >= 0 && slot < CFG_TUD_HID && bufsize >= 1)
+    g_res_mult[slot] = buffer[0] & (RES_MULT_WHEEL | RES_MULT_PAN);
 }
 
 int main(void) {
+#if USB_HOST_PIO
+  set_sys_clock_khz(120000, true);   /* PIO-USB bit timing needs a multiple of 12 MHz */
+#endif
   stdio_init_all();
   board_init();
+  settings_init();   /* before USB: the descriptor layout depends on output_mode */
+  settings_refresh();
+  sources_apply();   /* before USB connects: SPI sensor power-up is slow */
   tud_init(BOARD_TUD_RHPORT);
-  settings_init();
-
-  uint8_t input_mode = settings_get()->input_mode;
-  if (input_mode == INPUT_MODE_UART || input_mode == INPUT_MODE_BOTH) {
-    uart_init(UART_ID, UART_BAUD);
-    gpio_set_function(UART_TX_PIN, GPIO_FUNC_UART);
-    gpio_set_function(UART_RX_PIN, GPIO_FUNC_UART);
-  }
-  if (input_mode == INPUT_MODE_QUADRATURE || input_mode == INPUT_MODE_BOTH)
-    quadrature_init();
+  tud_sof_cb_enable(true);
 
   inputs_reset();
-
-  uint32_t last_hid = 0;
+  frameclock_init(&g_clock, FRAME_US, FRAME_LEAD_US, time_us_32());
   while (1) {
+    settings_refresh();
+    sources_apply();   /* a settings change may start or stop sources */
     tud_task();
+    usb_profile_poll();
     /* USB CDC (serial): accept config and mouse packets so send_settings.py and test_random_mice.py work over the Pico's USB port (macOS: no UART adapter needed) */
     while (tud_cdc_available()) {
       uint8_t c;
       if (tud_cdc_read(&c, 1) == 1)
-        uart_process_byte(c);
+        uart_process_byte(c, 0);
     }
-    input_mode = settings_get()->input_mode;
-    if (input_mode == INPUT_MODE_UART || input_mode == INPUT_MODE_BOTH)
-      uart_poll();
-    if (input_mode == INPUT_MODE_QUADRATURE || input_mode == INPUT_MODE_BOTH)
-      quadrature_poll();
-    if (settings_get()->output_mode == SETTINGS_OUTPUT_COMBINED)
-      aggregate_and_amplify();
-
-    if ((settings_get()->output_mode == SETTINGS_OUTPUT_SEPARATE) || g_has_report) {
-      if (board_millis() - last_hid >= HID_POLL_MS) {
-        send_mouse_report();
-        last_hid = board_millis();
-      }
+    for (int k = 0; k < NUM_SOURCES; k++)
+      if (g_plan.sources & g_sources[k].src)
+        g_sources[k].poll();
+
+    /* One report frame per HID_POLL_MS: acceleration and fusion assume a
+     * steady frame period, so idle frames are paced the same as busy ones.
+     * The clock runs each frame FRAME_LEAD_US before the SOF of a frame the
+     * host polls the endpoints in, so its reports are queued just before the
+     * poll. Pending output goes out as soon as each endpoint is free. */
+    uint32_t wait = frameclock_wait_us(&g_clock, time_us_32());
+    if (wait > 0 && wait <= FRAME_SPIN_US)
+      busy_wait_us_32(wait);
+    uint32_t late;
+    if (frameclock_due(&g_clock, time_us_32(), &late))
+      report_frame(late);
+    if (g_plan.cascade)
+      cascade_pump();
+    else if (g_cascade_tx.waiting || g_cascade_len) {   /* cascade switched off: drop what was queued */
+      cascade_tx_reset(&g_cascade_tx);
+      g_cascade_len = g_cascade_pos = 0;
     }
+    send_mouse_report();
+    telemetry_drain();
   }
 }
@@ -0,0 +1,180 @@
+/**
+ * Execution plan (see plan.h). No Pico SDK dependencies.
+ */
+#include "plan.h"
+#include <stddef.h>
+
+static void logic_sum(const plan_t *p, const int32_t *mx, const int32_t *my,
+                      uint32_t live, int32_t *dx, int32_t *dy) {
+  (void)live;
+  int32_t x = 0, y = 0;
+  for (int i = 0; i < p->num_mice; i++) {
+    x += mx[i];
+    y += my[i];
+  }
+  *dx = x;
+  *dy = y;
+}
+
+/* Divide by the mice that are actually live, not by num_mice */
+static void logic_average(const plan_t *p, const int32_t *mx, const int32_t *my,
+                          uint32_t live, int32_t *dx, int32_t *dy) {
+  int32_t x = 0, y = 0;
+  int n_live = 0;
+  for (int i = 0; i < p->num_mice; i++) {
+    x += mx[i];
+    y += my[i];
+    if (live & (1u << i)) n_live++;
+  }
+  if (n_live > 0) {
+    x = fastdiv_s32(&p->avg_div[n_live], x);
+    y = fastdiv_s32(&p->avg_div[n_live], y);
+  }
+  *dx = x;
+  *dy = y;
+}
+
+/* Largest magnitude per axis; ties go to the later mouse */
+static void logic_max(const plan_t *p, const int32_t *mx, const int32_t *my,
+                      uint32_t live, int32_t *dx, int32_t *dy) {
+  (void)live;
+  int32_t best_dx = 0, best_dy = 0;
+  int32_t best_adx = 0, best_ady = 0;
+  for (int i = 0; i < p->num_mice; i++) {
+    int32_t adx = mx[i] < 0 ? -mx[i] : mx[i];
+    int32_t ady = my[i] < 0 ? -my[i] : my[i];
+    if (adx >= best_adx) { best_adx = adx; best_dx = mx[i]; }
+    if (ady >= best_ady) { best_ady = ady; best_dy = my[i]; }
+  }
+  *dx = best_dx;
+  *dy = best_dy;
+}
+
+/* 2-ball logic: compute one axis from A and B. */
+static int32_t logic2_axis(uint8_t mode, int32_t a, int32_t b) {
+  int32_t aa = a < 0 ? -a : a, ab = b < 0 ? -b : b;
+  switch (mode) {
+    case SETTINGS_LOGIC_2_MIN:  return aa <= ab ? a : b;
+    case SETTINGS_LOGIC_2_AND:
+      if (a == 0 || b == 0) return 0;
+      if ((a > 0) != (b > 0)) return 0;
+      return aa <= ab ? a : b;
+    case SETTINGS_LOGIC_2_OR:   return a + b;
+    case SETTINGS_LOGIC_2_XOR:
+      if (a == 0) return b;
+      if (b == 0) return a;
+      return a - b;
+    case SETTINGS_LOGIC_2_NAND:
+      if (a != 0 && b != 0) return 0;
+      return a + b;
+    case SETTINGS_LOGIC_2_NOR:  return 0;
+    case SETTINGS_LOGIC_2_XNOR:
+      if (a == 0 && b == 0) return 0;
+      if (a == 0) return b;
+      if (b == 0) return a;
+      if ((a > 0) != (b > 0)) return 0;
+      return (a + b) / 2;
+    default: return a + b;
+  }
+}
+
+static void logic_2ball(const plan_t *p, const int32_t *mx, const int32_t *my,
+                        uint32_t live, int32_t *dx, int32_t *dy) {
+  (void)live;
+  *dx = logic2_axis(p->logic_mode, mx[0], mx[1]);
+  *dy = logic2_axis(p->logic_mode, my[0], my[1]);
+}
+
+void plan_build(plan_t *p, const settings_t *s) {
+  p->version = s->version;
+  p->num_mice = s->num_mice;
+  switch (s->input_mode) {
+    case SETTINGS_INPUT_QUADRATURE: p->sources = SETTINGS_SRC_QUAD; break;
+    case SETTINGS_INPUT_BOTH:       p->sources = SETTINGS_SRC_HOST | SETTINGS_SRC_QUAD; break;
+    case SETTINGS_INPUT_SPI:        p->sources = SETTINGS_SRC_SPI; break;
+    case SETTINGS_INPUT_USB:        p->sources = SETTINGS_SRC_USB; break;
+    default:                        p->sources = SETTINGS_SRC_HOST; break;
+  }
+  p->cascade = s->cascade_mode;
+  p->cascade_slot = s->cascade_slot;
+  if (p->cascade)
+    p->sources |= SETTINGS_SRC_HOST;   /* the UART is the link up the chain */
+  /* USB CDC and raw HID host packets arrive whatever the input mode, so slot masks are
+   * built for every source; sources only gates what gets initialised and polled. */
+  for (int k = 0; k < PLAN_SOURCES; k++) {
+    p->src_slots[k] = 0;
+    for (int i = 0; i < s->num_mice; i++)
+      if (s->slot_src[i] & (1u << k))
+        p->src_slots[k] |= (uint16_t)(1u << i);
+  }
+  p->quad_sampler = s->quad_sampler;
+  p->quad_filter = s->quad_filter;
+  p->quad_rate_max_hz = (uint32_t)s->quad_rate_max_khz * 1000u;
+  p->xform_mask = s->xform_mask;
+  p->logic_mode = s->logic_mode;
+  p->needs_live = false;
+  switch (s->logic_mode) {
+    case SETTINGS_LOGIC_AVERAGE:
+      p->logic = logic_average;
+      p->needs_live = true;
+      break;
+    case SETTINGS_LOGIC_MAX:
+      p->logic = logic_max;
+      break;
+    case SETTINGS_LOGIC_FUSION:
+      p->logic = NULL;
+      p->needs_live = true;
+      break;
+    default:
+      if (s->logic_mode >= SETTINGS_LOGIC_2_MIN && s->logic_mode <= SETTINGS_LOGIC_2_XNOR)
+        p->logic = logic_2ball;
+      else
+        p->logic = logic_sum;
+      break;
+  }
+  p->accel_on = s->accel_mode != SETTINGS_ACCEL_OFF;
+  p->quad_scale = (int16_t)(s->quad_scale < 1 ? 1 : s->quad_scale);
+  fastdiv_init(&p->quad_div, (uint16_t)p->quad_scale);
+  for (int i = 0; i <= SETTINGS_NUM_MICE_MAX; i++)
+    fastdiv_init(&p->avg_div[i], (uint16_t)(i > 0 ? i : 1));
+  p->amplify_x100 = (int32_t)(s->amplify * 100.0f + 0.5f);
+  fastdiv_init(&p->amplify_div, 100);
+  p->abs_gain_q8 = (int32_t)(s->amplify * (float)(PLAN_ABS_UNITS_PER_COUNT * 256) + 0.5f);
+}
+
+static int32_t clamp_xform(int32_t v) {
+  if (v > PLAN_XFORM_IN_MAX) return PLAN_XFORM_IN_MAX;
+  if (v < -PLAN_XFORM_IN_MAX) return -PLAN_XFORM_IN_MAX;
+  return v;
+}
+
+void plan_xform(const int16_t *m, int32_t *res_q8, int32_t *dx, int32_t *dy) {
+  int32_t x = clamp_xform(*dx), y = clamp_xform(*dy);
+  int32_t ox = m[0] * x + m[1] * y + res_q8[0];
+  int32_t oy = m[2] * x + m[3] * y + res_q8[1];
+  int32_t wx = ox >> 8, wy = oy >> 8;
+  res_q8[0] = ox - wx * 256;
+  res_q8[1] = oy - wy * 256;
+  *dx = clamp_xform(wx);
+  *dy = clamp_xform(wy);
+}
+
+int32_t plan_abs_units(int32_t d, int32_t gain_q8, int32_t *res_q8) {
+  if (d > PLAN_ABS_IN_MAX) d = PLAN_ABS_IN_MAX;
+  if (d < -PLAN_ABS_IN_MAX) d = -PLAN_ABS_IN_MAX;
+  int32_t v = d * gain_q8 + *res_q8;
+  int32_t units = v >> 8;
+  *res_q8 = v - units * 256;
+  return units;
+}
+
+void plan_sources_step(plan_sources_t *st, const plan_t *p, uint8_t per_mouse,
+                       uint8_t *stop, uint8_t *start) {
+  uint8_t restart = 0;
+  if (p->num_mice != st->num_mice)
+    restart = (uint8_t)(st->up & p->sources & per_mouse);
+  *stop = (uint8_t)((st->up & ~p->sources) | restart);
+  *start = (uint8_t)(p->sources & ~(st->up & ~restart));
+  st->up = p->sources;
+  st->num_mice = p->num_mice;
+}
@@ -0,0 +1,179 @@
+/**
+ * PMW3360-class sensor access over pmw_bus_t (see pmw3360.h). No Pico SDK dependencies.
+ */
+#include "pmw3360.h"
+#include <string.h>
+
+__attribute__((weak)) const uint8_t *pmw_srom(size_t *len) {
+  *len = 0;
+  return NULL;
+}
+
+static void bus_wait(const pmw_bus_t *bus) {
+  while (bus->busy(bus->ctx)) {}
+}
+
+uint8_t pmw_read_reg(const pmw_bus_t *bus, int sensor, uint8_t reg) {
+  uint8_t a = reg & 0x7Fu, v;
+  bus->select(bus->ctx, sensor, true);
+  bus->write(bus->ctx, &a, 1);
+  bus->delay_us(bus->ctx, PMW_T_SRAD);
+  bus->read(bus->ctx, &v, 1);
+  bus_wait(bus);
+  bus->select(bus->ctx, sensor, false);
+  bus->delay_us(bus->ctx, PMW_T_SRR);
+  return v;
+}
+
+void pmw_write_reg(const pmw_bus_t *bus, int sensor, uint8_t reg, uint8_t v) {
+  uint8_t b[2] = { (uint8_t)(reg | 0x80u), v };
+  bus->select(bus->ctx, sensor, true);
+  bus->write(bus->ctx, b, 2);
+  bus->delay_us(bus->ctx, PMW_T_SCLK_NCS_W);
+  bus->select(bus->ctx, sensor, false);
+  bus->delay_us(bus->ctx, PMW_T_SWW - PMW_T_SCLK_NCS_W);
+}
+
+/* Datasheet SROM download; true if the sensor then reports an SROM ID. */
+static bool srom_download(const pmw_bus_t *bus, int sensor, const uint8_t *img, size_t len) {
+  pmw_write_reg(bus, sensor, PMW_REG_CONFIG2, 0x00);
+  pmw_write_reg(bus, sensor, PMW_REG_SROM_ENABLE, 0x1D);
+  bus->delay_us(bus->ctx, 10000);
+  pmw_write_reg(bus, sensor, PMW_REG_SROM_ENABLE, 0x18);
+  uint8_t a = PMW_REG_SROM_LOAD_BURST | 0x80u;
+  bus->select(bus->ctx, sensor, true);
+  bus->write(bus->ctx, &a, 1);
+  bus->delay_us(bus->ctx, PMW_T_SROM_BYTE);
+  for (size_t k = 0; k < len; k++) {
+    bus->write(bus->ctx, &img[k], 1);
+    bus->delay_us(bus->ctx, PMW_T_SROM_BYTE);
+  }
+  bus->select(bus->ctx, sensor, false);
+  bus->delay_us(bus->ctx, 200);
+  bool ok = pmw_read_reg(bus, sensor, PMW_REG_SROM_ID) != 0;
+  pmw_write_reg(bus, sensor, PMW_REG_CONFIG2, 0x00);
+  return ok;
+}
+
+static uint8_t cpi_reg(uint16_t cpi) {
+  if (cpi < PMW_CPI_MIN) cpi = PMW_CPI_MIN;
+  if (cpi > PMW_CPI_MAX) cpi = PMW_CPI_MAX;
+  return (uint8_t)(cpi / 100u - 1u);
+}
+
+uint8_t pmw_init(pmw_t *p, const pmw_bus_t *bus, int count, uint16_t cpi) {
+  memset(p, 0, sizeof(*p));
+  if (count > PMW_SENSORS_MAX) count = PMW_SENSORS_MAX;
+  p->bus = bus;
+  p->count = (uint8_t)count;
+  size_t srom_len;
+  const uint8_t *srom = pmw_srom(&srom_len);
+
+  for (int i = 0; i < count; i++) {
+    /* Chip select high-low-high resets the sensor's serial port */
+    bus->select(bus->ctx, i, false);
+    bus->select(bus->ctx, i, true);
+    bus->select(bus->ctx, i, false);
+    pmw_write_reg(bus, i, PMW_REG_POWER_UP_RESET, 0x5A);
+    bus->delay_us(bus->ctx, 50000);
+    for (uint8_t r = PMW_REG_MOTION; r <= PMW_REG_DELTA_Y_H; r++)
+      (void)pmw_read_reg(bus, i, r);   /* clear motion left over from power-up */
+    if (pmw_read_reg(bus, i, PMW_REG_PRODUCT_ID) != PMW_PRODUCT_ID)
+      continue;
+    if (srom && srom_len && !srom_download(bus, i, srom, srom_len))
+      continue;
+    pmw_write_reg(bus, i, PMW_REG_CONFIG1, cpi_reg(cpi));
+    pmw_write_reg(bus, i, PMW_REG_MOTION_BURST, 0x00);   /* enter burst mode */
+    p->present |= (uint8_t)(1u << i);
+  }
+  return p->present;
+}
+
+/* Next present sensor after cur (round-robin). */
+static uint8_t next_sensor(const pmw_t *p, uint8_t cur) {
+  for (int k = 1; k <= p->count; k++) {
+    uint8_t i = (uint8_t)((cur + k) % p->count);
+    if (p->present & (1u << i))
+      return i;
+  }
+  return cur;
+}
+
+/* Deselect after a burst transfer, take its counts, and move on to the next sensor.
+ * Returns the sensor's bit if it moved. */
+static uint32_t burst_done(pmw_t *p) {
+  const pmw_bus_t *bus = p->bus;
+  int i = p->cur;
+  pmw_motion_t m;
+  bus->select(bus->ctx, i, false);
+  p->state = PMW_IDLE;
+  p->cur = next_sensor(p, p->cur);
+  p->bursts++;
+  if (!pmw_burst_parse(p->buf, &m)) {
+    p->bad++;
+    return 0;
+  }
+  if (m.lifted)
+    p->lifted |= (uint8_t)(1u << i);
+  else
+    p->lifted &= (uint8_t)~(1u << i);
+  if (m.dx == 0 && m.dy == 0)
+    return 0;
+  p->acc[i][0] += m.dx;
+  p->acc[i][1] += m.dy;
+  p->moved |= (uint8_t)(1u << i);
+  return 1u << i;
+}
+
+bool pmw_burst_parse(const uint8_t *b, pmw_motion_t *m) {
+  if (b[0] & 0x70u)   /* reserved Motion bits read 0; all set means nobody drove MISO */
+    return false;
+  m->dx = (int16_t)(uint16_t)(b[2] | (uint16_t)b[3] << 8);
+  m->dy = (int16_t)(uint16_t)(b[4] | (uint16_t)b[5] << 8);
+  m->squal = b[6];
+  m->lifted = (b[0] & PMW_MOTION_LIFT) != 0;
+  if (!(b[0] & PMW_MOTION_MOT))
+    m->dx = m->dy = 0;
+  return true;
+}
+
+uint32_t pmw_poll(pmw_t *p, uint32_t now_us) {
+  const pmw_bus_t *bus = p->bus;
+  uint32_t moved = 0;
+  if (!p->present)
+    return 0;
+  for (;;) {
+    switch (p->state) {
+      case PMW_IDLE: {
+        if (!(p->present & (1u << p->cur)))
+          p->cur = next_sensor(p, p->cur);
+        uint8_t a = PMW_REG_MOTION_BURST;
+        bus->select(bus->ctx, p->cur, true);
+        bus->write(bus->ctx, &a, 1);
+        p->t_us = now_us + PMW_T_SRAD_MOTBR;
+        p->state = PMW_WAIT;
+        break;
+      }
+      case PMW_WAIT:
+        if ((int32_t)(now_us - p->t_us) < 0)
+          return moved;
+        bus->read(bus->ctx, p->buf, PMW_BURST_LEN);
+        p->state = PMW_READ;
+        break;
+      case PMW_READ: {
+        if (bus->busy(bus->ctx))
+          return moved;
+        int i = p->cur;
+        moved |= burst_done(p);
+        if (p->cur == i) {
+          bus->delay_us(bus->ctx, PMW_T_BEXIT);   /* same chip select straight back down */
+          now_us += PMW_T_BEXIT;                  /* so its t_SRAD_MOTBR starts after it */
+        }
+        break;   /* address the next sensor now; its wait ends the call */
+      }
+      default:
+        p->state = PMW_IDLE;
+        break;
+    }
+  }
+}
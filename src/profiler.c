@@ -0,0 +1,57 @@
+/**
+ * Report path profiler (see profiler.h). No Pico SDK dependencies.
+ */
+#include "profiler.h"
+#include <string.h>
+
+static profiler_stats_t g_stats;
+
+void profiler_reset(uint32_t now_ms) {
+  memset(&g_stats, 0, sizeof(g_stats));
+  g_stats.start_ms = now_ms;
+}
+
+void profiler_frame(uint32_t now_us, uint32_t period_us, uint32_t late_us) {
+  if (g_stats.frames > 0) {   /* the first frame after a reset has no interval */
+    uint32_t dt = now_us - g_stats.last_frame_us;
+    uint32_t j = dt > period_us ? dt - period_us : period_us - dt;
+    int b = 0;
+    for (uint32_t edge = PROFILER_JITTER0_US; b < PROFILER_JITTER_BUCKETS - 1 && j >= edge; edge <<= 1)
+      b++;
+    g_stats.jitter_hist[b]++;
+    g_stats.intervals++;
+    g_stats.jitter_sum_us += j;
+    if (j > g_stats.jitter_max_us)
+      g_stats.jitter_max_us = j;
+  }
+  g_stats.last_frame_us = now_us;
+  g_stats.late_sum_us += late_us;
+  if (late_us > g_stats.late_max_us)
+    g_stats.late_max_us = late_us;
+  g_stats.frames++;
+}
+
+void profiler_report(void) {
+  g_stats.reports++;
+}
+
+int profiler_bucket(uint32_t us) {
+  int b = 0;
+  uint32_t edge = PROFILER_BUCKET0_US;
+  while (b < PROFILER_BUCKETS - 1 && us >= edge) {
+    edge <<= 1;
+    b++;
+  }
+  return b;
+}
+
+void profiler_latency(uint32_t us) {
+  g_stats.hist[profiler_bucket(us)]++;
+  g_stats.samples++;
+  if (us > g_stats.max_us)
+    g_stats.max_us = us;
+}
+
+const profiler_stats_t *profiler_get(void) {
+  return &g_stats;
+}
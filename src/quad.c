@@ -0,0 +1,107 @@
+/**
+ * Packed quadrature decode (see quad.h). No Pico SDK dependencies.
+ */
+#include "quad.h"
+#include <string.h>
+
+/* prev_ab and curr_ab are 2-bit (A=bit0, B=bit1). Returns -1, 0, or +1. */
+static const int8_t quad_table[16] = {
+  0, 1, -1, 0,  -1, 0, 0, 1,  1, 0, 0, -1,  0, -1, 1, 0
+};
+
+void quad_reset(quad_state_t *q, uint32_t sample) {
+  memset(q, 0, sizeof(*q));
+  q->prev = sample & QUAD_MASK;
+}
+
+uint32_t quad_step(quad_state_t *q, uint32_t sample) {
+  sample &= QUAD_MASK;
+  uint32_t changed = sample ^ q->prev;
+  if (changed == 0)
+    return 0;
+  uint32_t moved = 0, illegal = 0;
+  for (int axis = 0; axis < QUAD_MICE * 2; axis++, changed >>= 2) {
+    if ((changed & 3u) == 0)
+      continue;
+    int shift = axis * 2;
+    int8_t d = quad_table[(((q->prev >> shift) & 3u) << 2) | ((sample >> shift) & 3u)];
+    if (d != 0) {
+      /* Saturate: a long stall between polls must not wrap the count's direction */
+      int16_t *acc = &q->acc[axis >> 1][axis & 1];
+      if ((d > 0 && *acc < INT16_MAX) || (d < 0 && *acc > INT16_MIN))
+        *acc = (int16_t)(*acc + d);
+      moved |= 1u << (axis >> 1);
+    } else {
+      q->illegal[axis >> 1][axis & 1]++;   /* only a double change decodes to 0 */
+      illegal = QUAD_STEP_ILLEGAL;
+    }
+  }
+  q->prev = sample;
+  q->moved |= (uint8_t)moved;
+  return moved | illegal;
+}
+
+/* Bit-sliced: all 24 pins are voted on at once with a few logic ops. */
+uint32_t quad_vote(const uint32_t *s, int taps) {
+  if (taps < 3)
+    return s[0];
+  uint32_t a = s[0], b = s[1], c = s[2];
+  uint32_t c1 = (a & b) | (a & c) | (b & c);   /* majority of 3 = carry of a+b+c */
+  if (taps < 5)
+    return c1;
+  /* 5: count = s2 + 2 * (c1 + c2), from two full adders; >= 3 when both carries are
+   * set, or one is and the sum bit is too. */
+  uint32_t s1 = a ^ b ^ c, d = s[3], e = s[4];
+  uint32_t s2 = s1 ^ d ^ e;
+  uint32_t c2 = (s1 & d) | (s1 & e) | (d & e);
+  return (c1 & c2) | ((c1 | c2) & s2);
+}
+
+void quad_filter_reset(quad_filter_t *f, uint8_t taps, uint32_t sample) {
+  f->taps = taps >= 5 ? 5 : taps >= 3 ? 3 : 1;
+  f->pos = 0;
+  for (int i = 0; i < QUAD_TAPS_MAX; i++)
+    f->hist[i] = sample;
+}
+
+uint32_t quad_filter(quad_filter_t *f, uint32_t sample) {
+  if (f->taps < 3)
+    return sample;
+  f->hist[f->pos] = sample;
+  if (++f->pos >= f->taps)
+    f->pos = 0;
+  return quad_vote(f->hist, f->taps);
+}
+
+void quad_rate_init(quad_rate_t *r, uint32_t ceiling_hz) {
+  if (ceiling_hz < QUAD_RATE_IDLE_HZ) ceiling_hz = QUAD_RATE_IDLE_HZ;
+  r->min_period_us = 1000000u / ceiling_hz;
+  r->max_period_us = 1000000u / QUAD_RATE_IDLE_HZ;
+  r->period_us = r->max_period_us;
+  r->samples = r->changes = 0;
+}
+
+uint32_t quad_rate_step(quad_rate_t *r, bool changed, bool illegal) {
+  /* Burst: a ball that starts moving may be fast already, and a dropped step means
+   * the rate is too low right now; either way there is no time to ramp up. */
+  if (illegal || (changed && r->period_us >= r->max_period_us)) {
+    r->period_us = r->min_period_us;
+    r->samples = r->changes = 0;
+    return r->period_us;
+  }
+  r->samples++;
+  if (changed) r->changes++;
+  if (r->samples < QUAD_RATE_WINDOW)
+    return r->period_us;
+  /* Changes are counted over all pins, which overstates the busiest axis when several
+   * balls move: that errs towards sampling too fast, never too slow. */
+  if (r->changes * QUAD_RATE_BUSY > r->samples) {
+    r->period_us /= 2;
+    if (r->period_us < r->min_period_us) r->period_us = r->min_period_us;
+  } else if (r->changes * QUAD_RATE_QUIET < r->samples) {
+    r->period_us *= 2;
+    if (r->period_us > r->max_period_us) r->period_us = r->max_period_us;
+  }
+  r->samples = r->changes = 0;
+  return r->period_us;
+}
@@ -11,7 +11,46 @@
 #define SETTINGS_OFFSET  (PICO_FLASH_SIZE_BYTES - 4096)  /* last 4K sector */
 #define SETTINGS_PAYLOAD_LEN  8  /* num_mice, logic, input, output_mode, amplify_x100, quad_scale(2), reserved(1) */
 
+/* Extension block after the base record: magic, len (2), TLV entries (tag, len, value), crc8.
+ * Unknown tags are skipped so older firmware ignores newer fields. */
+#define SETTINGS_EXT_MAGIC    "AMXT"
+#define SETTINGS_EXT_POS      16
+#define SETTINGS_EXT_MAX      (512 - SETTINGS_EXT_POS - 7)
+#define SETTINGS_TAG_XFORM    0x01  /* count, then count x 4 int16 (xx, xy, yx, yy) */
+#define SETTINGS_TAG_ACCEL    0x02  /* mode, window_ms, threshold, rate(2), max_x100(2) */
+#define SETTINGS_TAG_STALE    0x03  /* stale_ms(2) */
+#define SETTINGS_TAG_BUTTONS  0x04  /* button_min_hold_ms */
+#define SETTINGS_TAG_QUAD     0x05  /* quad_sampler, quad_filter, quad_rate_max_khz */
+#define SETTINGS_TAG_SLOTS    0x06  /* count, then count x source mask */
+#define SETTINGS_TAG_CASCADE  0x07  /* cascade_mode, cascade_slot */
+
+/* Defaults for settings added after config.h was generated by older configure.py */
+#ifndef ACCEL_MODE
+#define ACCEL_MODE        0
+#define ACCEL_WINDOW_MS   20
+#define ACCEL_THRESHOLD   4
+#define ACCEL_RATE        50
+#define ACCEL_MAX         4.0f
+#endif
+#ifndef QUAD_SAMPLER
+#define QUAD_SAMPLER      0
+#endif
+#ifndef QUAD_FILTER
+#define QUAD_FILTER       1
+#endif
+#ifndef QUAD_RATE_MAX_KHZ
+#define QUAD_RATE_MAX_KHZ 20
+#endif
+
+/* Writers edit g_settings field by field, then publish() copies the clamped result
+ * into g_pub under a sequence counter (odd while a copy is in progress). Readers
+ * only ever copy g_pub out and retry if the counter moved, so a snapshot is never
+ * a mix of two updates, even when read from the other core or an interrupt. */
+#define SETTINGS_WORDS  ((sizeof(settings_t) + 3) / 4)
+
 static settings_t g_settings;
+static uint32_t g_pub[SETTINGS_WORDS];
+static uint32_t g_seq;
 
 static uint8_t crc8(const uint8_t *data, int len) {
   uint8_t crc = 0;
@@ -23,16 +62,170 @@ static uint8_t crc8(const uint8_t *data, int len) {
   return crc;
 }
 
+static void xform_identity(void) {
+  for (int i = 0; i < SETTINGS_NUM_MICE_MAX; i++) {
+    g_settings.xform[i][0] = SETTINGS_XFORM_ONE;
+    g_settings.xform[i][1] = 0;
+    g_settings.xform[i][2] = 0;
+    g_settings.xform[i][3] = SETTINGS_XFORM_ONE;
+  }
+}
+
+static void publish(void) {
+  uint32_t w[SETTINGS_WORDS] = { 0 };
+  memcpy(w, &g_settings, sizeof(g_settings));
+  uint32_t seq = g_seq;   /* single writer: no one else changes it */
+  __atomic_store_n(&g_seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  for (unsigned i = 0; i < SETTINGS_WORDS; i++)
+    __atomic_store_n(&g_pub[i], w[i], __ATOMIC_RELAXED);
+  __atomic_store_n(&g_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
 static void clamp_settings(void) {
   if (g_settings.num_mice < SETTINGS_NUM_MICE_MIN) g_settings.num_mice = SETTINGS_NUM_MICE_MIN;
   if (g_settings.num_mice > SETTINGS_NUM_MICE_MAX) g_settings.num_mice = SETTINGS_NUM_MICE_MAX;
-  if (g_settings.logic_mode > SETTINGS_LOGIC_2_XNOR) g_settings.logic_mode = SETTINGS_LOGIC_SUM;
-  if (g_settings.input_mode > SETTINGS_INPUT_BOTH) g_settings.input_mode = SETTINGS_INPUT_UART;
-  if (g_settings.output_mode > SETTINGS_OUTPUT_SEPARATE) g_settings.output_mode = SETTINGS_OUTPUT_COMBINED;
+  if (g_settings.logic_mode > SETTINGS_LOGIC_FUSION) g_settings.logic_mode = SETTINGS_LOGIC_SUM;
+  if (g_settings.input_mode > SETTINGS_INPUT_USB) g_settings.input_mode = SETTINGS_INPUT_UART;
+  if (g_settings.output_mode > SETTINGS_OUTPUT_RAW) g_settings.output_mode = SETTINGS_OUTPUT_COMBINED;
   if (g_settings.amplify < 0.1f) g_settings.amplify = 0.1f;
   if (g_settings.amplify > 10.0f) g_settings.amplify = 10.0f;
   if (g_settings.quad_scale < 1) g_settings.quad_scale = 1;
   if (g_settings.quad_scale > 1000) g_settings.quad_scale = 1000;
+  if (g_settings.accel_mode > SETTINGS_ACCEL_EXP) g_settings.accel_mode = SETTINGS_ACCEL_OFF;
+  if (g_settings.accel_window_ms < SETTINGS_ACCEL_WINDOW_MIN) g_settings.accel_window_ms = SETTINGS_ACCEL_WINDOW_MIN;
+  if (g_settings.accel_window_ms > SETTINGS_ACCEL_WINDOW_MAX) g_settings.accel_window_ms = SETTINGS_ACCEL_WINDOW_MAX;
+  if (g_settings.accel_rate > 10000) g_settings.accel_rate = 10000;
+  if (g_settings.accel_max_x100 < 100) g_settings.accel_max_x100 = 100;
+  if (g_settings.accel_max_x100 > 1000) g_settings.accel_max_x100 = 1000;
+  if (g_settings.stale_ms < 50) g_settings.stale_ms = 50;
+  if (g_settings.stale_ms > 60000) g_settings.stale_ms = 60000;
+  if (g_settings.button_min_hold_ms > 100) g_settings.button_min_hold_ms = 100;
+  if (g_settings.quad_sampler > SETTINGS_QUAD_TIMER) g_settings.quad_sampler = SETTINGS_QUAD_POLL;
+  if (g_settings.quad_filter > SETTINGS_QUAD_FILTER_MAX) g_settings.quad_filter = SETTINGS_QUAD_FILTER_MAX;
+  if (!(g_settings.quad_filter & 1u)) g_settings.quad_filter++;   /* odd, so the vote has no ties */
+  if (g_settings.quad_rate_max_khz < 1) g_settings.quad_rate_max_khz = 1;
+  if (g_settings.quad_rate_max_khz > SETTINGS_QUAD_RATE_MAX_KHZ) g_settings.quad_rate_max_khz = SETTINGS_QUAD_RATE_MAX_KHZ;
+  for (int i = 0; i < SETTINGS_NUM_MICE_MAX; i++)
+    g_settings.slot_src[i] &= SETTINGS_SRC_ALL;
+  if (g_settings.cascade_mode > SETTINGS_CASCADE_COMBINED) g_settings.cascade_mode = SETTINGS_CASCADE_OFF;
+  if (g_settings.cascade_slot > 15) g_settings.cascade_slot = 15;
+  g_settings.xform_mask = 0;
+  for (int i = 0; i < SETTINGS_NUM_MICE_MAX; i++) {
+    int16_t *m = g_settings.xform[i];
+    for (int j = 0; j < 4; j++)
+      if (m[j] < -SETTINGS_XFORM_MAX) m[j] = -SETTINGS_XFORM_MAX;
+    if (m[0] != SETTINGS_XFORM_ONE || m[1] != 0 || m[2] != 0 || m[3] != SETTINGS_XFORM_ONE)
+      g_settings.xform_mask |= (uint16_t)(1u << i);
+  }
+  g_settings.version = (g_seq >> 1) + 1;
+  publish();
+}
+
+static int16_t get_s16(const uint8_t *p) {
+  return (int16_t)((uint16_t)p[0] | ((uint16_t)p[1] << 8));
+}
+
+static void put_s16(uint8_t *p, int16_t v) {
+  p[0] = (uint8_t)((uint16_t)v & 0xFF);
+  p[1] = (uint8_t)((uint16_t)v >> 8);
+}
+
+static void load_ext(const uint8_t *p, int len) {
+  int pos = 0;
+  while (pos + 2 <= len) {
+    uint8_t tag = p[pos], tl = p[pos + 1];
+    const uint8_t *v = p + pos + 2;
+    if (pos + 2 + tl > len) break;
+    switch (tag) {
+      case SETTINGS_TAG_XFORM: {
+        int count = tl > 0 ? v[0] : 0;
+        if (count > SETTINGS_NUM_MICE_MAX) count = SETTINGS_NUM_MICE_MAX;
+        if (1 + count * 8 > tl) break;
+        for (int i = 0; i < count; i++)
+          for (int j = 0; j < 4; j++)
+            g_settings.xform[i][j] = get_s16(v + 1 + i * 8 + j * 2);
+        break;
+      }
+      case SETTINGS_TAG_ACCEL:
+        if (tl < 7) break;
+        g_settings.accel_mode      = v[0];
+        g_settings.accel_window_ms = v[1];
+        g_settings.accel_threshold = v[2];
+        g_settings.accel_rate      = (uint16_t)get_s16(v + 3);
+        g_settings.accel_max_x100  = (uint16_t)get_s16(v + 5);
+        break;
+      case SETTINGS_TAG_STALE:
+        if (tl < 2) break;
+        g_settings.stale_ms = (uint16_t)get_s16(v);
+        break;
+      case SETTINGS_TAG_BUTTONS:
+        if (tl < 1) break;
+        g_settings.button_min_hold_ms = v[0];
+        break;
+      case SETTINGS_TAG_QUAD:
+        if (tl < 1) break;
+        g_settings.quad_sampler = v[0];
+        if (tl >= 2) g_settings.quad_filter = v[1];
+        if (tl >= 3) g_settings.quad_rate_max_khz = v[2];
+        break;
+      case SETTINGS_TAG_SLOTS: {
+        int count = tl > 0 ? v[0] : 0;
+        if (count > SETTINGS_NUM_MICE_MAX) count = SETTINGS_NUM_MICE_MAX;
+        if (1 + count > tl) break;
+        memcpy(g_settings.slot_src, v + 1, (size_t)count);
+        break;
+      }
+      case SETTINGS_TAG_CASCADE:
+        if (tl < 2) break;
+        g_settings.cascade_mode = v[0];
+        g_settings.cascade_slot = v[1];
+        break;
+      default: break;
+    }
+    pos += 2 + tl;
+  }
+}
+
+/* Write TLV entries for all extension fields; returns bytes used. */
+static int save_ext(uint8_t *p) {
+  int pos = 0;
+  p[pos++] = SETTINGS_TAG_XFORM;
+  p[pos++] = (uint8_t)(1 + SETTINGS_NUM_MICE_MAX * 8);
+  p[pos++] = SETTINGS_NUM_MICE_MAX;
+  for (int i = 0; i < SETTINGS_NUM_MICE_MAX; i++)
+    for (int j = 0; j < 4; j++, pos += 2)
+      put_s16(p + pos, g_settings.xform[i][j]);
+  p[pos++] = SETTINGS_TAG_ACCEL;
+  p[pos++] = 7;
+  p[pos++] = g_settings.accel_mode;
+  p[pos++] = g_settings.accel_window_ms;
+  p[pos++] = g_settings.accel_threshold;
+  put_s16(p + pos, (int16_t)g_settings.accel_rate);
+  put_s16(p + pos + 2, (int16_t)g_settings.accel_max_x100);
+  pos += 4;
+  p[pos++] = SETTINGS_TAG_STALE;
+  p[pos++] = 2;
+  put_s16(p + pos, (int16_t)g_settings.stale_ms);
+  pos += 2;
+  p[pos++] = SETTINGS_TAG_BUTTONS;
+  p[pos++] = 1;
+  p[pos++] = g_settings.button_min_hold_ms;
+  p[pos++] = SETTINGS_TAG_QUAD;
+  p[pos++] = 3;
+  p[pos++] = g_settings.quad_sampler;
+  p[pos++] = g_settings.quad_filter;
+  p[pos++] = g_settings.quad_rate_max_khz;
+  p[pos++] = SETTINGS_TAG_SLOTS;
+  p[pos++] = (uint8_t)(1 + SETTINGS_NUM_MICE_MAX);
+  p[pos++] = SETTINGS_NUM_MICE_MAX;
+  memcpy(p + pos, g_settings.slot_src, SETTINGS_NUM_MICE_MAX);
+  pos += SETTINGS_NUM_MICE_MAX;
+  p[pos++] = SETTINGS_TAG_CASCADE;
+  p[pos++] = 2;
+  p[pos++] = g_settings.cascade_mode;
+  p[pos++] = g_settings.cascade_slot;
+  return pos;
 }
 
 void settings_init(void) {
@@ -43,6 +236,20 @@ void settings_init(void) {
   g_settings.output_mode = (uint8_t)OUTPUT_MODE;
   g_settings.amplify    = AMPLIFY;
   g_settings.quad_scale = (uint16_t)QUAD_SCALE;
+  xform_identity();
+  g_settings.accel_mode      = (uint8_t)ACCEL_MODE;
+  g_settings.accel_window_ms = (uint8_t)ACCEL_WINDOW_MS;
+  g_settings.accel_threshold = (uint8_t)ACCEL_THRESHOLD;
+  g_settings.accel_rate      = (uint16_t)ACCEL_RATE;
+  g_settings.accel_max_x100  = (uint16_t)(ACCEL_MAX * 100.0f + 0.5f);
+  g_settings.stale_ms        = SETTINGS_STALE_MS_DEFAULT;
+  g_settings.button_min_hold_ms = 0;
+  g_settings.quad_sampler    = (uint8_t)QUAD_SAMPLER;
+  g_settings.quad_filter     = (uint8_t)QUAD_FILTER;
+  g_settings.quad_rate_max_khz = (uint8_t)QUAD_RATE_MAX_KHZ;
+  memset(g_settings.slot_src, SETTINGS_SRC_ALL, sizeof(g_settings.slot_src));
+  g_settings.cascade_mode    = SETTINGS_CASCADE_OFF;
+  g_settings.cascade_slot    = 0;
   clamp_settings();
 
   /* Try load from flash */
@@ -56,14 +263,35 @@ void settings_init(void) {
   g_settings.num_mice    = payload[0];
   g_settings.logic_mode  = payload[1];
   g_settings.input_mode  = payload[2];
-  g_settings.output_mode = payload[3] & 1;
+  g_settings.output_mode = payload[3];
   g_settings.amplify     = (float)payload[4] / 100.0f;
   g_settings.quad_scale  = (uint16_t)payload[5] | ((uint16_t)payload[6] << 8);
+
+  /* Optional extension block (absent in settings saved by older firmware) */
+  const uint8_t *ext = flash + SETTINGS_EXT_POS;
+  if (memcmp(ext, SETTINGS_EXT_MAGIC, 4) == 0) {
+    int ext_len = (int)ext[4] | ((int)ext[5] << 8);
+    if (ext_len <= SETTINGS_EXT_MAX && crc8(ext + 6, ext_len) == ext[6 + ext_len])
+      load_ext(ext + 6, ext_len);
+  }
   clamp_settings();
 }
 
-const settings_t *settings_get(void) {
-  return &g_settings;
+void settings_acquire(settings_t *out) {
+  uint32_t w[SETTINGS_WORDS];
+  uint32_t s0, s1;
+  do {
+    s0 = __atomic_load_n(&g_seq, __ATOMIC_ACQUIRE);
+    for (unsigned i = 0; i < SETTINGS_WORDS; i++)
+      w[i] = __atomic_load_n(&g_pub[i], __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    s1 = __atomic_load_n(&g_seq, __ATOMIC_RELAXED);
+  } while ((s0 & 1u) || s0 != s1);
+  memcpy(out, w, sizeof(*out));
+}
+
+uint32_t settings_version(void) {
+  return __atomic_load_n(&g_seq, __ATOMIC_ACQUIRE) >> 1;
 }
 
 void settings_set_num_mice(uint8_t n) {
@@ -91,19 +319,75 @@ void settings_set_quad_scale(uint16_t q) {
   clamp_settings();
 }
 
+void settings_set_xform(uint8_t mouse, int16_t xx, int16_t xy, int16_t yx, int16_t yy) {
+  if (mouse >= SETTINGS_NUM_MICE_MAX) return;
+  g_settings.xform[mouse][0] = xx;
+  g_settings.xform[mouse][1] = xy;
+  g_settings.xform[mouse][2] = yx;
+  g_settings.xform[mouse][3] = yy;
+  clamp_settings();
+}
+
+void settings_set_accel(uint8_t mode, uint8_t window_ms, uint8_t threshold, uint16_t rate, uint16_t max_x100) {
+  g_settings.accel_mode      = mode;
+  g_settings.accel_window_ms = window_ms;
+  g_settings.accel_threshold = threshold;
+  g_settings.accel_rate      = rate;
+  g_settings.accel_max_x100  = max_x100;
+  clamp_settings();
+}
+
+void settings_set_stale_ms(uint16_t ms) {
+  g_settings.stale_ms = ms;
+  clamp_settings();
+}
+
+void settings_set_button_min_hold(uint8_t ms) {
+  g_settings.button_min_hold_ms = ms;
+  clamp_settings();
+}
+
+void settings_set_quad_sampler(uint8_t sampler) {
+  g_settings.quad_sampler = sampler;
+  clamp_settings();
+}
+
+void settings_set_quad_filter(uint8_t taps) {
+  g_settings.quad_filter = taps;
+  clamp_settings();
+}
+
+void settings_set_quad_rate_max(uint8_t khz) {
+  g_settings.quad_rate_max_khz = khz;
+  clamp_settings();
+}
+
+void settings_set_slot_sources(const uint8_t *masks) {
+  memcpy(g_settings.slot_src, masks, SETTINGS_NUM_MICE_MAX);
+  clamp_settings();
+}
+
+void settings_set_cascade(uint8_t mode, uint8_t slot) {
+  g_settings.cascade_mode = mode;
+  g_settings.cascade_slot = slot;
+  clamp_settings();
+}
+
 void settings_apply_uart(uint8_t num_mice, uint8_t logic_mode, uint8_t input_mode,
                          uint8_t output_mode, uint8_t amplify_x100, uint16_t quad_scale) {
   g_settings.num_mice    = num_mice;
   g_settings.logic_mode  = logic_mode;
   g_settings.input_mode  = input_mode;
-  g_settings.output_mode = output_mode & 1;
+  g_settings.output_mode = output_mode;
   g_settings.amplify     = (float)amplify_x100 / 100.0f;
   g_settings.quad_scale  = quad_scale;
   clamp_settings();
 }
 
 bool settings_save_to_flash(void) {
-  uint8_t buf[4 + SETTINGS_PAYLOAD_LEN + 1];
+  /* flash_range_program() needs whole pages; unused bytes stay erased (0xFF) */
+  static uint8_t buf[2 * FLASH_PAGE_SIZE];
+  memset(buf, 0xFF, sizeof(buf));
   memcpy(buf, SETTINGS_MAGIC, 4);
   buf[4] = g_settings.num_mice;
   buf[5] = g_settings.logic_mode;
@@ -115,6 +399,13 @@ bool settings_save_to_flash(void) {
   buf[11] = 0;
   buf[12] = crc8(buf + 4, SETTINGS_PAYLOAD_LEN);
 
+  uint8_t *ext = buf + SETTINGS_EXT_POS;
+  memcpy(ext, SETTINGS_EXT_MAGIC, 4);
+  int ext_len = save_ext(ext + 6);
+  ext[4] = (uint8_t)(ext_len & 0xFF);
+  ext[5] = (uint8_t)(ext_len >> 8);
+  ext[6 + ext_len] = crc8(ext + 6, ext_len);
+
   uint32_t irq = save_and_disable_interrupts();
   flash_range_erase(SETTINGS_OFFSET, 4096);
   flash_range_program(SETTINGS_OFFSET, buf, sizeof(buf));
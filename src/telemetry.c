@@ -0,0 +1,77 @@
+/**
+ * Telemetry ring (see telemetry.h). No Pico SDK dependencies.
+ *
+ * head is only written by the producer and tail only by the consumer, so the
+ * ring needs no lock: each side publishes its index with a release store
+ * after touching the slot and reads the other's with an acquire load.
+ */
+#include "telemetry.h"
+#include <string.h>
+
+static telemetry_record_t g_ring[TELEMETRY_RING];
+static volatile uint32_t g_head;     /* next slot to write (producer) */
+static volatile uint32_t g_tail;     /* next slot to read (consumer) */
+static volatile uint32_t g_dropped;  /* producer only */
+static volatile bool g_enabled;
+
+void telemetry_reset(void) {
+  g_head = g_tail = 0;
+  g_dropped = 0;
+}
+
+void telemetry_enable(bool on) {
+  g_enabled = on;
+}
+
+bool telemetry_enabled(void) {
+  return g_enabled;
+}
+
+bool telemetry_push(telemetry_record_t *rec) {
+  uint32_t head = g_head;
+  uint32_t tail = __atomic_load_n(&g_tail, __ATOMIC_ACQUIRE);
+  if (head - tail >= TELEMETRY_RING) {
+    g_dropped++;
+    return false;
+  }
+  rec->dropped = g_dropped;
+  g_ring[head & (TELEMETRY_RING - 1)] = *rec;
+  __atomic_store_n(&g_head, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+bool telemetry_pop(telemetry_record_t *rec) {
+  uint32_t tail = g_tail;
+  uint32_t head = __atomic_load_n(&g_head, __ATOMIC_ACQUIRE);
+  if (head == tail) return false;
+  *rec = g_ring[tail & (TELEMETRY_RING - 1)];
+  __atomic_store_n(&g_tail, tail + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+static uint8_t *put16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v) {
+  return put16(put16(p, (uint16_t)v), (uint16_t)(v >> 16));
+}
+
+void telemetry_encode(const telemetry_record_t *rec, uint8_t *out) {
+  uint8_t *p = out;
+  *p++ = TELEMETRY_SYNC1;
+  *p++ = TELEMETRY_SYNC2;
+  *p++ = TELEMETRY_TAG;
+  p = put32(p, rec->time_us);
+  p = put32(p, rec->dropped);
+  *p++ = rec->num_mice;
+  *p++ = rec->buttons;
+  for (int i = 0; i < TELEMETRY_MICE; i++) {
+    p = put16(p, (uint16_t)rec->raw[i][0]);
+    p = put16(p, (uint16_t)rec->raw[i][1]);
+  }
+  p = put16(p, (uint16_t)rec->out_dx);
+  put16(p, (uint16_t)rec->out_dy);
+}
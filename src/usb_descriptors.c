@@ -1,9 +1,17 @@
 /*
- * USB descriptors: 1 CDC (serial) + 6 HID mouse (so Pico shows in /dev as serial).
+ * USB descriptors: 1 CDC (serial, so Pico shows in /dev) + the HID interfaces of the
+ * current descriptor profile, built when the host reads the configuration:
+ *   combined  - 1 HID mouse
+ *   separate  - num_mice HID mice, one endpoint each
+ *   composite - 1 HID interface, six mice by report ID
+ *   absolute  - 1 HID multi-touch digitizer
+ *   raw       - 1 vendor HID interface, all mice in one report, then a vendor HID
+ *               IN/OUT interface for mouse frames from host software
  */
 #include <string.h>
 #include "tusb.h"
 #include "usb_descriptors.h"
+#include "settings.h"
 
 #define USB_VID 0x2E8A
 #define USB_PID 0x000A
@@ -11,49 +19,237 @@
 enum {
   ITF_NUM_CDC_COMM,
   ITF_NUM_CDC_DATA,
-  ITF_NUM_HID0,
-  ITF_NUM_HID1,
-  ITF_NUM_HID2,
-  ITF_NUM_HID3,
-  ITF_NUM_HID4,
-  ITF_NUM_HID5,
-  ITF_NUM_TOTAL
+  ITF_NUM_HID0     /* HID interface k is ITF_NUM_HID0 + k */
 };
 
 #define EPNUM_CDC_NOTIF  0x87
 #define EPNUM_CDC_OUT    0x08
 #define EPNUM_CDC_IN     0x88
-#define EPNUM_HID0       0x81
-#define EPNUM_HID1       0x82
-#define EPNUM_HID2       0x83
-#define EPNUM_HID3       0x84
-#define EPNUM_HID4       0x85
-#define EPNUM_HID5       0x86
-#define CONFIG_LEN       (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + 6 * TUD_HID_DESC_LEN)
+#define EPNUM_HID0       0x81   /* HID interface k uses EPNUM_HID0 + k (0x81..0x86) */
+#define EPNUM_VENDOR_OUT 0x09
+#define EPNUM_VENDOR_IN  0x89
+#define HID_MOUSE_ITF_MAX USB_MOUSE_OUTPUTS
+#define HID_LEN_RAW      (TUD_HID_DESC_LEN + TUD_HID_INOUT_DESC_LEN)
+#define HID_LEN_MAX      (HID_MOUSE_ITF_MAX * TUD_HID_DESC_LEN > HID_LEN_RAW ? HID_MOUSE_ITF_MAX * TUD_HID_DESC_LEN \
+                                                                          : HID_LEN_RAW)
+#define CONFIG_LEN_MAX   (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + HID_LEN_MAX)
+_Static_assert(HID_MOUSE_ITF_MAX <= CFG_TUD_HID && 2 <= CFG_TUD_HID, "CFG_TUD_HID too small for the profiles");
+
+/* 5-button mouse with 8-bit X/Y and 16-bit wheel and AC Pan. Wheel and pan each sit in
+ * a logical collection with a Resolution Multiplier feature (report mult_id): once the
+ * host sets it, one detent is WHEEL_HIRES_MULT units instead of 1. */
+#define DESC_RESOLUTION_MULTIPLIER(id, mult_id) \
+  HID_REPORT_ID(mult_id) \
+  HID_USAGE(0x48), HID_LOGICAL_MIN(0), HID_LOGICAL_MAX(1), \
+  HID_PHYSICAL_MIN(1), HID_PHYSICAL_MAX(WHEEL_HIRES_MULT), \
+  HID_REPORT_SIZE(2), HID_REPORT_COUNT(1), \
+  HID_FEATURE(HID_DATA | HID_VARIABLE | HID_ABSOLUTE), \
+  HID_REPORT_ID(id) \
+  HID_PHYSICAL_MIN(0), HID_PHYSICAL_MAX(0), \
+  HID_LOGICAL_MIN_N(-32767, 2), HID_LOGICAL_MAX_N(32767, 2), \
+  HID_REPORT_SIZE(16), HID_REPORT_COUNT(1)
+
+#define DESC_MOUSE(id, mult_id) \
+  HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP), \
+  HID_USAGE(HID_USAGE_DESKTOP_MOUSE), \
+  HID_COLLECTION(HID_COLLECTION_APPLICATION), \
+    HID_REPORT_ID(id) \
+    HID_USAGE(HID_USAGE_DESKTOP_POINTER), \
+    HID_COLLECTION(HID_COLLECTION_PHYSICAL), \
+      HID_USAGE_PAGE(HID_USAGE_PAGE_BUTTON), \
+      HID_USAGE_MIN(1), HID_USAGE_MAX(5), \
+      HID_LOGICAL_MIN(0), HID_LOGICAL_MAX(1), \
+      HID_REPORT_SIZE(1), HID_REPORT_COUNT(5), \
+      HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE), \
+      HID_REPORT_SIZE(3), HID_REPORT_COUNT(1), \
+      HID_INPUT(HID_CONSTANT), \
+      HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP), \
+      HID_USAGE(HID_USAGE_DESKTOP_X), HID_USAGE(HID_USAGE_DESKTOP_Y), \
+      HID_LOGICAL_MIN(0x81), HID_LOGICAL_MAX(0x7f), \
+      HID_REPORT_SIZE(8), HID_REPORT_COUNT(2), \
+      HID_INPUT(HID_DATA | HID_VARIABLE | HID_RELATIVE), \
+      HID_COLLECTION(HID_COLLECTION_LOGICAL), \
+        DESC_RESOLUTION_MULTIPLIER(id, mult_id), \
+        HID_USAGE(HID_USAGE_DESKTOP_WHEEL), \
+        HID_INPUT(HID_DATA | HID_VARIABLE | HID_RELATIVE), \
+      HID_COLLECTION_END, \
+      HID_COLLECTION(HID_COLLECTION_LOGICAL), \
+        DESC_RESOLUTION_MULTIPLIER(id, mult_id), \
+        HID_USAGE_PAGE(HID_USAGE_PAGE_CONSUMER), \
+        HID_USAGE_N(HID_USAGE_CONSUMER_AC_PAN, 2), \
+        HID_INPUT(HID_DATA | HID_VARIABLE | HID_RELATIVE), \
+      HID_COLLECTION_END, \
+      /* Pad the multiplier feature report to a whole byte */ \
+      HID_REPORT_ID(mult_id) \
+      HID_REPORT_SIZE(4), HID_REPORT_COUNT(1), \
+      HID_FEATURE(HID_CONSTANT), \
+    HID_COLLECTION_END, \
+  HID_COLLECTION_END
 
 uint8_t const desc_hid_report[] = {
-  TUD_HID_REPORT_DESC_MOUSE(HID_REPORT_ID(REPORT_ID_MOUSE))
+  DESC_MOUSE(REPORT_ID_MOUSE, REPORT_ID_MULTIPLIER)
+};
+
+/* Composite: six mice on one interface, told apart by report ID */
+uint8_t const desc_hid_report_composite[] = {
+  DESC_MOUSE(REPORT_ID_COMPOSITE_MOUSE(0), REPORT_ID_COMPOSITE_MULT(0)),
+  DESC_MOUSE(REPORT_ID_COMPOSITE_MOUSE(1), REPORT_ID_COMPOSITE_MULT(1)),
+  DESC_MOUSE(REPORT_ID_COMPOSITE_MOUSE(2), REPORT_ID_COMPOSITE_MULT(2)),
+  DESC_MOUSE(REPORT_ID_COMPOSITE_MOUSE(3), REPORT_ID_COMPOSITE_MULT(3)),
+  DESC_MOUSE(REPORT_ID_COMPOSITE_MOUSE(4), REPORT_ID_COMPOSITE_MULT(4)),
+  DESC_MOUSE(REPORT_ID_COMPOSITE_MOUSE(5), REPORT_ID_COMPOSITE_MULT(5))
 };
 
+/* One finger contact: tip switch, in range, contact id, 16-bit absolute X/Y */
+#define DESC_TOUCH_CONTACT \
+  HID_USAGE_PAGE(HID_USAGE_PAGE_DIGITIZER), \
+  HID_USAGE(0x22), /* Finger */ \
+  HID_COLLECTION(HID_COLLECTION_LOGICAL), \
+    HID_USAGE(0x42), HID_USAGE(0x32), /* Tip Switch, In Range */ \
+    HID_LOGICAL_MIN(0), HID_LOGICAL_MAX(1), \
+    HID_REPORT_SIZE(1), HID_REPORT_COUNT(2), \
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE), \
+    HID_REPORT_COUNT(6), HID_INPUT(HID_CONSTANT), \
+    HID_USAGE(0x51), /* Contact Identifier */ \
+    HID_LOGICAL_MAX(ABS_CONTACTS - 1), \
+    HID_REPORT_SIZE(8), HID_REPORT_COUNT(1), \
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE), \
+    HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP), \
+    HID_USAGE(HID_USAGE_DESKTOP_X), HID_USAGE(HID_USAGE_DESKTOP_Y), \
+    HID_LOGICAL_MAX_N(ABS_LOGICAL_MAX, 2), \
+    HID_REPORT_SIZE(16), HID_REPORT_COUNT(2), \
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE), \
+  HID_COLLECTION_END
+
+/* Multi-touch screen with one contact per mouse, all sent in one report per frame */
+uint8_t const desc_hid_report_touch[] = {
+  HID_USAGE_PAGE(HID_USAGE_PAGE_DIGITIZER),
+  HID_USAGE(0x04), /* Touch Screen */
+  HID_COLLECTION(HID_COLLECTION_APPLICATION),
+    HID_REPORT_ID(REPORT_ID_TOUCH)
+    DESC_TOUCH_CONTACT, DESC_TOUCH_CONTACT, DESC_TOUCH_CONTACT,
+    DESC_TOUCH_CONTACT, DESC_TOUCH_CONTACT, DESC_TOUCH_CONTACT,
+    HID_USAGE_PAGE(HID_USAGE_PAGE_DIGITIZER),
+    HID_USAGE(0x54), /* Contact Count */
+    HID_LOGICAL_MAX(ABS_CONTACTS),
+    HID_REPORT_SIZE(8), HID_REPORT_COUNT(1),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+    HID_REPORT_ID(REPORT_ID_TOUCH_MAX)
+    HID_USAGE(0x55), /* Contact Count Maximum */
+    HID_FEATURE(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+  HID_COLLECTION_END
+};
+
+/* Vendor-defined report with every mouse: count, then RAW_SLOTS x mouse report layout.
+ * Not a pointer to the OS; read it with hidraw (see README). */
+uint8_t const desc_hid_report_raw[] = {
+  HID_USAGE_PAGE_N(HID_USAGE_PAGE_VENDOR, 2),
+  HID_USAGE(0x01),
+  HID_COLLECTION(HID_COLLECTION_APPLICATION),
+    HID_REPORT_ID(REPORT_ID_RAW)
+    HID_USAGE(0x02),
+    HID_LOGICAL_MIN(0x00), HID_LOGICAL_MAX_N(0xff, 2),
+    HID_REPORT_SIZE(8), HID_REPORT_COUNT(RAW_REPORT_LEN),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+  HID_COLLECTION_END
+};
+
+/* Vendor raw interface: 64-byte IN/OUT reports without report ID */
+uint8_t const desc_hid_report_vendor[] = {
+  TUD_HID_REPORT_DESC_GENERIC_INOUT(CFG_TUD_HID_EP_BUFSIZE)
+};
+
+/* Profile the host enumerated; valid once it has read the configuration descriptor */
+static usb_profile_t g_usb;
+static bool g_usb_latched;
+static uint8_t g_desc_config[CONFIG_LEN_MAX];
+
+void usb_profile_from_settings(usb_profile_t *p) {
+  settings_t s;
+  settings_acquire(&s);
+  p->output_mode = s.output_mode;
+  p->hid_count = s.output_mode == SETTINGS_OUTPUT_SEPARATE ? s.num_mice : 1;
+  if (p->hid_count > HID_MOUSE_ITF_MAX) p->hid_count = HID_MOUSE_ITF_MAX;
+  p->vendor = s.output_mode == SETTINGS_OUTPUT_RAW;
+}
+
+const usb_profile_t *usb_profile(void) {
+  if (!g_usb_latched)
+    usb_profile_from_settings(&g_usb);
+  return &g_usb;
+}
+
+uint8_t usb_output_mode(void) {
+  return usb_profile()->output_mode;
+}
+
+bool usb_profile_stale(void) {
+  usb_profile_t want;
+  if (!g_usb_latched) return false;
+  usb_profile_from_settings(&want);
+  return want.output_mode != g_usb.output_mode || want.hid_count != g_usb.hid_count;
+}
+
+uint8_t usb_vendor_instance(void) {
+  const usb_profile_t *p = usb_profile();
+  return p->vendor ? p->hid_count : USB_VENDOR_NONE;
+}
+
 uint8_t const *tud_hid_descriptor_report_cb(uint8_t instance) {
-  (void)instance;
-  return desc_hid_report;
+  if (g_usb.vendor && instance == g_usb.hid_count)
+    return desc_hid_report_vendor;
+  switch (g_usb.output_mode) {
+    case SETTINGS_OUTPUT_ABSOLUTE:  return desc_hid_report_touch;
+    case SETTINGS_OUTPUT_COMPOSITE: return desc_hid_report_composite;
+    case SETTINGS_OUTPUT_RAW:       return desc_hid_report_raw;
+    default:                        return desc_hid_report;
+  }
 }
 
-uint8_t const desc_configuration[] = {
-  TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_LEN, 0x00, 100),
-  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_COMM, 0, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN, 64),
-  TUD_HID_DESCRIPTOR(ITF_NUM_HID0, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID0, CFG_TUD_HID_EP_BUFSIZE, 5),
-  TUD_HID_DESCRIPTOR(ITF_NUM_HID1, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID1, CFG_TUD_HID_EP_BUFSIZE, 5),
-  TUD_HID_DESCRIPTOR(ITF_NUM_HID2, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID2, CFG_TUD_HID_EP_BUFSIZE, 5),
-  TUD_HID_DESCRIPTOR(ITF_NUM_HID3, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID3, CFG_TUD_HID_EP_BUFSIZE, 5),
-  TUD_HID_DESCRIPTOR(ITF_NUM_HID4, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID4, CFG_TUD_HID_EP_BUFSIZE, 5),
-  TUD_HID_DESCRIPTOR(ITF_NUM_HID5, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID5, CFG_TUD_HID_EP_BUFSIZE, 5)
-};
+static uint16_t report_desc_len(uint8_t output_mode) {
+  switch (output_mode) {
+    case SETTINGS_OUTPUT_ABSOLUTE:  return sizeof(desc_hid_report_touch);
+    case SETTINGS_OUTPUT_COMPOSITE: return sizeof(desc_hid_report_composite);
+    case SETTINGS_OUTPUT_RAW:       return sizeof(desc_hid_report_raw);
+    default:                        return sizeof(desc_hid_report);
+  }
+}
 
+/* Build the configuration for the current settings and latch it as the enumerated profile.
+ * The combined and per-mouse endpoints are polled once per report frame (HID_POLL_MS).
+ * Single-interface profiles carry every mouse on one endpoint, so it is polled every 1 ms. */
 uint8_t const *tud_descriptor_configuration_cb(uint8_t index) {
   (void)index;
-  return desc_configuration;
+  usb_profile_from_settings(&g_usb);
+  g_usb_latched = true;
+
+  uint16_t rlen = report_desc_len(g_usb.output_mode);
+  uint8_t interval = g_usb.output_mode == SETTINGS_OUTPUT_COMBINED ||
+                     g_usb.output_mode == SETTINGS_OUTPUT_SEPARATE ? HID_POLL_MS : 1;
+  uint8_t vendor_itfs = g_usb.vendor ? 1 : 0;
+  uint16_t total = (uint16_t)(TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + g_usb.hid_count * TUD_HID_DESC_LEN +
+                              vendor_itfs * TUD_HID_INOUT_DESC_LEN);
+  uint8_t const head[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_HID0 + g_usb.hid_count + vendor_itfs, 0, total, 0x00, 100),
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_COMM, 0, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN, 64)
+  };
+  uint16_t pos = sizeof(head);
+  memcpy(g_desc_config, head, sizeof(head));
+  for (uint8_t k = 0; k < g_usb.hid_count; k++) {
+    uint8_t const hid[] = {
+      TUD_HID_DESCRIPTOR(ITF_NUM_HID0 + k, 0, HID_ITF_PROTOCOL_NONE, rlen, EPNUM_HID0 + k, CFG_TUD_HID_EP_BUFSIZE, interval)
+    };
+    memcpy(g_desc_config + pos, hid, sizeof(hid));
+    pos += sizeof(hid);
+  }
+  if (g_usb.vendor) {
+    uint8_t const vendor[] = {
+      TUD_HID_INOUT_DESCRIPTOR(ITF_NUM_HID0 + g_usb.hid_count, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report_vendor),
+                               EPNUM_VENDOR_OUT, EPNUM_VENDOR_IN, CFG_TUD_HID_EP_BUFSIZE, 1)
+    };
+    memcpy(g_desc_config + pos, vendor, sizeof(vendor));
+  }
+  return g_desc_config;
 }
 
 static uint16_t _desc_str[32 + 1];
@@ -69,7 +265,7 @@ uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
       chr_count = 1;
       break;
     case 1: str = "Mouse"; break;
-    case 2: str = "6-Input Amplified Mouse"; break;
+    case 2: str = "Multi-Input Amplified Mouse"; break;
     default: return NULL;
   }
 
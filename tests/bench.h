@@ -0,0 +1,19 @@
+/**
+ * Timing for the host benchmarks: a monotonic clock in nanoseconds, and a sink the
+ * compiler can't see through so measured work isn't optimised away.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <time.h>
+
+static volatile int64_t bench_sink;
+
+static inline uint64_t bench_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+#endif
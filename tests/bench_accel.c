@@ -0,0 +1,157 @@
+/**
+ * accel: the gain table against evaluating the curve directly on every report.
+ *
+ * The table must hold accel_eval() to within half a Q8 step at every speed, and a
+ * million-report trace run through accel_apply() must come out within 0.5% of the
+ * same trace scaled by the float curve. Then both are timed per report and for the
+ * curve alone, along with what one accel_build() costs when settings change. On the
+ * PC the FPU hides most of the difference; on the RP2040's soft float it doesn't.
+ */
+#include "accel.h"
+#include "bench.h"
+#include "check.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPORTS  1000000
+#define BUILDS   2000
+#define LOOKUPS  10000000
+
+/* accel.c's magnitude estimate and speed window, with the curve evaluated per report */
+typedef struct {
+  uint32_t hist_ms[ACCEL_HIST_LEN];
+  uint16_t hist_mag[ACCEL_HIST_LEN];
+  uint8_t hist_pos;
+  float res[2];
+} direct_t;
+
+static uint16_t magnitude(int32_t dx, int32_t dy) {
+  uint32_t ax = (uint32_t)(dx < 0 ? -dx : dx);
+  uint32_t ay = (uint32_t)(dy < 0 ? -dy : dy);
+  uint32_t m = ax > ay ? ax + (ay >> 1) : ay + (ax >> 1);
+  return m > 0xFFFF ? 0xFFFF : (uint16_t)m;
+}
+
+static void direct_apply(direct_t *a, const settings_t *s, int32_t *dx, int32_t *dy, uint32_t now_ms) {
+  if (*dx == 0 && *dy == 0)
+    return;
+  a->hist_ms[a->hist_pos] = now_ms;
+  a->hist_mag[a->hist_pos] = magnitude(*dx, *dy);
+  a->hist_pos = (uint8_t)((a->hist_pos + 1) % ACCEL_HIST_LEN);
+  uint32_t speed = 0;
+  for (int i = 0; i < ACCEL_HIST_LEN; i++)
+    if (now_ms - a->hist_ms[i] < s->accel_window_ms)
+      speed += a->hist_mag[i];
+  if (speed >= ACCEL_LUT_SIZE) speed = ACCEL_LUT_SIZE - 1;
+  float g = accel_eval(s, (int)speed);
+  float ox = (float)*dx * g + a->res[0], oy = (float)*dy * g + a->res[1];
+  *dx = (int32_t)floorf(ox);
+  *dy = (int32_t)floorf(oy);
+  a->res[0] = ox - (float)*dx;
+  a->res[1] = oy - (float)*dy;
+}
+
+/* Hand motion at 1 kHz: strokes of random speed and direction, with pauses */
+static int32_t g_dx[REPORTS], g_dy[REPORTS];
+
+static void make_trace(void) {
+  srand(3);
+  int left = 0;
+  float vx = 0, vy = 0, fx = 0, fy = 0;
+  for (int i = 0; i < REPORTS; i++) {
+    if (left-- <= 0) {
+      left = 20 + rand() % 400;
+      float speed = rand() % 4 == 0 ? 0.0f : (float)(rand() % 4000) / 100.0f;
+      float dir = (float)(rand() % 628) / 100.0f;
+      vx = speed * cosf(dir);
+      vy = speed * sinf(dir);
+    }
+    fx += vx;
+    fy += vy;
+    g_dx[i] = (int32_t)fx;
+    g_dy[i] = (int32_t)fy;
+    fx -= (float)g_dx[i];
+    fy -= (float)g_dy[i];
+  }
+}
+
+static void run(const char *name, const settings_t *s) {
+  static accel_t a;
+  accel_build(&a, s, 1);
+
+  /* The table is the curve, rounded to Q8 */
+  for (int v = 0; v < ACCEL_LUT_SIZE; v++)
+    CHECK(fabsf((float)a.gain_q8[v] / 256.0f - accel_eval(s, v)) <= 0.5f / 256.0f + 1e-6f);
+
+  long long lx = 0, ly = 0, fx = 0, fy = 0;
+  for (uint32_t i = 0; i < REPORTS; i++) {   /* warm up: caches, branch history */
+    int32_t dx = g_dx[i], dy = g_dy[i];
+    accel_apply(&a, &dx, &dy, i);
+  }
+  accel_build(&a, s, 1);
+  uint64_t t0 = bench_now_ns();
+  for (uint32_t i = 0; i < REPORTS; i++) {
+    int32_t dx = g_dx[i], dy = g_dy[i];
+    accel_apply(&a, &dx, &dy, i);
+    lx += dx;
+    ly += dy;
+  }
+  uint64_t t1 = bench_now_ns();
+  direct_t d;
+  memset(&d, 0, sizeof(d));
+  for (uint32_t i = 0; i < REPORTS; i++) {
+    int32_t dx = g_dx[i], dy = g_dy[i];
+    direct_apply(&d, s, &dx, &dy, i);
+    fx += dx;
+    fy += dy;
+  }
+  uint64_t t2 = bench_now_ns();
+  for (int k = 0; k < BUILDS; k++)
+    accel_build(&a, s, (uint32_t)k);
+  uint64_t t3 = bench_now_ns();
+
+  /* The curve alone: one gain per speed, table against accel_eval() */
+  uint32_t g = 0, sp = 1;
+  for (int k = 0; k < LOOKUPS; k++) {
+    sp = sp * 1103515245u + 12345u;
+    g += a.gain_q8[(sp >> 16) & (ACCEL_LUT_SIZE - 1)];
+  }
+  uint64_t t4 = bench_now_ns();
+  float gf = 0;
+  for (int k = 0; k < LOOKUPS; k++) {
+    sp = sp * 1103515245u + 12345u;
+    gf += accel_eval(s, (int)((sp >> 16) & (ACCEL_LUT_SIZE - 1)));
+  }
+  uint64_t t5 = bench_now_ns();
+  bench_sink = lx + ly + fx + fy + g + (int64_t)gf;
+
+  double ex = fabs((double)(lx - fx)) / (double)llabs(fx), ey = fabs((double)(ly - fy)) / (double)llabs(fy);
+  printf("%-8s %8.2f %8.2f %10.2f %10.2f %9.2f   %+.3f%% %+.3f%%\n", name, (double)(t1 - t0) / REPORTS,
+         (double)(t2 - t1) / REPORTS, (double)(t4 - t3) / LOOKUPS, (double)(t5 - t4) / LOOKUPS,
+         (double)(t3 - t2) / BUILDS / 1000.0, 100.0 * ex, 100.0 * ey);
+  CHECK(ex < 0.005 && ey < 0.005);
+}
+
+int main(void) {
+  make_trace();
+  settings_t s;
+  memset(&s, 0, sizeof(s));
+  s.accel_window_ms = 20;
+  s.accel_threshold = 4;
+  s.accel_max_x100 = 400;
+  printf("         per report (ns)   curve only (ns)\n");
+  printf("mode          LUT     eval      table       eval  build us   LUT vs eval (X, Y)\n");
+  s.accel_mode = SETTINGS_ACCEL_LINEAR;
+  s.accel_rate = 50;
+  run("linear", &s);
+  s.accel_mode = SETTINGS_ACCEL_EXP;
+  s.accel_rate = 20;
+  run("exp", &s);
+  s.accel_window_ms = 64;
+  s.accel_threshold = 0;
+  s.accel_max_x100 = 1000;
+  s.accel_rate = 5;
+  run("exp wide", &s);
+  return check_done("bench_accel");
+}
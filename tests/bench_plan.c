@@ -0,0 +1,180 @@
+/**
+ * plan: the combined-mode logic and gain stage before and after the execution plan.
+ *
+ * "before" is aggregate_and_amplify() as it was ahead of plan.c (transform, accel and
+ * fusion left out, since neither side changed them): it reads the settings snapshot
+ * every frame, picks the logic mode by a chain of comparisons, divides for AVERAGE
+ * and multiplies by the float gain. "after" is the plan's logic kernel and
+ * plan_amplify(). Both run the same random frames for every logic mode and a few
+ * gains; the results may differ only by the one count the float product rounded, and
+ * not at all at gain 1.0. On the PC the FPU and divider make the old path cheap; the
+ * M0+ has neither, so the host numbers understate the saving.
+ */
+#include "plan.h"
+#include "bench.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAMES  4096
+#define ROUNDS  500   /* passes over the frames per timing */
+#define MICE    6
+
+static int32_t g_mx[FRAMES][MICE], g_my[FRAMES][MICE];
+static uint32_t g_live[FRAMES];
+static settings_t g_cfg;   /* the snapshot the old path read every frame */
+
+/* Pre-plan logic for 2-ball modes: plan.c's, which was moved there unchanged */
+static int32_t logic2_axis(uint8_t mode, int32_t a, int32_t b) {
+  int32_t aa = a < 0 ? -a : a, ab = b < 0 ? -b : b;
+  switch (mode) {
+    case SETTINGS_LOGIC_2_MIN:  return aa <= ab ? a : b;
+    case SETTINGS_LOGIC_2_AND:
+      if (a == 0 || b == 0) return 0;
+      if ((a > 0) != (b > 0)) return 0;
+      return aa <= ab ? a : b;
+    case SETTINGS_LOGIC_2_OR:   return a + b;
+    case SETTINGS_LOGIC_2_XOR:
+      if (a == 0) return b;
+      if (b == 0) return a;
+      return a - b;
+    case SETTINGS_LOGIC_2_NAND:
+      if (a != 0 && b != 0) return 0;
+      return a + b;
+    case SETTINGS_LOGIC_2_NOR:  return 0;
+    case SETTINGS_LOGIC_2_XNOR:
+      if (a == 0 && b == 0) return 0;
+      if (a == 0) return b;
+      if (b == 0) return a;
+      if ((a > 0) != (b > 0)) return 0;
+      return (a + b) / 2;
+    default: return a + b;
+  }
+}
+
+__attribute__((noinline))
+static void before(const int32_t *mx, const int32_t *my, uint32_t live, int32_t *out_dx, int32_t *out_dy) {
+  int32_t dx = 0, dy = 0;
+  const settings_t *s = &g_cfg;
+  int n = s->num_mice;
+  uint8_t lm = s->logic_mode;
+  if (lm == SETTINGS_LOGIC_SUM) {
+    for (int i = 0; i < n; i++) {
+      dx += mx[i];
+      dy += my[i];
+    }
+  } else if (lm == SETTINGS_LOGIC_AVERAGE) {
+    int n_live = 0;
+    for (int i = 0; i < n; i++) {
+      dx += mx[i];
+      dy += my[i];
+      if (live & (1u << i)) n_live++;
+    }
+    if (n_live > 0) {
+      dx /= n_live;
+      dy /= n_live;
+    }
+  } else if (lm == SETTINGS_LOGIC_MAX) {
+    int32_t best_dx = 0, best_dy = 0;
+    int32_t best_adx = 0, best_ady = 0;
+    for (int i = 0; i < n; i++) {
+      int32_t adx = mx[i];
+      int32_t ady = my[i];
+      if (adx < 0) adx = -adx;
+      if (ady < 0) ady = -ady;
+      if (adx >= best_adx) { best_adx = adx; best_dx = mx[i]; }
+      if (ady >= best_ady) { best_ady = ady; best_dy = my[i]; }
+    }
+    dx = best_dx;
+    dy = best_dy;
+  } else if (lm >= SETTINGS_LOGIC_2_MIN && lm <= SETTINGS_LOGIC_2_XNOR) {
+    dx = logic2_axis(lm, mx[0], mx[1]);
+    dy = logic2_axis(lm, my[0], my[1]);
+  } else {
+    for (int i = 0; i < n; i++) {
+      dx += mx[i];
+      dy += my[i];
+    }
+  }
+  *out_dx = (int32_t)((float)dx * s->amplify);
+  *out_dy = (int32_t)((float)dy * s->amplify);
+}
+
+__attribute__((noinline))
+static void after(const plan_t *p, const int32_t *mx, const int32_t *my, uint32_t live, int32_t *dx, int32_t *dy) {
+  p->logic(p, mx, my, live, dx, dy);
+  *dx = plan_amplify(p, *dx);
+  *dy = plan_amplify(p, *dy);
+}
+
+static const struct { uint8_t mode; const char *name; } modes[] = {
+  { SETTINGS_LOGIC_SUM, "sum" },
+  { SETTINGS_LOGIC_AVERAGE, "average" },
+  { SETTINGS_LOGIC_MAX, "max" },
+  { SETTINGS_LOGIC_2_AND, "2-ball and" },
+  { SETTINGS_LOGIC_2_XNOR, "2-ball xnor" },
+};
+
+static const float gains[] = { 1.0f, 1.5f, 2.37f, 0.33f };
+
+int main(void) {
+  srand(6);
+  for (int k = 0; k < FRAMES; k++) {
+    for (int i = 0; i < MICE; i++) {
+      /* mostly small deltas, some idle mice, now and then a fast flick */
+      int r = rand() % 10;
+      g_mx[k][i] = r < 2 ? 0 : r < 9 ? rand() % 41 - 20 : rand() % 2001 - 1000;
+      g_my[k][i] = r < 2 ? 0 : r < 9 ? rand() % 41 - 20 : rand() % 2001 - 1000;
+    }
+    g_live[k] = (uint32_t)rand() & ((1u << MICE) - 1);
+  }
+
+  printf("mode         gain   before ns  after ns   differing frames\n");
+  long long off_by_one = 0, worse = 0;
+  for (unsigned m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+    for (unsigned gi = 0; gi < sizeof(gains) / sizeof(gains[0]); gi++) {
+      memset(&g_cfg, 0, sizeof(g_cfg));
+      g_cfg.num_mice = MICE;
+      g_cfg.logic_mode = modes[m].mode;
+      g_cfg.amplify = gains[gi];
+      g_cfg.quad_scale = 1;
+      plan_t p;
+      plan_build(&p, &g_cfg);
+
+      long long diff = 0;
+      for (int k = 0; k < FRAMES; k++) {
+        int32_t bx, by, ax, ay;
+        before(g_mx[k], g_my[k], g_live[k], &bx, &by);
+        after(&p, g_mx[k], g_my[k], g_live[k], &ax, &ay);
+        int32_t ex = bx - ax, ey = by - ay;
+        if (ex || ey) diff++;
+        if (ex < -1 || ex > 1 || ey < -1 || ey > 1) worse++;
+        if (gains[gi] == 1.0f) CHECK(ex == 0 && ey == 0);
+      }
+      off_by_one += diff;
+
+      int64_t sink = 0;
+      uint64_t t0 = bench_now_ns();
+      for (int r = 0; r < ROUNDS; r++)
+        for (int k = 0; k < FRAMES; k++) {
+          int32_t x, y;
+          before(g_mx[k], g_my[k], g_live[k], &x, &y);
+          sink += x + y;
+        }
+      uint64_t t1 = bench_now_ns();
+      for (int r = 0; r < ROUNDS; r++)
+        for (int k = 0; k < FRAMES; k++) {
+          int32_t x, y;
+          after(&p, g_mx[k], g_my[k], g_live[k], &x, &y);
+          sink += x + y;
+        }
+      uint64_t t2 = bench_now_ns();
+      bench_sink = sink;
+      printf("%-12s %4.2f   %9.2f %9.2f   %5lld / %d\n", modes[m].name, (double)gains[gi],
+             (double)(t1 - t0) / (ROUNDS * FRAMES), (double)(t2 - t1) / (ROUNDS * FRAMES), diff, FRAMES);
+    }
+  }
+  printf("%lld frames off by one count (float rounding), %lld by more\n", off_by_one, worse);
+  CHECK_EQ(worse, 0);
+  return check_done("bench_plan");
+}
@@ -0,0 +1,176 @@
+/**
+ * quad: edge-rate stress for the IRQ sampler.
+ *
+ * First the decoder's own cost: quad_step() per sample with one axis or all twelve
+ * changing, and quad_vote() for the glitch filter.
+ *
+ * Then the edge interrupt, simulated. Every active axis turns at the same rate with its
+ * own phase and +-10% jitter (edges alternate A and B). An edge raises the IRQ; the
+ * handler samples all pins QUAD_SAMPLE_NS after entry, runs quad_step() on the sample,
+ * and is busy until HANDLER cost has passed; edges meanwhile leave the IRQ pending, so
+ * it runs again straight away. The sampler keeps up as long as no axis moves twice
+ * between two samples. For each handler cost and number of moving axes, the highest
+ * per-axis edge rate that loses nothing over QUAD_SIM_MS is found by bisection and
+ * checked against the decoded counts. One IRQ samples every pin, so once the handler
+ * is busy all the time the limit is about one edge per handler run whatever the number
+ * of moving axes. On the board, the status reply's quad block (tag 0x05) has the
+ * handler's cycles per IRQ to read the table at.
+ */
+#include "quad.h"
+#include "bench.h"
+#include "check.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define STEPS          2000000
+#define QUAD_SIM_MS    20
+#define QUAD_SAMPLE_NS 200.0    /* IRQ entry and acknowledge, to the pin read */
+#define AXES           (QUAD_MICE * 2)
+
+static const uint32_t gray[4] = { 0, 1, 3, 2 };
+
+/* ---- Decoder cost ---- */
+
+static void bench_decoder(void) {
+  static uint32_t one[1024], all[1024];
+  int p1 = 0, pa[AXES] = { 0 };
+  for (int k = 0; k < 1024; k++) {
+    p1++;
+    one[k] = gray[p1 & 3];
+    all[k] = 0;
+    for (int a = 0; a < AXES; a++) {
+      pa[a] += (a & 1) ? -1 : 1;
+      all[k] |= gray[pa[a] & 3] << (2 * a);
+    }
+  }
+  quad_state_t q;
+  uint32_t acc = 0;
+  quad_reset(&q, 0);
+  uint64_t t0 = bench_now_ns();
+  for (int k = 0; k < STEPS; k++)
+    acc += quad_step(&q, one[k & 1023]);
+  uint64_t t1 = bench_now_ns();
+  quad_reset(&q, 0);
+  for (int k = 0; k < STEPS; k++)
+    acc += quad_step(&q, all[k & 1023]);
+  uint64_t t2 = bench_now_ns();
+  for (int k = 0; k < STEPS; k++)
+    acc += quad_step(&q, all[1023]);   /* no change */
+  uint64_t t3 = bench_now_ns();
+  uint32_t s[5] = { 1, 2, 3, 4, 5 };
+  for (int k = 0; k < STEPS; k++) {
+    s[k % 5] = all[k & 1023];
+    acc += quad_vote(s, 5);
+  }
+  uint64_t t4 = bench_now_ns();
+  bench_sink = acc;
+  printf("quad_step: %.2f ns (1 axis), %.2f ns (12 axes), %.2f ns (no change); quad_vote(5): %.2f ns\n",
+         (double)(t1 - t0) / STEPS, (double)(t2 - t1) / STEPS, (double)(t3 - t2) / STEPS,
+         (double)(t4 - t3) / STEPS);
+}
+
+/* ---- IRQ sampler simulation ---- */
+
+typedef struct {
+  double next;      /* time of this axis's next edge, ns */
+  double period;    /* ns between edges */
+  int pos;          /* edges so far (= counts) */
+} axis_t;
+
+typedef struct {
+  long long illegal, lost, irqs;
+  double busy_ns;
+} sim_t;
+
+static double jitter(double period) {
+  return period * (0.9 + 0.2 * (double)rand() / RAND_MAX);
+}
+
+/* Simulate n moving axes at edge_hz each, handler cost handler_ns. */
+static sim_t simulate(int n, double edge_hz, double handler_ns) {
+  axis_t ax[AXES];
+  double period = 1e9 / edge_hz;
+  srand(8);
+  for (int a = 0; a < n; a++) {
+    ax[a].period = period;
+    ax[a].next = period * (double)rand() / RAND_MAX;
+    ax[a].pos = 0;
+  }
+  quad_state_t q;
+  quad_reset(&q, 0);
+  sim_t r = { 0, 0, 0, 0.0 };
+  double end = QUAD_SIM_MS * 1e6, t = 0;
+  while (1) {
+    /* IRQ entry: at the first edge not yet seen, or straight after the last run */
+    double first = end;
+    for (int a = 0; a < n; a++)
+      if (ax[a].next < first) first = ax[a].next;
+    if (first >= end) break;
+    double entry = first > t ? first : t;
+    double sample_at = entry + QUAD_SAMPLE_NS;
+    uint32_t sample = 0;
+    for (int a = 0; a < n; a++) {
+      while (ax[a].next <= sample_at) {
+        ax[a].pos++;
+        ax[a].next += jitter(ax[a].period);
+      }
+      sample |= gray[ax[a].pos & 3] << (2 * a);
+    }
+    if (quad_step(&q, sample) & QUAD_STEP_ILLEGAL)
+      r.illegal++;
+    r.irqs++;
+    t = entry + handler_ns;
+    r.busy_ns += handler_ns;
+  }
+  for (int a = 0; a < n; a++)
+    r.lost += llabs((long long)ax[a].pos - q.acc[a >> 1][a & 1]);
+  return r;
+}
+
+/* Highest edge rate per axis with nothing lost (to 1%) */
+static double max_rate(int n, double handler_ns, sim_t *at) {
+  double lo = 1e3, hi = 2e7;
+  while (hi / lo > 1.01) {
+    double mid = sqrt(lo * hi);
+    sim_t r = simulate(n, mid, handler_ns);
+    if (r.illegal == 0 && r.lost == 0) {
+      lo = mid;
+      *at = r;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+int main(void) {
+  bench_decoder();
+
+  static const double handler_us[] = { 0.5, 1.0, 2.0, 4.0 };
+  static const int moving[] = { 1, 4, 12 };
+  printf("\nmax edge rate per axis before the IRQ sampler loses steps (kHz; CPU in the handler)\n");
+  printf("handler    1 axis           4 axes           12 axes\n");
+  double prev12 = 1e30;
+  for (unsigned h = 0; h < sizeof(handler_us) / sizeof(handler_us[0]); h++) {
+    printf("%4.1f us ", handler_us[h]);
+    double rate1 = 0;
+    for (unsigned m = 0; m < sizeof(moving) / sizeof(moving[0]); m++) {
+      sim_t at = { 0, 0, 0, 0.0 };
+      double r = max_rate(moving[m], handler_us[h] * 1000.0, &at);
+      printf("  %7.1f (%3.0f%%)", r / 1000.0, 100.0 * at.busy_ns / (QUAD_SIM_MS * 1e6));
+      if (m == 0) rate1 = r;
+      if (m == 2) {
+        CHECK(r < prev12);   /* a slower handler never keeps up with more */
+        prev12 = r;
+      }
+      /* The decode is exact at the limit, and it is a real limit: 20% over it loses steps */
+      CHECK_EQ(at.lost, 0);
+      sim_t over = simulate(moving[m], r * 1.2, handler_us[h] * 1000.0);
+      CHECK(over.illegal > 0 || over.lost > 0);
+    }
+    /* One axis: a sample between every two edges, so the limit is near 1 / handler */
+    CHECK(rate1 > 0.8e6 / handler_us[h] && rate1 < 1.2e6 / handler_us[h]);
+    printf("\n");
+  }
+  return check_done("bench_quad");
+}
@@ -0,0 +1,184 @@
+/**
+ * Aggregation cost against the slot count, on a build with every slot compiled in
+ * (tests/cfg16: MAX_MICE 16). For 2 to 16 mice, per frame: the liveness mask and
+ * the sum, average and max kernels, velocity-weighted fusion, and the cascade frame
+ * carrying one record per mouse up the chain. The kernels are checked against plain
+ * loops, fusion of identical inputs against their total, and the cascade frame
+ * against its records; the timings show whether the per-mouse cost stays flat as
+ * slots are added.
+ */
+#include "plan.h"
+#include "fusion.h"
+#include "liveness.h"
+#include "cascade.h"
+#include "bench.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAMES  1024
+#define ROUNDS  200   /* passes over the frames per timing */
+#define SLOTS   16
+
+_Static_assert(SETTINGS_NUM_MICE_MAX == SLOTS, "bench_slots wants the 16-slot config (tests/cfg16)");
+
+static int32_t g_mx[FRAMES][SLOTS], g_my[FRAMES][SLOTS];
+
+static void plan_for(plan_t *p, int n, uint8_t logic_mode) {
+  settings_t s;
+  memset(&s, 0, sizeof(s));
+  s.num_mice = (uint8_t)n;
+  s.logic_mode = logic_mode;
+  s.amplify = 1.0f;
+  s.quad_scale = 1;
+  memset(s.slot_src, SETTINGS_SRC_ALL, sizeof(s.slot_src));
+  plan_build(p, &s);
+}
+
+/* The kernels against plain loops, on every frame */
+static void check_kernels(int n) {
+  plan_t sum, avg, max;
+  plan_for(&sum, n, SETTINGS_LOGIC_SUM);
+  plan_for(&avg, n, SETTINGS_LOGIC_AVERAGE);
+  plan_for(&max, n, SETTINGS_LOGIC_MAX);
+  CHECK(avg.needs_live);
+  for (int k = 0; k < FRAMES; k++) {
+    const int32_t *mx = g_mx[k], *my = g_my[k];
+    uint32_t live = (uint32_t)(k * 2654435761u) & ((1u << n) - 1);
+    int32_t sx = 0, sy = 0, bx = 0, by = 0, bax = 0, bay = 0;
+    int n_live = 0;
+    for (int i = 0; i < n; i++) {
+      sx += mx[i];
+      sy += my[i];
+      if (live & (1u << i)) n_live++;
+      int32_t ax = abs(mx[i]), ay = abs(my[i]);
+      if (ax >= bax) { bax = ax; bx = mx[i]; }
+      if (ay >= bay) { bay = ay; by = my[i]; }
+    }
+    int32_t dx, dy;
+    sum.logic(&sum, mx, my, live, &dx, &dy);
+    CHECK(dx == sx && dy == sy);
+    avg.logic(&avg, mx, my, live, &dx, &dy);
+    CHECK(dx == (n_live ? sx / n_live : sx) && dy == (n_live ? sy / n_live : sy));
+    max.logic(&max, mx, my, live, &dx, &dy);
+    CHECK(dx == bx && dy == by);
+  }
+}
+
+/* n copies of one trace: fusion must put out the trace's total, whatever n */
+static void check_fusion(int n) {
+  fusion_t f;
+  fusion_reset(&f);
+  int32_t in_x = 0, in_y = 0, out_x = 0, out_y = 0;
+  int32_t mx[SLOTS], my[SLOTS];
+  for (int k = 0; k < FRAMES + 200; k++) {
+    int32_t x = k < FRAMES ? g_mx[k][0] : 0, y = k < FRAMES ? g_my[k][0] : 0;
+    for (int i = 0; i < n; i++) {
+      mx[i] = x;
+      my[i] = y;
+    }
+    in_x += x;
+    in_y += y;
+    int32_t dx, dy;
+    fusion_step(&f, mx, my, n, (1u << n) - 1, &dx, &dy);
+    out_x += dx;
+    out_y += dy;
+  }
+  CHECK(abs(out_x - in_x) <= 1 && abs(out_y - in_y) <= 1);
+}
+
+/* One cascade frame carries every mouse, and decodes back to what went in */
+static void check_cascade(int n) {
+  cascade_tx_t t;
+  uint8_t frame[CASCADE_LEN_MAX];
+  cascade_tx_reset(&t);
+  for (int i = 0; i < n; i++)
+    cascade_tx_add(&t, i, 0, g_mx[0][i], g_my[0][i], 0, 0, 0, 0);
+  int len = cascade_tx_frame(&t, frame, 0);
+  CHECK_EQ(len, CASCADE_LEN(n));
+  CHECK(cascade_check(frame, len));
+  CHECK_EQ(cascade_count(frame), n);
+  for (int k = 0; k < cascade_count(frame); k++) {
+    cascade_record_t r;
+    cascade_record(frame, k, &r);
+    CHECK(!r.scroll && r.slot < n);
+    CHECK(r.a == g_mx[0][r.slot] && r.b == g_my[0][r.slot]);
+  }
+}
+
+int main(void) {
+  srand(48);
+  for (int k = 0; k < FRAMES; k++)
+    for (int i = 0; i < SLOTS; i++) {
+      /* never zero, so every mouse has a cascade record */
+      int32_t x = 1 + rand() % 30, y = 1 + rand() % 30;
+      g_mx[k][i] = rand() % 2 ? x : -x;
+      g_my[k][i] = rand() % 2 ? y : -y;
+    }
+
+  static const int counts[] = { 2, 4, 6, 8, 12, 16 };
+  printf("mice   liveness  sum     average  max      fusion   cascade   (ns per frame; fusion ns per mouse)\n");
+  for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    int n = counts[c];
+    check_kernels(n);
+    check_fusion(n);
+    check_cascade(n);
+
+    liveness_reset();
+    for (int i = 0; i < n; i++)
+      liveness_mark(i, i % 3 != 0, 1000);
+
+    plan_t plans[3];
+    plan_for(&plans[0], n, SETTINGS_LOGIC_SUM);
+    plan_for(&plans[1], n, SETTINGS_LOGIC_AVERAGE);
+    plan_for(&plans[2], n, SETTINGS_LOGIC_MAX);
+    double ns[6];
+    int64_t sink = 0;
+
+    uint64_t t0 = bench_now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+      for (int k = 0; k < FRAMES; k++)
+        sink += liveness_mask(n, 1000u + (uint32_t)k, 500);
+    ns[0] = (double)(bench_now_ns() - t0) / (ROUNDS * FRAMES);
+
+    for (int m = 0; m < 3; m++) {
+      const plan_t *p = &plans[m];
+      t0 = bench_now_ns();
+      for (int r = 0; r < ROUNDS; r++)
+        for (int k = 0; k < FRAMES; k++) {
+          int32_t dx, dy;
+          p->logic(p, g_mx[k], g_my[k], (uint32_t)k, &dx, &dy);
+          sink += dx + dy;
+        }
+      ns[1 + m] = (double)(bench_now_ns() - t0) / (ROUNDS * FRAMES);
+    }
+
+    fusion_t f;
+    fusion_reset(&f);
+    t0 = bench_now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+      for (int k = 0; k < FRAMES; k++) {
+        int32_t dx, dy;
+        fusion_step(&f, g_mx[k], g_my[k], n, (1u << n) - 1, &dx, &dy);
+        sink += dx + dy;
+      }
+    ns[4] = (double)(bench_now_ns() - t0) / (ROUNDS * FRAMES);
+
+    cascade_tx_t t;
+    uint8_t frame[CASCADE_LEN_MAX];
+    cascade_tx_reset(&t);
+    t0 = bench_now_ns();
+    for (int r = 0; r < ROUNDS / 10; r++)
+      for (int k = 0; k < FRAMES; k++) {
+        for (int i = 0; i < n; i++)
+          cascade_tx_add(&t, i, 0, g_mx[k][i], g_my[k][i], 0, 0, (uint32_t)k, 0);
+        sink += cascade_tx_frame(&t, frame, (uint32_t)k);
+      }
+    ns[5] = (double)(bench_now_ns() - t0) / (ROUNDS / 10 * FRAMES);
+    bench_sink = sink;
+
+    printf("%4d   %7.2f  %6.2f  %7.2f  %6.2f  %7.2f  %7.2f   (%.2f)\n",
+           n, ns[0], ns[1], ns[2], ns[3], ns[4], ns[5], ns[4] / n);
+  }
+  return check_done("bench_slots");
+}
@@ -0,0 +1,9 @@
+/* config.h for the 16-slot host builds: the project's config with every slot compiled in. */
+#ifndef CFG16_CONFIG_H
+#define CFG16_CONFIG_H
+
+#include "../../config/config.h"
+#undef MAX_MICE
+#define MAX_MICE  16
+
+#endif
@@ -0,0 +1,36 @@
+/**
+ * Minimal checks for the host tests: CHECK() reports the failing line and keeps
+ * going, check_done() prints a summary and gives the exit status.
+ */
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+static int check_failed;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      check_failed++; \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+    } \
+  } while (0)
+
+/* CHECK(a == b) that prints both values (as long long). */
+#define CHECK_EQ(a, b) do { \
+    long long va_ = (long long)(a), vb_ = (long long)(b); \
+    if (va_ != vb_) { \
+      check_failed++; \
+      fprintf(stderr, "%s:%d: %s == %s failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, va_, vb_); \
+    } \
+  } while (0)
+
+static inline int check_done(const char *name) {
+  if (check_failed)
+    fprintf(stderr, "%s: %d check(s) failed\n", name, check_failed);
+  else
+    printf("%s: ok\n", name);
+  return check_failed ? 1 : 0;
+}
+
+#endif
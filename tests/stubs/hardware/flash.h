@@ -0,0 +1,21 @@
+/**
+ * Host stand-in for the Pico SDK's hardware/flash.h: the flash is a RAM array
+ * (host_flash.c), so settings.c builds and runs on a PC. Tests only.
+ */
+#ifndef HOST_HARDWARE_FLASH_H
+#define HOST_HARDWARE_FLASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PICO_FLASH_SIZE_BYTES     (2u * 1024u * 1024u)
+#define FLASH_PAGE_SIZE           256u
+#define FLASH_SECTOR_SIZE         4096u
+
+extern uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+#define XIP_NOCACHE_NOALLOC_BASE  ((uintptr_t)host_flash)
+
+void flash_range_erase(uint32_t offset, size_t count);
+void flash_range_program(uint32_t offset, const uint8_t *data, size_t count);
+
+#endif
@@ -0,0 +1,17 @@
+/**
+ * RAM flash behind the host hardware/flash.h. Erased flash reads 0xFF, and
+ * programming can only clear bits, as on the real part. Tests only.
+ */
+#include "hardware/flash.h"
+#include <string.h>
+
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+
+void flash_range_erase(uint32_t offset, size_t count) {
+  memset(host_flash + offset, 0xFF, count);
+}
+
+void flash_range_program(uint32_t offset, const uint8_t *data, size_t count) {
+  for (size_t k = 0; k < count; k++)
+    host_flash[offset + k] &= data[k];
+}
@@ -0,0 +1,402 @@
+/**
+ * cascade: the 0xAC frame encoder and checks. Motion past int16 carried over to the
+ * next frames with nothing lost, hops saturating at 255 and starting over once
+ * everything has gone, the age of the oldest input waiting (kept across carried
+ * frames, across the 32-bit clock wrap, clamped at CASCADE_AGE_MAX), a button release
+ * with no motion still sent, and cascade_check turning away a bad sync, count, length
+ * or checksum.
+ *
+ * Then a script of adds, frames and received frames (tests/cascade_frames.txt, passed
+ * on the command line) with the bytes each must produce, which scripts/cascade_sim.py
+ * replays too (--golden), so the simulator encodes what the firmware does:
+ *
+ *   add: slot buttons dx dy wheel pan origin_us hops
+ *   frame: now_us -> AC 02 01 ... | -              (nothing waiting)
+ *   rx: AC 01 ... -> ok | bad
+ *
+ * test_cascade --write FILE regenerates the script from this encoder.
+ */
+#include "cascade.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_LEN 1024   /* a full frame is 198 bytes, 594 characters */
+
+static int frame(cascade_tx_t *t, uint8_t *f, uint32_t now_us) {
+  int len = cascade_tx_frame(t, f, now_us);
+  if (len > 0)
+    CHECK(cascade_check(f, len));
+  return len;
+}
+
+/* 100000 counts in one add leave in four frames of at most one int16 each; wheel and
+ * pan the same, in their own records; the age stays with the first input. */
+static void check_carry(void) {
+  cascade_tx_t t;
+  cascade_tx_reset(&t);
+  cascade_tx_add(&t, 3, 0, 100000, -100000, 40000, -33000, 1000, 0);
+  uint8_t f[CASCADE_LEN_MAX];
+  int32_t sum[4] = { 0 };
+  int frames = 0;
+  while (frame(&t, f, 1500 + (uint32_t)frames * 2000) > 0) {
+    CHECK_EQ(cascade_age_us(f), 500 + frames * 2000);
+    for (int k = 0; k < cascade_count(f); k++) {
+      cascade_record_t r;
+      cascade_record(f, k, &r);
+      CHECK_EQ(r.slot, 3);
+      sum[r.scroll ? 2 : 0] += r.a;
+      sum[r.scroll ? 3 : 1] += r.b;
+    }
+    if (frames == 0) {
+      CHECK_EQ(cascade_count(f), 2);
+      cascade_record_t r;
+      cascade_record(f, 0, &r);
+      CHECK(!r.scroll);
+      CHECK_EQ(r.a, 32767);
+      CHECK_EQ(r.b, -32768);
+      cascade_record(f, 1, &r);
+      CHECK(r.scroll);
+      CHECK_EQ(r.a, 32767);
+      CHECK_EQ(r.b, -32768);
+    }
+    frames++;
+    CHECK(frames < 10);
+  }
+  CHECK_EQ(frames, 4);
+  CHECK_EQ(sum[0], 100000);
+  CHECK_EQ(sum[1], -100000);
+  CHECK_EQ(sum[2], 40000);
+  CHECK_EQ(sum[3], -33000);
+  CHECK(!t.waiting);
+
+  /* Counts added while the rest waits go out with it; nothing is dropped at the
+   * int32 accumulator either */
+  cascade_tx_reset(&t);
+  int64_t want = 0, got = 0;
+  for (int n = 0; n < 200; n++) {
+    cascade_tx_add(&t, 0, 0, 30000, 0, 0, 0, (uint32_t)n, 0);
+    want += 30000;
+    if (n % 3 == 0 && frame(&t, f, (uint32_t)n) > 0) {
+      cascade_record_t r;
+      cascade_record(f, 0, &r);
+      got += r.a;
+    }
+  }
+  while (frame(&t, f, 1000) > 0) {
+    cascade_record_t r;
+    cascade_record(f, 0, &r);
+    got += r.a;
+  }
+  CHECK_EQ(got, want);
+}
+
+/* Each link adds one hop, up to 255; a frame carries the most of any input in it,
+ * and the count starts over once everything waiting has gone. */
+static void check_hops(void) {
+  cascade_tx_t t;
+  uint8_t f[CASCADE_LEN_MAX];
+  static const uint8_t in[][2] = { { 0, 1 }, { 1, 2 }, { 7, 8 }, { 254, 255 }, { 255, 255 } };
+  for (size_t k = 0; k < sizeof(in) / sizeof(in[0]); k++) {
+    cascade_tx_reset(&t);
+    cascade_tx_add(&t, 1, 0, 1, 0, 0, 0, 0, in[k][0]);
+    CHECK(frame(&t, f, 0) > 0);
+    CHECK_EQ(cascade_hops(f), in[k][1]);
+  }
+  cascade_tx_reset(&t);
+  cascade_tx_add(&t, 1, 0, 1, 0, 0, 0, 0, 200);
+  cascade_tx_add(&t, 2, 0, 1, 0, 0, 0, 0, 3);
+  CHECK(frame(&t, f, 0) > 0);
+  CHECK_EQ(cascade_hops(f), 201);
+  cascade_tx_add(&t, 2, 0, 1, 0, 0, 0, 0, 3);
+  CHECK(frame(&t, f, 0) > 0);
+  CHECK_EQ(cascade_hops(f), 4);
+  /* an add that changes nothing doesn't raise it */
+  cascade_tx_add(&t, 2, 0, 0, 0, 0, 0, 0, 90);
+  cascade_tx_add(&t, 2, 0, 1, 0, 0, 0, 0, 0);
+  CHECK(frame(&t, f, 0) > 0);
+  CHECK_EQ(cascade_hops(f), 1);
+}
+
+/* The age is from the oldest input waiting, whichever slot and order it came in,
+ * across the clock wrap; clamped at CASCADE_AGE_MAX. */
+static void check_age(void) {
+  cascade_tx_t t;
+  uint8_t f[CASCADE_LEN_MAX];
+  cascade_tx_reset(&t);
+  CHECK_EQ(cascade_tx_frame(&t, f, 0), 0);
+  cascade_tx_add(&t, 0, 0, 1, 0, 0, 0, 5000, 0);
+  cascade_tx_add(&t, 4, 0, 0, 1, 0, 0, 3000, 0);   /* older, later */
+  cascade_tx_add(&t, 2, 0, 0, 0, 1, 0, 6000, 0);
+  cascade_tx_add(&t, 5, 0, 0, 0, 0, 0, 100, 0);    /* no change: no stamp */
+  CHECK(frame(&t, f, 7000) > 0);
+  CHECK_EQ(cascade_age_us(f), 4000);
+  CHECK_EQ(cascade_tx_frame(&t, f, 8000), 0);
+
+  /* origin just before the wrap, added after one just after it */
+  cascade_tx_add(&t, 0, 0, 1, 0, 0, 0, 100, 0);
+  cascade_tx_add(&t, 1, 0, 1, 0, 0, 0, 0xFFFFFF00u, 0);
+  CHECK(frame(&t, f, 400) > 0);
+  CHECK_EQ(cascade_age_us(f), 0x100 + 400);
+
+  cascade_tx_add(&t, 0, 0, 1, 0, 0, 0, 0, 0);
+  CHECK(frame(&t, f, CASCADE_AGE_MAX) > 0);
+  CHECK_EQ(cascade_age_us(f), CASCADE_AGE_MAX);
+  cascade_tx_add(&t, 0, 0, 1, 0, 0, 0, 0, 0);
+  CHECK(frame(&t, f, 5000000) > 0);
+  CHECK_EQ(cascade_age_us(f), CASCADE_AGE_MAX);
+
+  /* a new input behind carried counts doesn't make the frame younger */
+  cascade_tx_add(&t, 0, 0, 40000, 0, 0, 0, 10000, 0);
+  CHECK(frame(&t, f, 10500) > 0);
+  cascade_tx_add(&t, 1, 0, 1, 0, 0, 0, 11000, 0);
+  CHECK(frame(&t, f, 12000) > 0);
+  CHECK_EQ(cascade_age_us(f), 2000);
+  cascade_tx_add(&t, 1, 0, 1, 0, 0, 0, 13000, 0);
+  CHECK(frame(&t, f, 14000) > 0);
+  CHECK_EQ(cascade_age_us(f), 1000);
+}
+
+/* Press with motion, then release without: the release is a record of its own with no
+ * motion, and a repeat of the same level sends nothing. Buttons ride on the wheel record
+ * when a slot only scrolls. */
+static void check_buttons(void) {
+  cascade_tx_t t;
+  uint8_t f[CASCADE_LEN_MAX];
+  cascade_record_t r;
+  cascade_tx_reset(&t);
+  cascade_tx_add(&t, 6, 0x01, 5, -5, 0, 0, 0, 0);
+  CHECK(frame(&t, f, 0) > 0);
+  CHECK_EQ(cascade_count(f), 1);
+  cascade_record(f, 0, &r);
+  CHECK_EQ(r.buttons, 0x01);
+
+  cascade_tx_add(&t, 6, 0x01, 0, 0, 0, 0, 10, 0);
+  CHECK_EQ(cascade_tx_frame(&t, f, 20), 0);
+
+  cascade_tx_add(&t, 6, 0x00, 0, 0, 0, 0, 30, 0);
+  CHECK(frame(&t, f, 40) > 0);
+  CHECK_EQ(cascade_count(f), 1);
+  cascade_record(f, 0, &r);
+  CHECK_EQ(r.slot, 6);
+  CHECK(!r.scroll);
+  CHECK_EQ(r.buttons, 0x00);
+  CHECK_EQ(r.a, 0);
+  CHECK_EQ(r.b, 0);
+  CHECK_EQ(cascade_age_us(f), 10);
+  CHECK_EQ(cascade_tx_frame(&t, f, 50), 0);
+
+  cascade_tx_add(&t, 7, 0x04, 0, 0, 120, 0, 80, 0);
+  CHECK(frame(&t, f, 90) > 0);
+  CHECK_EQ(cascade_count(f), 2);
+  cascade_record(f, 0, &r);
+  CHECK(!r.scroll);
+  CHECK_EQ(r.buttons, 0x04);
+  cascade_record(f, 1, &r);
+  CHECK(r.scroll);
+  CHECK_EQ(r.a, 120);
+  cascade_tx_add(&t, 7, 0x04, 0, 0, 120, 0, 100, 0);
+  CHECK(frame(&t, f, 110) > 0);
+  CHECK_EQ(cascade_count(f), 1);
+  cascade_record(f, 0, &r);
+  CHECK(r.scroll);
+  CHECK_EQ(r.buttons, 0x04);
+}
+
+/* A frame of count all-zero records with a matching checksum; returns its length. */
+static int zero_frame(uint8_t *f, int count) {
+  int len = CASCADE_LEN(count);
+  memset(f, 0, (size_t)len);
+  f[0] = CASCADE_SYNC;
+  f[1] = (uint8_t)count;
+  f[len - 1] = (uint8_t)count;
+  return len;
+}
+
+/* A good frame passes; a bad sync, count past CASCADE_RECORDS_MAX, length other
+ * than CASCADE_LEN(count) or any one flipped bit after the sync does not. */
+static void check_rx(void) {
+  cascade_tx_t t;
+  uint8_t f[CASCADE_LEN_MAX + 8];
+  cascade_tx_reset(&t);
+  cascade_tx_add(&t, 0, 1, -3, 7, 0, 0, 0, 2);
+  cascade_tx_add(&t, 9, 0, 0, 0, 240, -120, 0, 0);
+  int len = frame(&t, f, 100);
+  CHECK_EQ(len, CASCADE_LEN(2));
+  CHECK(cascade_check(f, len));
+  CHECK(!cascade_check(f, len - 1));
+  CHECK(!cascade_check(f, len + 1));
+  CHECK(!cascade_check(f, 2));
+  CHECK(!cascade_check(f, 0));
+  f[0] = CASCADE_SYNC ^ 1;
+  CHECK(!cascade_check(f, len));
+  f[0] = CASCADE_SYNC;
+  for (int k = 1; k < len; k++)
+    for (int b = 0; b < 8; b++) {
+      f[k] ^= (uint8_t)(1u << b);
+      CHECK(!cascade_check(f, len));
+      f[k] ^= (uint8_t)(1u << b);
+    }
+  CHECK(cascade_check(f, len));
+
+  /* a count past the most records a frame can hold, checksum fixed up to match */
+  uint8_t big[CASCADE_LEN(CASCADE_RECORDS_MAX + 1)];
+  CHECK(!cascade_check(big, zero_frame(big, CASCADE_RECORDS_MAX + 1)));
+  CHECK(cascade_check(big, zero_frame(big, CASCADE_RECORDS_MAX)));
+  /* the smallest frame: no records */
+  static const uint8_t empty[] = { CASCADE_SYNC, 0, 1, 0x10, 0, 0x11 };
+  CHECK(cascade_check(empty, (int)sizeof(empty)));
+}
+
+/* Golden script */
+
+static uint32_t rng_state = 49;
+
+static uint32_t rng(uint32_t n) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state % n;
+}
+
+static void put_hex(FILE *out, const uint8_t *f, int len) {
+  for (int k = 0; k < len; k++)
+    fprintf(out, "%s%02X", k ? " " : "", f[k]);
+}
+
+static void write_rx(FILE *out, const uint8_t *f, int len) {
+  fprintf(out, "rx: ");
+  put_hex(out, f, len);
+  fprintf(out, " -> %s\n", cascade_check(f, len) ? "ok" : "bad");
+}
+
+/* Adds on every slot (and two past them), motion from a count to past int16, button
+ * changes, wheel and pan, ages up to past CASCADE_AGE_MAX and hops up to 255, with a
+ * frame every few adds; each frame also goes back in as received, as it is and broken. */
+static void write_script(FILE *out) {
+  cascade_tx_t t;
+  cascade_tx_reset(&t);
+  uint8_t buttons[CASCADE_SLOTS + 2] = { 0 };
+  uint32_t now = 100000;
+  fprintf(out, "# Generated by test_cascade --write; checked by test_cascade and cascade_sim.py --golden\n");
+  for (int n = 0; n < 160; n++) {
+    int adds = (int)rng(5);
+    for (int k = 0; k < adds; k++) {
+      int slot = (int)rng(CASCADE_SLOTS + 2);
+      static const int32_t mag[] = { 0, 1, 4, 127, 2000, 40000, 100000 };
+      int32_t v[4];
+      for (int a = 0; a < 4; a++) {
+        int32_t m = mag[rng(7)];
+        v[a] = a >= 2 && rng(3) ? 0 : (int32_t)rng((uint32_t)(2 * m + 1)) - m;
+      }
+      if (rng(4) == 0)
+        buttons[slot] = (uint8_t)rng(32);
+      uint32_t origin = now - rng(rng(8) ? 3000 : 90000);
+      uint8_t hops = (uint8_t)(rng(10) ? rng(4) : 250 + rng(6));
+      cascade_tx_add(&t, slot, buttons[slot], v[0], v[1], v[2], v[3], origin, hops);
+      fprintf(out, "add: %d %u %ld %ld %ld %ld %lu %u\n", slot, buttons[slot], (long)v[0], (long)v[1],
+              (long)v[2], (long)v[3], (unsigned long)origin, hops);
+    }
+    now += rng(4000);
+    uint8_t f[CASCADE_LEN_MAX + 1];
+    int len = cascade_tx_frame(&t, f, now);
+    fprintf(out, "frame: %lu -> ", (unsigned long)now);
+    if (len == 0) {
+      fprintf(out, "-\n");
+      continue;
+    }
+    put_hex(out, f, len);
+    fprintf(out, "\n");
+    write_rx(out, f, len);
+    switch (rng(4)) {
+      case 0: f[0] ^= 0x01; write_rx(out, f, len); break;
+      case 1: write_rx(out, f, len - 1); break;
+      case 2: f[len] = 0; write_rx(out, f, len + 1); break;
+      default: f[1 + rng((uint32_t)len - 1)] ^= (uint8_t)(1u << rng(8)); write_rx(out, f, len); break;
+    }
+  }
+  uint8_t f[CASCADE_LEN(CASCADE_RECORDS_MAX + 1)];
+  write_rx(out, f, zero_frame(f, 0));
+  write_rx(out, f, zero_frame(f, CASCADE_RECORDS_MAX));
+  write_rx(out, f, zero_frame(f, CASCADE_RECORDS_MAX + 1));
+}
+
+/* Hex bytes in s up to "->" or the end; returns the count. */
+static int parse_hex(const char *s, uint8_t *buf, int cap) {
+  int n = 0;
+  while (*s && !(s[0] == '-' && s[1] == '>')) {
+    char *end;
+    unsigned long v = strtoul(s, &end, 16);
+    if (end == s) {
+      s++;
+      continue;
+    }
+    if (n < cap) buf[n++] = (uint8_t)v;
+    s = end;
+  }
+  return n;
+}
+
+static void check_script(const char *path) {
+  FILE *in = fopen(path, "r");
+  CHECK(in != NULL);
+  if (!in) return;
+  cascade_tx_t t;
+  cascade_tx_reset(&t);
+  char line[LINE_LEN];
+  int lineno = 0, frames = 0, rx = 0;
+  while (fgets(line, sizeof(line), in)) {
+    lineno++;
+    const char *arrow = strstr(line, "->");
+    if (strncmp(line, "add: ", 5) == 0) {
+      int slot;
+      unsigned buttons, hops;
+      long v[4];
+      unsigned long origin;
+      CHECK(sscanf(line + 5, "%d %u %ld %ld %ld %ld %lu %u", &slot, &buttons, &v[0], &v[1], &v[2], &v[3],
+                   &origin, &hops) == 8);
+      cascade_tx_add(&t, slot, (uint8_t)buttons, (int32_t)v[0], (int32_t)v[1], (int32_t)v[2], (int32_t)v[3],
+                     (uint32_t)origin, (uint8_t)hops);
+    } else if (strncmp(line, "frame: ", 7) == 0 && arrow) {
+      uint8_t want[CASCADE_LEN_MAX], got[CASCADE_LEN_MAX];
+      const char *bytes = arrow + 2 + strspn(arrow + 2, " ");
+      int want_len = *bytes == '-' ? 0 : parse_hex(bytes, want, (int)sizeof(want));
+      int len = cascade_tx_frame(&t, got, (uint32_t)strtoul(line + 7, NULL, 10));
+      if (len != want_len || memcmp(got, want, (size_t)len) != 0) {
+        fprintf(stderr, "%s:%d: frame differs\n", path, lineno);
+        check_failed++;
+      }
+      frames++;
+    } else if (strncmp(line, "rx: ", 4) == 0 && arrow) {
+      uint8_t f[CASCADE_LEN_MAX + 1];
+      int len = parse_hex(line + 4, f, (int)sizeof(f));
+      bool ok = strstr(arrow, "ok") != NULL;
+      if (cascade_check(f, len) != ok) {
+        fprintf(stderr, "%s:%d: cascade_check should say %s\n", path, lineno, ok ? "ok" : "bad");
+        check_failed++;
+      }
+      rx++;
+    }
+  }
+  fclose(in);
+  CHECK(frames > 100);
+  CHECK(rx > 100);
+}
+
+int main(int argc, char **argv) {
+  if (argc == 3 && strcmp(argv[1], "--write") == 0) {
+    FILE *out = fopen(argv[2], "w");
+    if (!out) return 1;
+    write_script(out);
+    return fclose(out) != 0;
+  }
+  check_carry();
+  check_hops();
+  check_age();
+  check_buttons();
+  check_rx();
+  CHECK(argc > 1);   /* the script comes from CMake */
+  for (int i = 1; i < argc; i++)
+    check_script(argv[i]);
+  return check_done("test_cascade");
+}
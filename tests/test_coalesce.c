@@ -0,0 +1,237 @@
+/**
+ * coalesce: an endpoint that stays busy for random stretches of frames while motion
+ * keeps arriving. Every count added must come out in the reports, each report must
+ * carry as much of the pending motion as its int8 X/Y and int16 wheel/pan allow, and
+ * nothing is sent when nothing is pending. Then the per-axis saturation of what is
+ * queued.
+ *
+ * Buttons: clicks shorter than a frame, several per frame, on the same busy endpoint
+ * and mixed with motion. Every press and release must be reported, in order, one per
+ * report, each state held for the minimum hold time; and when the queue overflows
+ * during a long stall, the last state still comes out.
+ */
+#include "coalesce.h"
+#include "check.h"
+#include <stdlib.h>
+
+#define FRAMES  200000
+
+static int32_t clamp(int32_t v, int32_t lo, int32_t hi) {
+  return v < lo ? lo : v > hi ? hi : v;
+}
+
+static int rnd(int lo, int hi) {
+  return lo + rand() % (hi - lo + 1);
+}
+
+/* Model of what is queued, to hold every report against */
+typedef struct {
+  long long dx, dy, wheel, pan;
+} totals_t;
+
+static void check_busy_endpoint(void) {
+  coalesce_t c;
+  coalesce_reset(&c);
+  totals_t in = { 0 }, out = { 0 }, q = { 0 };
+  long long reports = 0, busy_frames = 0, split = 0;
+  int stall = 0;
+  srand(1);
+  for (uint32_t now = 0; now < FRAMES; now++) {
+    /* 0..8 sensor reads per frame, now and then a flick far past one report */
+    for (int k = rnd(0, 8); k > 0; k--) {
+      int32_t dx = rnd(-300, 300), dy = rnd(-300, 300), wh = rnd(-3, 3) * 120, pan = rnd(-1, 1);
+      if (rand() % 5000 == 0) dx = rnd(-4000, 4000);
+      coalesce_add(&c, dx, dy, wh, pan);
+      in.dx += dx; in.dy += dy; in.wheel += wh; in.pan += pan;
+      q.dx += dx; q.dy += dy; q.wheel += wh; q.pan += pan;
+    }
+    CHECK(llabs(q.dx) < COALESCE_MAX && llabs(q.dy) < COALESCE_MAX);   /* stays clear of saturation */
+
+    /* Busy half the time, with occasional stalls of up to 200 frames */
+    if (stall > 0) {
+      stall--;
+    } else if (rand() % 500 == 0) {
+      stall = rnd(20, 200);
+    }
+    bool ready = stall == 0 && rand() % 2 == 0;
+    bool pending = q.dx || q.dy || q.wheel || q.pan;
+    CHECK_EQ(coalesce_pending(&c, now, 0), pending);
+    if (!ready) {
+      busy_frames++;
+      continue;
+    }
+    coalesce_report_t r;
+    bool sent = coalesce_take(&c, &r, now, 0);
+    CHECK_EQ(sent, pending);
+    if (!sent) continue;
+    reports++;
+    /* As much as fits: X/Y int8, wheel/pan ±32767 as the descriptor declares */
+    CHECK_EQ(r.dx, clamp((int32_t)q.dx, -128, 127));
+    CHECK_EQ(r.dy, clamp((int32_t)q.dy, -128, 127));
+    CHECK_EQ(r.wheel, clamp((int32_t)q.wheel, -32767, 32766));
+    CHECK_EQ(r.pan, clamp((int32_t)q.pan, -32767, 32766));
+    if (r.dx != q.dx || r.dy != q.dy) split++;
+    q.dx -= r.dx; q.dy -= r.dy; q.wheel -= r.wheel; q.pan -= r.pan;
+    out.dx += r.dx; out.dy += r.dy; out.wheel += r.wheel; out.pan += r.pan;
+  }
+
+  /* Endpoint free again: the rest drains */
+  coalesce_report_t r;
+  for (uint32_t now = FRAMES; now < FRAMES + 1000 && coalesce_take(&c, &r, now, 0); now++) {
+    out.dx += r.dx; out.dy += r.dy; out.wheel += r.wheel; out.pan += r.pan;
+    reports++;
+  }
+  CHECK(!coalesce_pending(&c, FRAMES + 1000, 0));
+  printf("%d frames, %lld busy, %lld reports, %lld with motion left for the next\n", FRAMES, busy_frames,
+         reports, split);
+  CHECK_EQ(out.dx, in.dx);
+  CHECK_EQ(out.dy, in.dy);
+  CHECK_EQ(out.wheel, in.wheel);
+  CHECK_EQ(out.pan, in.pan);
+  CHECK(split > 0);   /* the int8 split was exercised */
+}
+
+/* More than COALESCE_MAX queued on one axis keeps COALESCE_MAX (the rest is lost, not
+ * wrapped), and drains in full-size reports. */
+static void check_saturation(void) {
+  coalesce_t c;
+  coalesce_report_t r;
+  coalesce_reset(&c);
+  coalesce_add(&c, 100000, -100000, 0, 0);
+  coalesce_add(&c, 1, -1, 0, 0);
+  long long sx = 0, sy = 0, n = 0;
+  while (n < 1000 && coalesce_take(&c, &r, 0, 0)) {
+    sx += r.dx;
+    sy += r.dy;
+    n++;
+  }
+  CHECK_EQ(sx, COALESCE_MAX);
+  CHECK_EQ(sy, -COALESCE_MAX - 1);
+  CHECK_EQ(n, (COALESCE_MAX + 126) / 127);   /* X limits: 32767 / 127 rounded up */
+
+  coalesce_reset(&c);
+  coalesce_add(&c, 0, 0, 40000, -40000);
+  CHECK(coalesce_take(&c, &r, 0, 0));
+  CHECK_EQ(r.wheel, 32766);
+  CHECK_EQ(r.pan, -32767);
+  CHECK(coalesce_take(&c, &r, 0, 0));
+  CHECK_EQ(r.wheel, 1);
+  CHECK_EQ(r.pan, -1);
+  CHECK(!coalesce_take(&c, &r, 0, 0));
+}
+
+/* Bursts of 1-3 clicks with 100-900 us between edges (so several edges land in one
+ * 1 ms frame), separated by gaps long enough that the queue can't overflow. The
+ * reported states are held against the edges as they went in. */
+static void check_click_bursts(uint8_t hold) {
+  coalesce_t c;
+  coalesce_reset(&c);
+  uint8_t want[4096];   /* states queued, not yet seen reported */
+  int head = 0, tail = 0;
+  uint8_t level = 0, shown = 0;
+  uint32_t changed_ms = 0;
+  long long edges = 0, changes = 0, same_frame = 0, motion_only = 0;
+  uint32_t next_edge_us = 1000;
+  int burst_left = 2;   /* edges left in this burst */
+  srand(2);
+  for (uint32_t now = 0; now < FRAMES / 4; now++) {
+    int in_frame = 0;
+    while (next_edge_us < (now + 1) * 1000) {
+      /* A click is a press of one button and its release */
+      level = level ? 0 : (uint8_t)(1u << rnd(0, 4));
+      coalesce_buttons(&c, level);
+      want[tail++ % 4096] = level;
+      edges++;
+      if (++in_frame > 1) same_frame++;
+      if (--burst_left > 0) {
+        next_edge_us += (uint32_t)rnd(100, 900);
+      } else {
+        /* Between bursts, time for the queue to drain with the endpoint busy */
+        next_edge_us += 1000u * (uint32_t)(2 * COALESCE_BUTTON_QUEUE * (hold + 2) + rnd(0, 50));
+        burst_left = rnd(1, 3) * 2;
+      }
+    }
+    if (rand() % 3 == 0)
+      coalesce_add(&c, rnd(-5, 5), rnd(-5, 5), 0, 0);
+
+    CHECK(tail - head <= COALESCE_BUTTON_QUEUE);   /* this test stays clear of overflow */
+    bool due = head < tail && now - changed_ms >= hold;
+    if (due) CHECK(coalesce_pending(&c, now, hold));
+    if (rand() % 10 < 3) continue;   /* busy */
+    coalesce_report_t r;
+    if (!coalesce_take(&c, &r, now, hold)) {
+      CHECK(!due);
+      continue;
+    }
+    if (r.buttons == shown) {
+      CHECK(!due);   /* a due change goes out in the first report that can carry it */
+      motion_only++;
+      continue;
+    }
+    /* A change: the oldest one queued, after the hold */
+    CHECK(head < tail);
+    CHECK_EQ(r.buttons, want[head % 4096]);
+    if (changes > 0) CHECK(now - changed_ms >= hold);
+    head++;
+    shown = r.buttons;
+    changed_ms = now;
+    changes++;
+  }
+  coalesce_report_t r;
+  for (uint32_t now = FRAMES / 4; now < FRAMES / 4 + 1000 && coalesce_take(&c, &r, now, hold); now++) {
+    if (r.buttons != shown) {
+      CHECK(head < tail && r.buttons == want[head % 4096]);
+      CHECK(now - changed_ms >= hold);
+      head++;
+      shown = r.buttons;
+      changed_ms = now;
+      changes++;
+    }
+  }
+  printf("hold %u ms: %lld edges (%lld in a frame already holding one), %lld reported, %lld motion-only reports\n",
+         hold, edges, same_frame, changes, motion_only);
+  CHECK_EQ(changes, edges);
+  CHECK_EQ(head, tail);
+  CHECK_EQ(shown, 0);
+  CHECK(same_frame > 0);
+}
+
+/* A stall long enough to overflow the queue: pairs that undo each other are dropped
+ * first, and whatever happens the last state is the one left reported. */
+static void check_overflow(void) {
+  coalesce_t c;
+  coalesce_report_t r;
+  static const struct { uint8_t first, second; int n; } cases[] = {
+    { 1, 0, 20 },   /* button 1 pressed and released 10 times */
+    { 1, 0, 21 },   /* ... and pressed again */
+    { 1, 3, 20 },   /* button 2 chattering under button 1: never back to 0 */
+  };
+  for (unsigned k = 0; k < sizeof(cases) / sizeof(cases[0]); k++) {
+    coalesce_reset(&c);
+    uint8_t last = 0;
+    for (int i = 0; i < cases[k].n; i++) {
+      last = i % 2 ? cases[k].second : cases[k].first;
+      coalesce_buttons(&c, last);
+    }
+    CHECK(c.queued <= COALESCE_BUTTON_QUEUE);
+    uint8_t shown = 0;
+    int changes = 0;
+    for (uint32_t now = 0; now < 100 && coalesce_take(&c, &r, now, 0); now++) {
+      CHECK(r.buttons != shown);   /* each report one change: the queue never repeats a state */
+      shown = r.buttons;
+      changes++;
+    }
+    CHECK_EQ(shown, last);
+    CHECK(changes <= COALESCE_BUTTON_QUEUE);
+  }
+}
+
+int main(void) {
+  check_busy_endpoint();
+  check_saturation();
+  check_click_bursts(0);
+  check_click_bursts(4);
+  check_click_bursts(16);
+  check_overflow();
+  return check_done("test_coalesce");
+}
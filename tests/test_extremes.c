@@ -0,0 +1,197 @@
+/**
+ * Fixed-point stages at the ends of their ranges, each against an int64 reference:
+ * plan_xform with every matrix entry up to ±SETTINGS_XFORM_MAX on deltas of ±32767
+ * (and -32768, which it clamps), remainders carried; plan_abs_units from the lowest
+ * to the highest gain on deltas up to the int32 limits; accel_apply with the largest
+ * gain a table can hold; fusion_step with sixteen inputs at the int16 limits. And
+ * settings.c pulling a -32768 matrix entry in to -SETTINGS_XFORM_MAX. Configure with
+ * -DSANITIZE=ON to have any signed overflow or shift of a negative value stop the test.
+ */
+#include "plan.h"
+#include "accel.h"
+#include "fusion.h"
+#include "settings.h"
+#include "check.h"
+#include <string.h>
+
+/* floor(v / 256) */
+static int64_t floor_q8(int64_t v) {
+  return v >= 0 ? v / 256 : -((-v + 255) / 256);
+}
+
+static int64_t clamp64(int64_t v, int64_t lim) {
+  return v > lim ? lim : v < -lim ? -lim : v;
+}
+
+static const int16_t entries[] = {
+  -SETTINGS_XFORM_MAX, -32766, -256, -255, -1, 0, 1, 255, 256, 32766, SETTINGS_XFORM_MAX,
+};
+#define ENTRIES  (int)(sizeof(entries) / sizeof(entries[0]))
+
+static const int32_t deltas[] = { -32768, -32767, -300, -1, 0, 1, 300, 32767 };
+#define DELTAS  (int)(sizeof(deltas) / sizeof(deltas[0]))
+
+/* Every matrix of the entries above on every pair of deltas, three frames each so
+ * the remainder is carried at its extremes too. */
+static void check_xform(void) {
+  int bad = 0;
+  for (int k = 0; k < ENTRIES * ENTRIES * ENTRIES * ENTRIES; k++) {
+    int16_t m[4] = { entries[k % ENTRIES], entries[k / ENTRIES % ENTRIES],
+                     entries[k / (ENTRIES * ENTRIES) % ENTRIES], entries[k / (ENTRIES * ENTRIES * ENTRIES)] };
+    for (int a = 0; a < DELTAS; a++)
+      for (int b = 0; b < DELTAS; b++) {
+        int32_t res[2] = { 0, 0 };
+        int64_t want_res[2] = { 0, 0 };
+        for (int frame = 0; frame < 3; frame++) {
+          int32_t dx = deltas[a], dy = deltas[b];
+          int64_t x = clamp64(dx, PLAN_XFORM_IN_MAX), y = clamp64(dy, PLAN_XFORM_IN_MAX);
+          int64_t ox = m[0] * x + m[1] * y + want_res[0], oy = m[2] * x + m[3] * y + want_res[1];
+          int64_t wx = floor_q8(ox), wy = floor_q8(oy);
+          want_res[0] = ox - wx * 256;
+          want_res[1] = oy - wy * 256;
+          plan_xform(m, res, &dx, &dy);
+          if (dx != clamp64(wx, PLAN_XFORM_IN_MAX) || dy != clamp64(wy, PLAN_XFORM_IN_MAX) ||
+              res[0] != want_res[0] || res[1] != want_res[1])
+            bad++;
+        }
+      }
+  }
+  CHECK_EQ(bad, 0);
+
+  /* A 128x matrix holds ±32767 whatever the input, and the identity is exact */
+  int16_t big[4] = { SETTINGS_XFORM_MAX, SETTINGS_XFORM_MAX, -SETTINGS_XFORM_MAX, -SETTINGS_XFORM_MAX };
+  int32_t res[2] = { 0, 0 }, dx = -32767, dy = -32767;
+  plan_xform(big, res, &dx, &dy);
+  CHECK_EQ(dx, -PLAN_XFORM_IN_MAX);
+  CHECK_EQ(dy, PLAN_XFORM_IN_MAX);
+  int16_t one[4] = { SETTINGS_XFORM_ONE, 0, 0, SETTINGS_XFORM_ONE };
+  for (int a = 1; a < DELTAS; a++) {
+    dx = deltas[a];
+    dy = -deltas[a];
+    plan_xform(one, res, &dx, &dy);
+    CHECK_EQ(dx, deltas[a]);
+    CHECK_EQ(dy, -deltas[a]);
+  }
+}
+
+/* Lowest gain (amplify 0.1), 1:1, highest (amplify 10), on deltas from a count to
+ * past the int32 limits, carried over several frames. */
+static void check_abs(void) {
+  static const int32_t gains[] = { 205, 256 * PLAN_ABS_UNITS_PER_COUNT, 10 * 256 * PLAN_ABS_UNITS_PER_COUNT };
+  static const int32_t d[] = { INT32_MIN, -(1 << 20), -PLAN_ABS_IN_MAX - 1, -PLAN_ABS_IN_MAX, -32768, -3, -1,
+                               0, 1, 3, 32767, PLAN_ABS_IN_MAX, PLAN_ABS_IN_MAX + 1, 1 << 20, INT32_MAX };
+  int bad = 0;
+  for (size_t g = 0; g < sizeof(gains) / sizeof(gains[0]); g++)
+    for (size_t k = 0; k < sizeof(d) / sizeof(d[0]); k++) {
+      int32_t res = 0;
+      int64_t want_res = 0;
+      for (int frame = 0; frame < 4; frame++) {
+        int64_t v = clamp64(d[k], PLAN_ABS_IN_MAX) * gains[g] + want_res;
+        int64_t want = floor_q8(v);
+        want_res = v - want * 256;
+        if (plan_abs_units(d[k], gains[g], &res) != want || res != want_res)
+          bad++;
+      }
+    }
+  CHECK_EQ(bad, 0);
+  /* the clamp still crosses the whole contact range at the lowest gain */
+  int32_t res = 0;
+  CHECK(plan_abs_units(PLAN_ABS_IN_MAX, gains[0], &res) > 32767);
+}
+
+/* Every gain entry at 65535 (255x, more than any curve builds): deltas clamped to
+ * ACCEL_IN_MAX, the product and remainder exact over many reports. */
+static void check_accel(void) {
+  settings_t s;
+  memset(&s, 0, sizeof(s));
+  s.accel_mode = SETTINGS_ACCEL_LINEAR;
+  s.accel_rate = 10000;
+  s.accel_max_x100 = 1000;
+  s.accel_window_ms = SETTINGS_ACCEL_WINDOW_MAX;
+  accel_t a;
+  accel_build(&a, &s, 1);
+  CHECK_EQ(a.gain_q8[ACCEL_LUT_SIZE - 1], 2560);
+  static const int32_t d[] = { INT32_MIN, -(1 << 19), -32768, -32767, -5, 5, 32767, 32768, 1 << 19, INT32_MAX };
+  const size_t nd = sizeof(d) / sizeof(d[0]);
+  int bad = 0;
+  for (int table = 0; table < 2; table++) {
+    if (table == 1)
+      for (int v = 0; v < ACCEL_LUT_SIZE; v++) a.gain_q8[v] = 65535;
+    for (size_t k = 0; k < nd; k++) {
+      int64_t want_res[2] = { a.res[0], a.res[1] };
+      for (int frame = 0; frame < 100; frame++) {
+        int32_t dx = d[k], dy = d[(k + 3) % nd];
+        int64_t in[2] = { clamp64(dx, ACCEL_IN_MAX), clamp64(dy, ACCEL_IN_MAX) }, want[2];
+        accel_apply(&a, &dx, &dy, (uint32_t)frame);
+        int64_t g = a.gain_q8[ACCEL_LUT_SIZE - 1];   /* speed is saturated from the first report */
+        for (int ax = 0; ax < 2; ax++) {
+          int64_t v = in[ax] * g + want_res[ax];
+          want[ax] = floor_q8(v);
+          want_res[ax] = v - want[ax] * 256;
+        }
+        if (dx != want[0] || dy != want[1] || a.res[0] != want_res[0] || a.res[1] != want_res[1])
+          bad++;
+      }
+    }
+  }
+  CHECK_EQ(bad, 0);
+}
+
+/* Sixteen inputs, all at +32767, all at -32768, and at opposite limits, then still:
+ * the fused output stays in range, and once the filter settles it has delivered what
+ * the inputs agreed on. */
+static void check_fusion(void) {
+  static const int32_t levels[][2] = { { 32767, 32767 }, { -32768, -32768 }, { 32767, -32768 } };
+  for (int l = 0; l < 3; l++) {
+    fusion_t f;
+    fusion_reset(&f);
+    int32_t dx[FUSION_MAX_INPUTS], dy[FUSION_MAX_INPUTS];
+    int64_t sum_x = 0, sum_y = 0, want_x = 0, want_y = 0;
+    for (int frame = 0; frame < 3000; frame++) {
+      bool moving = frame < 1000;
+      for (int i = 0; i < FUSION_MAX_INPUTS; i++) {
+        dx[i] = moving ? levels[l][i % 2] : 0;
+        dy[i] = moving ? -levels[l][(i + 1) % 2] : 0;
+      }
+      if (moving) {
+        int64_t mx = 0, my = 0;
+        for (int i = 0; i < FUSION_MAX_INPUTS; i++) {
+          mx += dx[i];
+          my += dy[i];
+        }
+        want_x += mx / FUSION_MAX_INPUTS;
+        want_y += my / FUSION_MAX_INPUTS;
+      }
+      int32_t ox, oy;
+      fusion_step(&f, dx, dy, FUSION_MAX_INPUTS, 0xFFFF, &ox, &oy);
+      CHECK(ox >= -65536 && ox <= 65536);
+      CHECK(oy >= -65536 && oy <= 65536);
+      sum_x += ox;
+      sum_y += oy;
+    }
+    CHECK(sum_x - want_x >= -FUSION_MAX_INPUTS && sum_x - want_x <= FUSION_MAX_INPUTS);
+    CHECK(sum_y - want_y >= -FUSION_MAX_INPUTS && sum_y - want_y <= FUSION_MAX_INPUTS);
+  }
+}
+
+/* settings.c keeps matrix entries within ±SETTINGS_XFORM_MAX */
+static void check_settings(void) {
+  settings_init();
+  settings_set_xform(0, -32768, 32767, -32768, -32767);
+  settings_t s;
+  settings_acquire(&s);
+  CHECK_EQ(s.xform[0][0], -SETTINGS_XFORM_MAX);
+  CHECK_EQ(s.xform[0][1], SETTINGS_XFORM_MAX);
+  CHECK_EQ(s.xform[0][2], -SETTINGS_XFORM_MAX);
+  CHECK_EQ(s.xform[0][3], -SETTINGS_XFORM_MAX);
+  CHECK(s.xform_mask & 1u);
+}
+
+int main(void) {
+  check_xform();
+  check_abs();
+  check_accel();
+  check_fusion();
+  check_settings();
+  return check_done("test_extremes");
+}
@@ -0,0 +1,78 @@
+/**
+ * fastdiv: exhaustive check that the reciprocal quotient (and the remainder
+ * quadrature_poll derives from it) equals C division for every divisor 1..65535
+ * and every dividend in [-FASTDIV_N_MAX, FASTDIV_N_MAX], plus the '/' fallback
+ * past that range. The reference quotient is stepped along with n rather than
+ * divided, which keeps the 4.3e9 cases to a few seconds.
+ */
+#include "fastdiv.h"
+#include "check.h"
+#include <stdint.h>
+
+/* Stop reporting after this many mismatches; the count still goes on. */
+#define REPORT_MAX  10
+
+static long long mismatches;
+
+static void mismatch(uint32_t d, int32_t n, int32_t got, int32_t want) {
+  if (mismatches++ < REPORT_MAX)
+    fprintf(stderr, "d %u n %d: got %d, want %d\n", d, n, got, want);
+}
+
+/* Every n in [-FASTDIV_N_MAX, FASTDIV_N_MAX] for divisor d. */
+static void check_divisor(uint16_t d) {
+  fastdiv_t f;
+  fastdiv_init(&f, d);
+  int32_t q = 0, r = 0;   /* n / d and n % d for n >= 0, stepped */
+  for (int32_t n = 0; n <= (int32_t)FASTDIV_N_MAX; n++) {
+    int32_t p = fastdiv_s32(&f, n), m = fastdiv_s32(&f, -n);
+    if (p != q) mismatch(d, n, p, q);
+    if (m != -q) mismatch(d, -n, m, -q);
+    if (n - p * d != r) mismatch(d, n, n - p * d, r);   /* remainder as quadrature_poll takes it */
+    if (++r == d) {
+      r = 0;
+      q++;
+    }
+  }
+}
+
+/* Dividends past FASTDIV_N_MAX take the '/' path: spot-check it around the edge and
+ * at the int32 extremes. */
+static void check_fallback(uint16_t d) {
+  fastdiv_t f;
+  fastdiv_init(&f, d);
+  static const int32_t n[] = {
+    (int32_t)FASTDIV_N_MAX + 1, (int32_t)FASTDIV_N_MAX + 2, 65535, 65536, 1 << 20,
+    (1 << 21) * 100, INT32_MAX, INT32_MIN + 1, INT32_MIN,
+  };
+  for (unsigned k = 0; k < sizeof(n) / sizeof(n[0]); k++) {
+    int32_t got = fastdiv_s32(&f, n[k]);
+    if (got != n[k] / d) mismatch(d, n[k], got, n[k] / d);
+    if (n[k] != INT32_MIN && fastdiv_s32(&f, -n[k]) != -n[k] / d)
+      mismatch(d, -n[k], fastdiv_s32(&f, -n[k]), -n[k] / d);
+  }
+}
+
+int main(void) {
+  for (uint32_t d = 1; d <= 0xFFFF; d++) {
+    check_divisor((uint16_t)d);
+    check_fallback((uint16_t)d);
+  }
+
+  /* Every multiplier keeps n * mul inside 32 bits (the whole point on the M0+) */
+  for (uint32_t d = 1; d <= 0xFFFF; d++) {
+    fastdiv_t f;
+    fastdiv_init(&f, (uint16_t)d);
+    CHECK((uint64_t)FASTDIV_N_MAX * f.mul <= UINT32_MAX);
+    CHECK_EQ(f.div, d);
+  }
+
+  /* d = 0 is treated as 1 rather than dividing by zero */
+  fastdiv_t z;
+  fastdiv_init(&z, 0);
+  CHECK_EQ(fastdiv_s32(&z, 1234), 1234);
+  CHECK_EQ(fastdiv_s32(&z, -40000), -40000);
+
+  CHECK_EQ(mismatches, 0);
+  return check_done("test_fastdiv");
+}
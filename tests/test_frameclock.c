@@ -0,0 +1,236 @@
+/**
+ * frameclock: the report frame clock against a simulated host. The host sends a SOF
+ * every millisecond of its own crystal, off from the Pico's by a set ppm; the main
+ * loop sees each one at its next pass (passes of 5-40 us, now and then a 400 us one)
+ * and runs frames the way main.c does, spinning when one is FRAME_SPIN_US away. The
+ * clock must lock after one window of SOFs, hold every frame within a few tens of us
+ * of lead_us before a polled SOF at ±100 ppm, keep counting across the 11-bit frame
+ * number wrap, free-run once SOFs stop, skip rather than bunch frames after a stall,
+ * and move its frames to the SOFs the host polls in.
+ */
+#include "frameclock.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TICK_US  2000   /* HID_POLL_MS */
+#define LEAD_US  250
+#define SPIN_US  30
+
+typedef struct {
+  double ppm;           /* host SOF period against the Pico's microsecond */
+  double t0;            /* Pico time of SOF 0 */
+  uint32_t fn0;         /* 11-bit number of SOF 0 */
+  uint32_t now;         /* Pico time of the current main loop pass */
+  uint32_t seen;        /* SOFs the loop has seen */
+  bool sofs;            /* host sending SOFs */
+} host_t;
+
+static double sof_at(const host_t *h, uint32_t k) {
+  return h->t0 + (double)k * 1000.0 * (1.0 + h->ppm / 1e6);
+}
+
+static uint32_t loop_pass_us(void) {
+  return rand() % 200 == 0 ? 400u : 5u + (uint32_t)(rand() % 36);
+}
+
+/* One main loop pass: tud_task sees the SOFs since the last one, then the frame clock.
+ * Returns true if a frame ran; *sof is the SOF it ran ahead of (locked clock). */
+static bool pass(host_t *h, frameclock_t *c, uint32_t *late, uint32_t *sof) {
+  h->now += loop_pass_us();
+  while (h->sofs && sof_at(h, h->seen) <= (double)h->now) {
+    frameclock_sof(c, h->fn0 + h->seen, h->now);
+    h->seen++;
+  }
+  uint32_t wait = frameclock_wait_us(c, h->now);
+  if (wait > 0 && wait <= SPIN_US)
+    h->now += wait;
+  *sof = c->next_frame;
+  return frameclock_due(c, h->now, late);
+}
+
+/* SOF number k of the host, from the clock's unwrapped frame number n */
+static uint32_t host_sof(const host_t *h, uint32_t n) {
+  return n - h->fn0;
+}
+
+/* Locks on the FRAMECLOCK_WINDOW-th SOF, not before, however late the sightings */
+static void check_lock(void) {
+  frameclock_t c;
+  frameclock_init(&c, TICK_US, LEAD_US, 0);
+  for (uint32_t k = 0; k < FRAMECLOCK_WINDOW; k++) {
+    CHECK(!c.locked);
+    frameclock_sof(&c, k, 1000u + k * 1000u + (uint32_t)(rand() % 300));
+  }
+  CHECK(c.locked);
+  CHECK_EQ(c.locks, 1);
+  CHECK_EQ(c.sofs, FRAMECLOCK_WINDOW);
+}
+
+/* 20 s at a given host offset: after 2 s to settle, every frame starts within a few
+ * tens of us of LEAD_US before an even SOF, one frame per two SOFs, and the period
+ * estimate is within FRAMECLOCK_PPM_MAX and near the true offset. */
+static void check_tracking(double ppm, uint32_t fn0) {
+  host_t h = { ppm, 300.0, fn0, 0, 0, true };
+  frameclock_t c;
+  frameclock_init(&c, TICK_US, LEAD_US, 0);
+  int frames = 0;
+  double err_max = 0, err_sum = 0;
+  uint32_t last = 0;
+  int gap_bad = 0;
+  while (h.now < 20000000u) {
+    uint32_t late, sof;
+    if (!pass(&h, &c, &late, &sof) || h.now < 2000000u) {
+      continue;
+    }
+    CHECK(c.locked);
+    uint32_t k = host_sof(&h, sof);
+    CHECK_EQ(k % 2, fn0 % 2);   /* phase 0 of the 11-bit numbers */
+    double err = (double)h.now - (sof_at(&h, k) - LEAD_US);
+    if (err < 0) err = -err;
+    if (err > err_max) err_max = err;
+    err_sum += err;
+    if (frames > 0 && (h.now - last < TICK_US - 450 || h.now - last > TICK_US + 450))
+      gap_bad++;
+    last = h.now;
+    frames++;
+  }
+  int32_t est = frameclock_ppm(&c);
+  printf("%+5.0f ppm, fn from %4u: %d frames, SOF offset estimated %+d ppm, frame error mean %.1f us max %.0f us\n",
+         ppm, fn0, frames, est, err_sum / frames, err_max);
+  CHECK(frames > 8990 && frames < 9010);    /* 18 s of 2 ms frames */
+  CHECK(est >= -FRAMECLOCK_PPM_MAX && est <= FRAMECLOCK_PPM_MAX);
+  CHECK(est > ppm - 25 && est < ppm + 25);
+  CHECK(err_sum / frames < 25);
+  CHECK(err_max < 450);                     /* a 400 us pass delays one frame at most that */
+  CHECK_EQ(gap_bad, 0);
+  CHECK_EQ(c.locks, 1);                     /* the frame number wrap is not a gap */
+  CHECK_EQ(c.sofs, h.seen);
+  CHECK_EQ(c.frame, fn0 + h.seen - 1);
+}
+
+/* SOFs stop: unlocked after FRAMECLOCK_LOST_US, frames go on every TICK_US from the
+ * last one; SOFs back: locked again after one window. */
+static void check_lost(void) {
+  host_t h = { 40.0, 100.0, 0, 0, 0, true };
+  frameclock_t c;
+  frameclock_init(&c, TICK_US, LEAD_US, 0);
+  uint32_t late, sof;
+  while (h.now < 1000000u)
+    pass(&h, &c, &late, &sof);
+  CHECK(c.locked);
+  h.sofs = false;
+  uint32_t last_sof = c.last_seen_us, last_frame = 0, frames = 0;
+  while (h.now < 1100000u) {
+    if (pass(&h, &c, &late, &sof)) {
+      if (h.now - last_sof > FRAMECLOCK_LOST_US + 500) {
+        CHECK(!c.locked);
+        if (last_frame && h.now - last_frame > TICK_US + 450) CHECK(false);
+        frames++;
+      }
+      last_frame = h.now;
+    }
+    if (h.now - last_sof > FRAMECLOCK_LOST_US + 50)
+      CHECK(!c.locked);
+    else if (h.now - last_sof < FRAMECLOCK_LOST_US)
+      CHECK(c.locked);
+  }
+  CHECK(frames > 45 && frames <= 50);   /* ~95 ms free-running */
+  /* The host comes back, its SOF numbers wherever they are */
+  h.sofs = true;
+  h.t0 = (double)h.now + 123.0;
+  h.fn0 = 1500;
+  h.seen = 0;
+  while (h.seen < FRAMECLOCK_WINDOW - 1)
+    pass(&h, &c, &late, &sof);
+  CHECK(!c.locked);
+  while (h.seen < FRAMECLOCK_WINDOW)
+    pass(&h, &c, &late, &sof);
+  CHECK(c.locked);
+  CHECK_EQ(c.locks, 2);
+}
+
+/* A stall that misses frames runs one late frame, not the missed ones back to back,
+ * and the next is on time. Locked, the stall is short of FRAMECLOCK_LOST_US (longer
+ * and the clock starts over); free-running, 10 ms. */
+static void check_stall(bool locked) {
+  host_t h = { 0.0, 0.0, 0, 0, 0, locked };
+  frameclock_t c;
+  frameclock_init(&c, TICK_US, LEAD_US, 0);
+  uint32_t late, sof;
+  while (h.now < 500000u)
+    pass(&h, &c, &late, &sof);
+  CHECK_EQ(c.locked, locked);
+  uint32_t stall = locked ? FRAMECLOCK_LOST_US - 100 : 10000;
+  h.now += stall;
+  while (h.sofs && sof_at(&h, h.seen) <= (double)h.now)
+    frameclock_sof(&c, h.fn0 + h.seen++, h.now);
+  CHECK_EQ(c.locked, locked);
+  CHECK(frameclock_due(&c, h.now, &late));
+  CHECK(late >= stall - TICK_US && late < stall);
+  CHECK(!frameclock_due(&c, h.now, &late));
+  CHECK(!frameclock_due(&c, h.now + 1, &late));
+  uint32_t wait = frameclock_wait_us(&c, h.now);
+  CHECK(wait > 0 && wait <= TICK_US);
+  CHECK(frameclock_due(&c, h.now + wait, &late));
+  CHECK_EQ(late, 0);
+}
+
+/* Frames run ahead of even SOFs; the host polls in odd ones. A stray poll doesn't
+ * move them, FRAMECLOCK_POLLS in a row do: from then on each frame is LEAD_US before
+ * an odd SOF. */
+static void check_poll_phase(void) {
+  host_t h = { -60.0, 700.0, 0, 0, 0, true };
+  frameclock_t c;
+  frameclock_init(&c, TICK_US, LEAD_US, 0);
+  uint32_t late, sof;
+  while (h.now < 200000u)
+    pass(&h, &c, &late, &sof);
+  CHECK(c.locked);
+  CHECK_EQ(c.next_frame % 2, 0);
+  /* one poll in an odd frame among even ones */
+  uint32_t seen = h.seen;
+  while (h.seen == seen || c.frame % 2 == 0)
+    pass(&h, &c, &late, &sof);
+  frameclock_polled(&c);
+  for (int k = 0; k < FRAMECLOCK_POLLS; k++) {
+    seen = h.seen;
+    while (h.seen == seen || c.frame % 2 == 1)
+      pass(&h, &c, &late, &sof);
+    frameclock_polled(&c);
+  }
+  CHECK_EQ(c.phase, 0);
+  /* polls in odd frames from now on */
+  for (int k = 0; k < FRAMECLOCK_POLLS; k++) {
+    CHECK_EQ(c.phase, 0);
+    seen = h.seen;
+    while (h.seen == seen || c.frame % 2 == 0)
+      pass(&h, &c, &late, &sof);
+    frameclock_polled(&c);
+  }
+  CHECK_EQ(c.phase, 1);
+  CHECK_EQ(c.next_frame % 2, 1);
+  int frames = 0;
+  while (h.now < 400000u) {
+    if (!pass(&h, &c, &late, &sof)) continue;
+    CHECK_EQ(sof % 2, 1);
+    double err = (double)h.now - (sof_at(&h, host_sof(&h, sof)) - LEAD_US);
+    CHECK(err > -60 && err < 450);
+    frames++;
+  }
+  CHECK(frames > 90);
+}
+
+int main(void) {
+  srand(50);
+  check_lock();
+  check_tracking(0, 0);
+  check_tracking(100, 0);
+  check_tracking(-100, 0);
+  check_tracking(100, 2000);   /* wraps to 0 within the first 50 ms, and every 2.048 s */
+  check_lost();
+  check_stall(true);
+  check_stall(false);
+  check_poll_phase();
+  return check_done("test_frameclock");
+}
@@ -0,0 +1,180 @@
+/**
+ * fusion: synthetic traces of redundant mice watching the same motion. The truth is
+ * a 1 kHz series of hand strokes; each input sees it with its own faults (additive
+ * noise, outlier spikes, stretches where it reports nothing) and fusion_step()
+ * combines them. The fused path must track the truth: the final position within a
+ * fraction of the distance travelled, and any one second of motion (a stroke across
+ * the screen) off by no more than a few counts. Zero-mean jitter in the deltas is a
+ * random walk in position that no combiner can take back out, so the per-second
+ * error is the one that shows what fusion does. Plain averaging of the same inputs is
+ * measured alongside for comparison.
+ */
+#include "fusion.h"
+#include "check.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAMES  200000
+#define WINDOW  1000   /* frames: one second at 1 kHz */
+
+typedef enum { CLEAN, NOISY, SPIKY, DROPOUT } fault_t;
+
+typedef struct {
+  const char *name;
+  int n;
+  fault_t fault[4];
+  uint32_t live_mask;
+  double max_final;   /* allowed |final error| / path length */
+  int max_window;     /* allowed worst error over any WINDOW frames, counts (L1) */
+} trace_t;
+
+static int32_t g_tx[FRAMES], g_ty[FRAMES];
+
+static int rnd(int lo, int hi) {
+  return lo + rand() % (hi - lo + 1);
+}
+
+/* Strokes of random speed (0-20 counts/frame) and direction, with pauses */
+static void make_truth(void) {
+  int left = 0;
+  double vx = 0, vy = 0, fx = 0, fy = 0;
+  for (int k = 0; k < FRAMES; k++) {
+    if (left-- <= 0) {
+      left = rnd(30, 400);
+      double speed = rand() % 4 == 0 ? 0.0 : rnd(0, 2000) / 100.0, dir = rnd(0, 628) / 100.0;
+      vx = speed * cos(dir);
+      vy = speed * sin(dir);
+    }
+    fx += vx;
+    fy += vy;
+    g_tx[k] = (int32_t)floor(fx);
+    g_ty[k] = (int32_t)floor(fy);
+    fx -= g_tx[k];
+    fy -= g_ty[k];
+  }
+}
+
+typedef struct {
+  int dropout_left, dropout_next;
+} fault_state_t;
+
+static void observe(fault_t f, fault_state_t *st, int32_t tx, int32_t ty, int32_t *dx, int32_t *dy) {
+  *dx = tx;
+  *dy = ty;
+  switch (f) {
+    case CLEAN:
+      break;
+    case NOISY:   /* zero-mean jitter of +-3 counts per frame */
+      *dx += rnd(-3, 3);
+      *dy += rnd(-3, 3);
+      break;
+    case SPIKY:   /* +-1 jitter and a 20-60 count glitch one frame in 200 */
+      *dx += rnd(-1, 1);
+      *dy += rnd(-1, 1);
+      if (rand() % 200 == 0) {
+        *dx += rnd(0, 1) ? rnd(20, 60) : -rnd(20, 60);
+        *dy += rnd(0, 1) ? rnd(20, 60) : -rnd(20, 60);
+      }
+      break;
+    case DROPOUT:   /* lifted or lost link: 50-500 frames of nothing, every 500-3000 */
+      if (st->dropout_left > 0) {
+        st->dropout_left--;
+        *dx = *dy = 0;
+      } else if (--st->dropout_next <= 0) {
+        st->dropout_left = rnd(50, 500);
+        st->dropout_next = rnd(500, 3000);
+      }
+      break;
+  }
+}
+
+static void run(const trace_t *t) {
+  fusion_t f;
+  fusion_reset(&f);
+  fault_state_t st[4];
+  memset(st, 0, sizeof(st));
+  srand(4);
+  long long tx = 0, ty = 0, fx = 0, fy = 0, ax = 0, ay = 0, path = 0;
+  long long worst = 0, avg_worst = 0, dropped_frames = 0, silent_frames = 0;
+  static long long err[WINDOW][2], avg_err[WINDOW][2];   /* position error, WINDOW frames back */
+  memset(err, 0, sizeof(err));
+  memset(avg_err, 0, sizeof(avg_err));
+  int32_t ares[2] = { 0, 0 };
+  for (int k = 0; k < FRAMES; k++) {
+    int32_t dx[4], dy[4], ox, oy;
+    bool silent = false;
+    for (int i = 0; i < t->n; i++) {
+      observe(t->fault[i], &st[i], g_tx[k], g_ty[k], &dx[i], &dy[i]);
+      if (t->fault[i] == DROPOUT && st[i].dropout_left > 0) silent = true;
+    }
+    fusion_step(&f, dx, dy, t->n, t->live_mask, &ox, &oy);
+    if (silent && (g_tx[k] || g_ty[k])) {
+      silent_frames++;
+      if (fusion_dropped(&f, t->n)) dropped_frames++;
+    }
+
+    /* Plain average of the live inputs, remainder kept */
+    int32_t sx = 0, sy = 0, live = 0;
+    for (int i = 0; i < t->n; i++)
+      if (t->live_mask & (1u << i)) {
+        sx += dx[i];
+        sy += dy[i];
+        live++;
+      }
+    sx += ares[0];
+    sy += ares[1];
+    ares[0] = sx % live;
+    ares[1] = sy % live;
+    ax += sx / live;
+    ay += sy / live;
+
+    tx += g_tx[k];
+    ty += g_ty[k];
+    fx += ox;
+    fy += oy;
+    path += llabs(g_tx[k]) + llabs(g_ty[k]);
+    long long *e = err[k % WINDOW], *ea = avg_err[k % WINDOW];
+    long long w = llabs(fx - tx - e[0]) + llabs(fy - ty - e[1]);
+    long long wa = llabs(ax - tx - ea[0]) + llabs(ay - ty - ea[1]);
+    if (w > worst) worst = w;
+    if (wa > avg_worst) avg_worst = wa;
+    e[0] = fx - tx;
+    e[1] = fy - ty;
+    ea[0] = ax - tx;
+    ea[1] = ay - ty;
+  }
+  double fe = (double)(llabs(fx - tx) + llabs(fy - ty)) / (double)path;
+  double ae = (double)(llabs(ax - tx) + llabs(ay - ty)) / (double)path;
+  printf("%-26s %7.3f%% %6lld   %7.3f%% %6lld", t->name, 100.0 * fe, worst, 100.0 * ae, avg_worst);
+  if (silent_frames)
+    printf("   %5.1f%%", 100.0 * (double)dropped_frames / (double)silent_frames);
+  printf("\n");
+  CHECK(fe <= t->max_final);
+  CHECK(worst <= t->max_window);
+  if (silent_frames) {
+    CHECK(worst * 5 < avg_worst);                /* dropouts: well ahead of averaging */
+    CHECK(dropped_frames * 10 >= silent_frames * 8);
+  }
+}
+
+int main(void) {
+  srand(5);
+  make_truth();
+  long long path = 0;
+  for (int k = 0; k < FRAMES; k++)
+    path += llabs(g_tx[k]) + llabs(g_ty[k]);
+  printf("%d frames, %lld counts of travel (L1)\n", FRAMES, path);
+  printf("                           fusion: final, worst 1 s   average: final, worst 1 s   dropout flagged\n");
+
+  static const trace_t traces[] = {
+    { "clean x3",                  3, { CLEAN, CLEAN, CLEAN },       0x7, 0.00001, 50 },
+    { "clean, noisy, dropout",     3, { CLEAN, NOISY, DROPOUT },     0x7, 0.0025,  300 },
+    { "noisy, noisy",              2, { NOISY, NOISY },              0x3, 0.0025,  350 },
+    { "spiky, noisy, dropout",     3, { SPIKY, NOISY, DROPOUT },     0x7, 0.0025,  450 },
+    { "clean, spiky (not live)",   2, { CLEAN, SPIKY },              0x1, 0.00001, 50 },
+  };
+  for (unsigned k = 0; k < sizeof(traces) / sizeof(traces[0]); k++)
+    run(&traces[k]);
+  return check_done("test_fusion");
+}
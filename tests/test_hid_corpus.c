@@ -0,0 +1,145 @@
+/**
+ * hid_mouse against a corpus of real mouse report descriptors (the .hid files in
+ * tests/hid_corpus, passed on the command line). Each file holds a descriptor, the
+ * extraction plan it must compile to, and sample reports with the values they must
+ * read as:
+ *
+ *   desc: 05 01 09 02 ...                       (repeated lines are concatenated)
+ *   plan: id 2 len 5 buttons 0/2/0/16/u x 2/2/0/12/s ... pan -    or    plan: none
+ *   report: 02 01 80 FE FF 7F FD 01 -> 32769 -2 2047 -3 1         (buttons dx dy wheel pan)
+ *   report: 02 00 00 -> reject
+ *
+ * A field is byte/nbytes/shift/size/signedness, '-' when the report doesn't carry it.
+ */
+#include "hid_mouse.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DESC_MAX    1024
+#define REPORT_MAX  64
+#define LINE_LEN    512
+
+/* Hex bytes in s appended to buf; stops at "->" or the end. Returns the new length. */
+static size_t parse_hex(const char *s, uint8_t *buf, size_t n, size_t cap) {
+  while (*s) {
+    char *end;
+    if (s[0] == '-' && s[1] == '>') break;
+    unsigned long v = strtoul(s, &end, 16);
+    if (end == s) {
+      s++;
+      continue;
+    }
+    if (n < cap) buf[n++] = (uint8_t)v;
+    s = end;
+  }
+  return n;
+}
+
+static void format_op(char *out, size_t cap, const hid_op_t *op) {
+  if (op->nbytes == 0)
+    snprintf(out, cap, "-");
+  else
+    snprintf(out, cap, "%u/%u/%u/%u/%c", op->byte, op->nbytes, op->shift, op->size, op->is_signed ? 's' : 'u');
+}
+
+static void format_plan(char *out, size_t cap, const hid_mouse_plan_t *p) {
+  char b[24], x[24], y[24], w[24], pan[24];
+  format_op(b, sizeof(b), &p->buttons);
+  format_op(x, sizeof(x), &p->x);
+  format_op(y, sizeof(y), &p->y);
+  format_op(w, sizeof(w), &p->wheel);
+  format_op(pan, sizeof(pan), &p->pan);
+  snprintf(out, cap, "id %u len %u buttons %s x %s y %s wheel %s pan %s", p->report_id, p->min_len, b, x, y, w, pan);
+}
+
+/* Collapse runs of whitespace and strip both ends, in place. */
+static char *squeeze(char *s) {
+  char *w = s;
+  for (char *r = s; *r; r++) {
+    if (*r == ' ' || *r == '\t' || *r == '\n' || *r == '\r') {
+      if (w > s && w[-1] != ' ') *w++ = ' ';
+    } else {
+      *w++ = *r;
+    }
+  }
+  if (w > s && w[-1] == ' ') w--;
+  *w = 0;
+  while (*s == ' ') s++;
+  return s;
+}
+
+static void check_file(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "%s: can't open\n", path);
+    CHECK(f != NULL);
+    return;
+  }
+  uint8_t desc[DESC_MAX];
+  size_t len = 0;
+  bool parsed = false, ok = false, have_plan = false;
+  hid_mouse_layout_t l;
+  hid_mouse_plan_t p;
+  int reports = 0;
+  char line[LINE_LEN];
+  while (fgets(line, sizeof(line), f)) {
+    if (strncmp(line, "desc:", 5) == 0) {
+      len = parse_hex(line + 5, desc, len, sizeof(desc));
+      continue;
+    }
+    if (!parsed && (strncmp(line, "plan:", 5) == 0 || strncmp(line, "report:", 7) == 0)) {
+      ok = hid_mouse_parse(desc, len, &l);
+      if (ok) hid_mouse_compile(&l, &p);
+      parsed = true;
+    }
+    if (strncmp(line, "plan:", 5) == 0) {
+      char got[160];
+      const char *want = squeeze(line + 5);
+      if (ok) format_plan(got, sizeof(got), &p);
+      else snprintf(got, sizeof(got), "none");
+      if (strcmp(got, want) != 0) {
+        fprintf(stderr, "%s: plan\n  got  %s\n  want %s\n", path, got, want);
+        CHECK(strcmp(got, want) == 0);
+      }
+      have_plan = true;
+    } else if (strncmp(line, "report:", 7) == 0) {
+      uint8_t rep[REPORT_MAX];
+      size_t n = parse_hex(line + 7, rep, 0, sizeof(rep));
+      const char *arrow = strstr(line, "->");
+      CHECK(arrow != NULL && ok);
+      if (!arrow || !ok) continue;
+      hid_mouse_report_t r = { 0 };
+      bool got = hid_mouse_extract(&p, rep, n, &r);
+      reports++;
+      if (strncmp(squeeze((char *)arrow + 2), "reject", 6) == 0) {
+        if (got) fprintf(stderr, "%s: report %d accepted, want reject\n", path, reports);
+        CHECK(!got);
+        continue;
+      }
+      long v[5];
+      CHECK(sscanf(arrow + 2, "%ld %ld %ld %ld %ld", &v[0], &v[1], &v[2], &v[3], &v[4]) == 5);
+      if (!got || r.buttons != v[0] || r.dx != v[1] || r.dy != v[2] || r.wheel != v[3] || r.pan != v[4]) {
+        fprintf(stderr, "%s: report %d\n  got  %s%u %d %d %d %d\n  want %ld %ld %ld %ld %ld\n", path, reports,
+                got ? "" : "(rejected) ", r.buttons, r.dx, r.dy, r.wheel, r.pan, v[0], v[1], v[2], v[3], v[4]);
+        CHECK(got);
+        CHECK_EQ(r.buttons, v[0]);
+        CHECK_EQ(r.dx, v[1]);
+        CHECK_EQ(r.dy, v[2]);
+        CHECK_EQ(r.wheel, v[3]);
+        CHECK_EQ(r.pan, v[4]);
+      }
+    }
+  }
+  fclose(f);
+  CHECK(len > 0);
+  CHECK(have_plan);
+  printf("%s: %zu descriptor bytes, %s, %d reports\n", path, len, ok ? "mouse" : "no mouse", reports);
+}
+
+int main(int argc, char **argv) {
+  CHECK(argc > 1);   /* the corpus comes from CMake */
+  for (int i = 1; i < argc; i++)
+    check_file(argv[i]);
+  return check_done("test_hid_corpus");
+}
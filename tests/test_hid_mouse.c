@@ -0,0 +1,238 @@
+/**
+ * hid_mouse: the boot layout, and the report descriptor parser on boot-compatible,
+ * report-ID'd and combo (keyboard + mouse) descriptors, absolute pointers, push/pop,
+ * split button items and every truncation; then extraction from reports, and of
+ * random field layouts against a bit-by-bit read.
+ */
+#include "hid_mouse.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FIELD_EQ(f, off, sz, sgn) do { \
+    CHECK_EQ((f).offset, off); CHECK_EQ((f).size, sz); CHECK_EQ((f).is_signed, sgn); \
+  } while (0)
+
+#define LAYOUT_FIELD_EQ(a, b, f) FIELD_EQ((a).f, (b).f.offset, (b).f.size, (b).f.is_signed)
+
+/* HID 1.11 Appendix E.10: the boot-compatible 3-button mouse */
+static const uint8_t desc_boot[] = {
+  0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00,
+  0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01, 0x81, 0x02,
+  0x95, 0x01, 0x75, 0x05, 0x81, 0x01,
+  0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x02, 0x81, 0x06,
+  0xC0, 0xC0,
+};
+
+/* Keyboard (report ID 1) then mouse (report ID 2) on one interface, as on wireless combos */
+static const uint8_t desc_combo[] = {
+  0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, 0x01,
+  0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02,
+  0x95, 0x01, 0x75, 0x08, 0x81, 0x01,
+  0x95, 0x06, 0x75, 0x08, 0x15, 0x00, 0x25, 0x65, 0x05, 0x07, 0x19, 0x00, 0x29, 0x65, 0x81, 0x00,
+  0xC0,
+  0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x85, 0x02, 0x09, 0x01, 0xA1, 0x00,
+  0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01, 0x81, 0x02,
+  0x95, 0x01, 0x75, 0x05, 0x81, 0x01,
+  0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x38, 0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x03, 0x81, 0x06,
+  0xC0, 0xC0,
+};
+
+/* Absolute pointer with the Mouse usage (a USB tablet): rejected */
+static const uint8_t desc_tablet[] = {
+  0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00,
+  0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01, 0x81, 0x02,
+  0x95, 0x01, 0x75, 0x05, 0x81, 0x01,
+  0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x15, 0x00, 0x26, 0xFF, 0x7F, 0x75, 0x10, 0x95, 0x02, 0x81, 0x02,
+  0xC0, 0xC0,
+};
+
+/* Report ID given inside the collection, the buttons split over two Input items, and
+ * Push/Pop around a 12-bit axis pair: the wheel takes its size, count and logical
+ * minimum from the state pushed before the axes */
+static const uint8_t desc_pushpop[] = {
+  0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00, 0x85, 0x07,
+  0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01, 0x81, 0x02,
+  0x19, 0x04, 0x29, 0x05, 0x95, 0x02, 0x81, 0x02,
+  0x95, 0x01, 0x75, 0x03, 0x81, 0x01,
+  0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x01,
+  0xA4,                                            /* Push */
+  0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x16, 0x01, 0xF8, 0x26, 0xFF, 0x07, 0x75, 0x0C, 0x95, 0x02, 0x81, 0x06,
+  0xB4,                                            /* Pop: 8 bits x 1, signed */
+  0x05, 0x01, 0x09, 0x38, 0x81, 0x06,
+  0xC0, 0xC0,
+};
+
+static void check_boot_layout(void) {
+  hid_mouse_layout_t l;
+  hid_mouse_plan_t p;
+  hid_mouse_report_t r;
+  hid_mouse_boot_layout(&l);
+  CHECK_EQ(l.report_id, 0);
+  FIELD_EQ(l.buttons, 0, 5, false);
+  FIELD_EQ(l.x, 8, 8, true);
+  FIELD_EQ(l.y, 16, 8, true);
+  FIELD_EQ(l.wheel, 24, 8, true);
+  CHECK_EQ(l.pan.size, 0);
+  hid_mouse_compile(&l, &p);
+  CHECK_EQ(p.min_len, 3);
+
+  const uint8_t three[] = { 0xFF, 0x80, 0x7F };   /* bits 5-7 are vendor padding */
+  CHECK(hid_mouse_extract(&p, three, sizeof(three), &r));
+  CHECK_EQ(r.buttons, 0x1F);
+  CHECK_EQ(r.dx, -128);
+  CHECK_EQ(r.dy, 127);
+  CHECK_EQ(r.wheel, 0);   /* no wheel byte: 0 */
+  const uint8_t four[] = { 0x02, 0x05, 0xFB, 0xFF };
+  CHECK(hid_mouse_extract(&p, four, sizeof(four), &r));
+  CHECK_EQ(r.buttons, 2);
+  CHECK_EQ(r.dx, 5);
+  CHECK_EQ(r.dy, -5);
+  CHECK_EQ(r.wheel, -1);
+  CHECK(!hid_mouse_extract(&p, four, 2, &r));   /* no Y */
+}
+
+static void check_boot_descriptor(void) {
+  hid_mouse_layout_t l;
+  CHECK(hid_mouse_parse(desc_boot, sizeof(desc_boot), &l));
+  CHECK_EQ(l.report_id, 0);
+  FIELD_EQ(l.buttons, 0, 3, false);
+  FIELD_EQ(l.x, 8, 8, true);
+  FIELD_EQ(l.y, 16, 8, true);
+  CHECK_EQ(l.wheel.size, 0);
+  CHECK_EQ(l.pan.size, 0);
+}
+
+static void check_report_ids(void) {
+  hid_mouse_layout_t l;
+  hid_mouse_plan_t p;
+  hid_mouse_report_t r;
+  CHECK(hid_mouse_parse(desc_combo, sizeof(desc_combo), &l));
+  CHECK_EQ(l.report_id, 2);
+  FIELD_EQ(l.buttons, 0, 3, false);   /* offsets count from after the ID byte */
+  FIELD_EQ(l.x, 8, 8, true);
+  FIELD_EQ(l.y, 16, 8, true);
+  FIELD_EQ(l.wheel, 24, 8, true);
+  hid_mouse_compile(&l, &p);
+
+  const uint8_t kbd[] = { 0x01, 0x00, 0x00, 0x04, 0, 0, 0, 0, 0 };   /* keyboard report: not ours */
+  CHECK(!hid_mouse_extract(&p, kbd, sizeof(kbd), &r));
+  const uint8_t mouse[] = { 0x02, 0x01, 0x10, 0xF0, 0x01 };
+  CHECK(hid_mouse_extract(&p, mouse, sizeof(mouse), &r));
+  CHECK_EQ(r.buttons, 1);
+  CHECK_EQ(r.dx, 16);
+  CHECK_EQ(r.dy, -16);
+  CHECK_EQ(r.wheel, 1);
+  CHECK(!hid_mouse_extract(&p, mouse, 3, &r));   /* ID + buttons + X: no Y */
+  CHECK(!hid_mouse_extract(&p, mouse, 0, &r));
+
+  /* Mouse first, keyboard after: the keyboard collection doesn't disturb it */
+  uint8_t swapped[sizeof(desc_combo)];
+  size_t kbd_len = 47;   /* the keyboard collection */
+  memcpy(swapped, desc_combo + kbd_len, sizeof(desc_combo) - kbd_len);
+  memcpy(swapped + sizeof(desc_combo) - kbd_len, desc_combo, kbd_len);
+  hid_mouse_layout_t l2;
+  CHECK(hid_mouse_parse(swapped, sizeof(swapped), &l2));
+  CHECK_EQ(l2.report_id, l.report_id);
+  LAYOUT_FIELD_EQ(l2, l, buttons);
+  LAYOUT_FIELD_EQ(l2, l, x);
+  LAYOUT_FIELD_EQ(l2, l, y);
+  LAYOUT_FIELD_EQ(l2, l, wheel);
+
+  /* Keyboard only: no mouse */
+  CHECK(!hid_mouse_parse(desc_combo, kbd_len, &l2));
+}
+
+static void check_rejects(void) {
+  hid_mouse_layout_t l;
+  CHECK(!hid_mouse_parse(desc_tablet, sizeof(desc_tablet), &l));
+  CHECK(!hid_mouse_parse(desc_boot, 0, &l));
+  const uint8_t junk[] = { 0xFE, 0xFF, 0x00 };   /* long item running past the end */
+  CHECK(!hid_mouse_parse(junk, sizeof(junk), &l));
+}
+
+static void check_pushpop(void) {
+  hid_mouse_layout_t l;
+  hid_mouse_plan_t p;
+  hid_mouse_report_t r;
+  CHECK(hid_mouse_parse(desc_pushpop, sizeof(desc_pushpop), &l));
+  CHECK_EQ(l.report_id, 7);
+  FIELD_EQ(l.buttons, 0, 5, false);   /* 3 + 2 over two items */
+  FIELD_EQ(l.x, 8, 12, true);
+  FIELD_EQ(l.y, 20, 12, true);
+  FIELD_EQ(l.wheel, 32, 8, true);     /* after Pop */
+  hid_mouse_compile(&l, &p);
+  CHECK_EQ(p.min_len, 4);
+  /* buttons 1 and 5, X = -2 (0xFFE), Y = 2047 (0x7FF), wheel -3 */
+  const uint8_t rep[] = { 0x07, 0x11, 0xFE, 0xFF, 0x7F, 0xFD };
+  CHECK(hid_mouse_extract(&p, rep, sizeof(rep), &r));
+  CHECK_EQ(r.buttons, 0x11);
+  CHECK_EQ(r.dx, -2);
+  CHECK_EQ(r.dy, 2047);
+  CHECK_EQ(r.wheel, -3);
+}
+
+/* Every prefix of every descriptor: the parser stays inside it, and any layout it
+ * returns has both axes. Run under -DSANITIZE=ON to have out-of-bounds reads caught. */
+static void check_truncations(void) {
+  const struct { const uint8_t *d; size_t n; } all[] = {
+    { desc_boot, sizeof(desc_boot) }, { desc_combo, sizeof(desc_combo) },
+    { desc_tablet, sizeof(desc_tablet) }, { desc_pushpop, sizeof(desc_pushpop) },
+  };
+  for (unsigned k = 0; k < sizeof(all) / sizeof(all[0]); k++) {
+    for (size_t n = 0; n <= all[k].n; n++) {
+      uint8_t *copy = malloc(n ? n : 1);   /* exactly n bytes, so ASan sees overreads */
+      memcpy(copy, all[k].d, n);
+      hid_mouse_layout_t l;
+      if (hid_mouse_parse(copy, n, &l)) {
+        CHECK(l.x.size > 0 && l.y.size > 0);
+      }
+      free(copy);
+    }
+  }
+}
+
+/* Random fields of 1-32 bits at bit offsets 0-99, as X, against a bit-by-bit read of
+ * the same report: every value matches (saturated to int16), and a report that stops
+ * before the field's last byte is rejected. */
+static void check_random_fields(void) {
+  srand(46);
+  for (int k = 0; k < 200000; k++) {
+    hid_mouse_layout_t l;
+    memset(&l, 0, sizeof(l));
+    l.x.offset = (uint16_t)(rand() % 100);
+    l.x.size = (uint8_t)(1 + rand() % 32);
+    l.x.is_signed = rand() & 1;
+    l.y.size = 1;   /* bit 0 */
+    hid_mouse_plan_t p;
+    hid_mouse_compile(&l, &p);
+
+    uint8_t rep[17];
+    for (size_t i = 0; i < sizeof(rep); i++)
+      rep[i] = (uint8_t)rand();
+    int64_t v = 0;
+    for (int b = 0; b < l.x.size; b++)
+      v |= (int64_t)((rep[(l.x.offset + b) / 8] >> ((l.x.offset + b) % 8)) & 1) << b;
+    if (l.x.is_signed && (v >> (l.x.size - 1)) & 1)
+      v -= (int64_t)1 << l.x.size;
+    int16_t want = v > 32767 ? 32767 : v < -32768 ? -32768 : (int16_t)v;
+
+    size_t need = (size_t)(l.x.offset + l.x.size + 7) / 8;
+    size_t len = need - 1 + (size_t)(rand() % 3);   /* one short, exact or one over */
+    hid_mouse_report_t r;
+    bool ok = hid_mouse_extract(&p, rep, len, &r);
+    CHECK_EQ(ok, len >= need);
+    if (ok) CHECK_EQ(r.dx, want);
+  }
+}
+
+int main(void) {
+  check_boot_layout();
+  check_boot_descriptor();
+  check_report_ids();
+  check_rejects();
+  check_pushpop();
+  check_truncations();
+  check_random_fields();
+  return check_done("test_hid_mouse");
+}
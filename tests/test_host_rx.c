@@ -0,0 +1,200 @@
+/**
+ * host_rx: raw HID OUT frames and slot-addressed host records as main.c reads them.
+ * Frames shorter than their records and counts past the six records a 64-byte frame
+ * holds are rejected without being counted; sequence gaps are counted (not the 255 -> 0
+ * wrap, not the first frame); records decode every int16 field, and only into the
+ * slots plan_build gives the host source, never at or past the slots compiled in.
+ * Then random frames laid out as scripts/hidraw_send_mice.py sends them: every count
+ * sent to a host slot arrives. Configure with -DSANITIZE=ON to have any read past a
+ * truncated frame caught.
+ */
+#include "host_rx.h"
+#include "plan.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void put_record(uint8_t *b, uint8_t slot, uint8_t buttons, int16_t dx, int16_t dy,
+                       int16_t wheel, int16_t pan) {
+  const int16_t v[4] = { dx, dy, wheel, pan };
+  b[0] = slot;
+  b[1] = buttons;
+  for (int k = 0; k < 4; k++) {
+    b[2 + 2 * k] = (uint8_t)((uint16_t)v[k] & 0xFF);
+    b[3 + 2 * k] = (uint8_t)((uint16_t)v[k] >> 8);
+  }
+}
+
+/* A frame of count records for slots 0.. in a buffer of exactly len bytes (heap, so
+ * the sanitizer sees its end; none at all for len 0, so nothing may be read) */
+static uint8_t *frame(int count, uint8_t seq, int len) {
+  if (len == 0) return NULL;
+  uint8_t *f = malloc((size_t)len);
+  uint8_t full[HOST_RAW_FRAME_LEN + 256] = { 0 };
+  full[0] = (uint8_t)count;
+  full[1] = seq;
+  for (int k = 0; k < count && HOST_RAW_HEADER_LEN + (k + 1) * HOST_RECORD_LEN <= (int)sizeof(full); k++)
+    put_record(full + HOST_RAW_HEADER_LEN + k * HOST_RECORD_LEN, (uint8_t)k, 1, 1, -1, 0, 0);
+  memcpy(f, full, (size_t)len);
+  return f;
+}
+
+static int raw(host_raw_rx_t *rx, int count, uint8_t seq, int len) {
+  uint8_t *f = frame(count, seq, len);
+  int n = host_raw_frame(rx, f, len);
+  free(f);
+  return n;
+}
+
+/* Every length short of the header and count records is rejected and not counted;
+ * a frame exactly that long, or padded to 64 bytes, is taken. */
+static void check_truncated(void) {
+  host_raw_rx_t rx = { 0 };
+  for (int count = 0; count <= HOST_RAW_RECORDS_MAX; count++) {
+    int need = HOST_RAW_HEADER_LEN + count * HOST_RECORD_LEN;
+    for (int len = 0; len < need; len++)
+      CHECK_EQ(raw(&rx, count, 0, len), -1);
+    CHECK_EQ(rx.frames, 0);
+    CHECK_EQ(raw(&rx, count, (uint8_t)(2 * count), need), count);
+    CHECK_EQ(raw(&rx, count, (uint8_t)(2 * count + 1), HOST_RAW_FRAME_LEN), count);
+    rx.frames = 0;
+  }
+  CHECK_EQ(rx.gaps, 0);
+}
+
+/* A count past the records a 64-byte frame holds is rejected, however long the
+ * buffer it came in. */
+static void check_count(void) {
+  host_raw_rx_t rx = { 0 };
+  CHECK_EQ(HOST_RAW_RECORDS_MAX, 6);
+  CHECK_EQ(raw(&rx, HOST_RAW_RECORDS_MAX, 0, HOST_RAW_FRAME_LEN), HOST_RAW_RECORDS_MAX);
+  CHECK_EQ(raw(&rx, HOST_RAW_RECORDS_MAX + 1, 1, HOST_RAW_FRAME_LEN), -1);
+  CHECK_EQ(raw(&rx, HOST_RAW_RECORDS_MAX + 1, 1, HOST_RAW_HEADER_LEN + 7 * HOST_RECORD_LEN), -1);
+  CHECK_EQ(raw(&rx, 16, 1, HOST_RAW_HEADER_LEN + 16 * HOST_RECORD_LEN), -1);
+  CHECK_EQ(raw(&rx, 255, 1, HOST_RAW_FRAME_LEN), -1);
+  CHECK_EQ(rx.frames, 1);
+  CHECK_EQ(rx.seq, 0);
+}
+
+/* Sequence numbers: +1 per frame through the wrap is no gap; a skip, a repeat or a step
+ * back is one; the first frame starts the count wherever it is; rejected frames leave
+ * the sequence alone. */
+static void check_gaps(void) {
+  host_raw_rx_t rx = { 0 };
+  for (int k = 0; k < 600; k++)
+    CHECK_EQ(raw(&rx, 1, (uint8_t)(200 + k), HOST_RAW_FRAME_LEN), 1);
+  CHECK_EQ(rx.frames, 600);
+  CHECK_EQ(rx.gaps, 0);
+  CHECK_EQ(rx.seq, (uint8_t)(200 + 599));
+
+  rx = (host_raw_rx_t){ 0 };
+  static const uint8_t seqs[] = { 17, 18, 20, 21, 21, 22, 10, 11 };
+  for (size_t k = 0; k < sizeof(seqs); k++)
+    raw(&rx, 0, seqs[k], HOST_RAW_HEADER_LEN);
+  CHECK_EQ(rx.frames, 8);
+  CHECK_EQ(rx.gaps, 3);   /* 18 -> 20, 21 -> 21, 22 -> 10 */
+
+  /* 12 is rejected; 12 again is the next frame */
+  CHECK_EQ(raw(&rx, 1, 12, HOST_RAW_HEADER_LEN), -1);
+  CHECK_EQ(raw(&rx, 0, 12, HOST_RAW_HEADER_LEN), 0);
+  CHECK_EQ(rx.frames, 9);
+  CHECK_EQ(rx.gaps, 3);
+}
+
+/* Every field at its limits, and slots: mask bit set or not, at and past the slots
+ * compiled in, past the mask's width. */
+static void check_records(void) {
+  uint8_t rec[3 * HOST_RECORD_LEN];
+  host_record_t r;
+  put_record(rec, 2, 0x1F, 32767, -32768, -1, 1);
+  put_record(rec + HOST_RECORD_LEN, 5, 0xFF, -32767, 32767, 32767, -32768);
+  put_record(rec + 2 * HOST_RECORD_LEN, 0, 0, 0, 0, 0, 0);
+  CHECK(host_record(rec, 0, 0x04, &r));
+  CHECK_EQ(r.slot, 2);
+  CHECK_EQ(r.buttons, 0x1F);
+  CHECK_EQ(r.dx, 32767);
+  CHECK_EQ(r.dy, -32768);
+  CHECK_EQ(r.wheel, -1);
+  CHECK_EQ(r.pan, 1);
+  CHECK(host_record(rec, 1, 0x20, &r));
+  CHECK_EQ(r.slot, 5);
+  CHECK_EQ(r.buttons, 0xFF);
+  CHECK_EQ(r.dx, -32767);
+  CHECK_EQ(r.dy, 32767);
+  CHECK_EQ(r.wheel, 32767);
+  CHECK_EQ(r.pan, -32768);
+  CHECK(!host_record(rec, 0, 0xFFFFFFFBu, &r));
+  CHECK(!host_record(rec, 2, 0xFFFFFFFEu, &r));
+
+  /* plan_build's host mask at the most mice: nothing at or past SETTINGS_NUM_MICE_MAX */
+  settings_t s;
+  plan_t p;
+  memset(&s, 0, sizeof(s));
+  s.num_mice = SETTINGS_NUM_MICE_MAX;
+  s.amplify = 1.0f;
+  s.quad_scale = 1;
+  memset(s.slot_src, SETTINGS_SRC_ALL, sizeof(s.slot_src));
+  plan_build(&p, &s);
+  for (int slot = 0; slot < 256; slot++) {
+    put_record(rec, (uint8_t)slot, 0, 1, 1, 0, 0);
+    CHECK_EQ(host_record(rec, 0, p.src_slots[PLAN_SRC_HOST], &r), slot < SETTINGS_NUM_MICE_MAX);
+    CHECK_EQ(host_record(rec, 0, 0xFFFFFFFFu, &r), slot < 32);
+  }
+}
+
+/* Random frames as hidraw_send_mice.py builds them (up to six records, any slots,
+ * zero padded to 64 bytes) against a plan that gives the host source every other
+ * slot: per slot, what arrives is what was sent to a host slot. */
+static void check_random(void) {
+  settings_t s;
+  plan_t p;
+  memset(&s, 0, sizeof(s));
+  s.num_mice = SETTINGS_NUM_MICE_MAX;
+  s.input_mode = SETTINGS_INPUT_BOTH;
+  s.amplify = 1.0f;
+  s.quad_scale = 1;
+  for (int i = 0; i < SETTINGS_NUM_MICE_MAX; i++)
+    s.slot_src[i] = i % 2 ? SETTINGS_SRC_HOST : SETTINGS_SRC_QUAD;
+  plan_build(&p, &s);
+  uint32_t slots = p.src_slots[PLAN_SRC_HOST];
+  CHECK(slots != 0);
+
+  int64_t sent[256][4] = { { 0 } }, got[256][4] = { { 0 } };
+  host_raw_rx_t rx = { 0 };
+  srand(36);
+  for (int n = 0; n < 20000; n++) {
+    uint8_t f[HOST_RAW_FRAME_LEN] = { 0 };
+    int count = rand() % (HOST_RAW_RECORDS_MAX + 1);
+    f[0] = (uint8_t)count;
+    f[1] = (uint8_t)n;
+    for (int k = 0; k < count; k++) {
+      int slot = rand() % 20;   /* now and then past the last slot */
+      int16_t v[4];
+      for (int a = 0; a < 4; a++) v[a] = (int16_t)(rand() % 65536 - 32768);
+      put_record(f + HOST_RAW_HEADER_LEN + k * HOST_RECORD_LEN, (uint8_t)slot, 0, v[0], v[1], v[2], v[3]);
+      if (slot < SETTINGS_NUM_MICE_MAX && (s.slot_src[slot] & SETTINGS_SRC_HOST))
+        for (int a = 0; a < 4; a++) sent[slot][a] += v[a];
+    }
+    CHECK_EQ(host_raw_frame(&rx, f, HOST_RAW_FRAME_LEN), count);
+    for (int k = 0; k < count; k++) {
+      host_record_t r;
+      if (!host_record(f + HOST_RAW_HEADER_LEN, k, slots, &r)) continue;
+      got[r.slot][0] += r.dx;
+      got[r.slot][1] += r.dy;
+      got[r.slot][2] += r.wheel;
+      got[r.slot][3] += r.pan;
+    }
+  }
+  CHECK_EQ(rx.frames, 20000);
+  CHECK_EQ(rx.gaps, 0);
+  CHECK(memcmp(sent, got, sizeof(sent)) == 0);
+}
+
+int main(void) {
+  check_truncated();
+  check_count();
+  check_gaps();
+  check_records();
+  check_random();
+  return check_done("test_host_rx");
+}
@@ -0,0 +1,370 @@
+/**
+ * pmw3360 against a mock SPI bus with PMW3360-like devices behind it: power-up,
+ * the SROM download, and the motion burst round-robin with DMA completion that
+ * takes a random number of polls. The mock keeps its own microsecond clock
+ * (advanced by delay_us() and by the test between polls) and fails the test on
+ * any access the datasheet doesn't allow: two chip selects down at once, data
+ * read before t_SRAD / t_SRAD_MOTBR, the product ID read before the 50 ms reset,
+ * or a burst buffer used before its transfer is done.
+ */
+#include "pmw3360.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SENSORS   PMW_SENSORS_MAX
+#define SROM_LEN  64
+#define SROM_ID   0x04
+
+enum { MODE_NONE, MODE_REG, MODE_BURST, MODE_SROM };
+
+typedef struct {
+  bool answers;        /* a sensor is on this chip select (else MISO floats: 0x00) */
+  bool stuck;          /* MISO stuck high: every byte reads 0xFF */
+  bool srom_bad;       /* rejects the SROM download */
+  uint8_t regs[128];
+  uint32_t reset_us;   /* when Power_Up_Reset was written */
+  bool burst_mode;     /* Motion_Burst written since the last other access */
+  int32_t dx, dy;      /* motion not yet read (the sensor saturates at int16) */
+  bool lifted;
+  uint8_t srom[SROM_LEN];
+  size_t srom_n;
+  /* current transaction */
+  bool cs;
+  int mode;
+  uint8_t addr;
+  uint32_t addr_us;
+} mock_sensor_t;
+
+typedef struct {
+  mock_sensor_t s[SENSORS];
+  uint32_t now_us;
+  /* read in flight */
+  uint8_t *dst;
+  uint8_t data[PMW_BURST_LEN];
+  size_t n;
+  int busy_polls;
+  int busy_max;        /* DMA completion takes 0..busy_max busy() polls */
+  long long violations;
+} mock_bus_t;
+
+static mock_bus_t g_mock;
+static bool g_srom_on;
+static uint8_t g_srom_img[SROM_LEN];
+
+const uint8_t *pmw_srom(size_t *len) {
+  *len = g_srom_on ? SROM_LEN : 0;
+  return g_srom_on ? g_srom_img : NULL;
+}
+
+static void violation(const char *what, int sensor) {
+  if (g_mock.violations++ < 10)
+    fprintf(stderr, "mock: %s (sensor %d, t %u us)\n", what, sensor, g_mock.now_us);
+}
+
+static int selected(void) {
+  int sel = -1;
+  for (int i = 0; i < SENSORS; i++)
+    if (g_mock.s[i].cs) {
+      if (sel >= 0) violation("two chip selects down", i);
+      sel = i;
+    }
+  return sel;
+}
+
+static int16_t take_s16(int32_t *v) {
+  int32_t d = *v > 32767 ? 32767 : *v < -32768 ? -32768 : *v;
+  *v -= d;
+  return (int16_t)d;
+}
+
+static void mock_select(void *ctx, int sensor, bool on) {
+  mock_sensor_t *m = &((mock_bus_t *)ctx)->s[sensor];
+  if (g_mock.dst && !on && g_mock.busy_polls > 0)
+    violation("chip select up with a transfer in flight", sensor);
+  m->cs = on;
+  m->mode = MODE_NONE;
+  selected();
+}
+
+static void reg_write(mock_sensor_t *m, uint8_t reg, uint8_t v) {
+  m->burst_mode = reg == PMW_REG_MOTION_BURST;
+  m->regs[reg] = v;
+  if (reg == PMW_REG_POWER_UP_RESET && v == 0x5A) {
+    m->reset_us = g_mock.now_us;
+    m->regs[PMW_REG_SROM_ID] = 0;
+    m->srom_n = 0;
+  }
+}
+
+static void mock_write(void *ctx, const uint8_t *buf, size_t n) {
+  int i = selected();
+  if (i < 0) {
+    violation("write with no chip select down", -1);
+    return;
+  }
+  mock_sensor_t *m = &((mock_bus_t *)ctx)->s[i];
+  for (size_t k = 0; k < n; k++) {
+    uint8_t b = buf[k];
+    switch (m->mode) {
+      case MODE_NONE:
+        m->addr = b & 0x7Fu;
+        m->addr_us = g_mock.now_us;
+        if (b == (PMW_REG_SROM_LOAD_BURST | 0x80u))
+          m->mode = MODE_SROM;
+        else if (b & 0x80u)
+          m->mode = MODE_REG;   /* write: the value follows */
+        else if (m->addr == PMW_REG_MOTION_BURST && m->burst_mode)
+          m->mode = MODE_BURST;
+        else
+          m->mode = MODE_REG;
+        break;
+      case MODE_REG:
+        reg_write(m, m->addr, b);
+        break;
+      case MODE_SROM:
+        if (m->regs[PMW_REG_SROM_ENABLE] != 0x18) violation("SROM data before SROM_Enable 0x18", i);
+        if (m->srom_n < SROM_LEN) m->srom[m->srom_n] = b;
+        m->srom_n++;
+        break;
+      default:
+        violation("write during a burst", i);
+        break;
+    }
+  }
+}
+
+static uint8_t reg_read(mock_sensor_t *m, int i, uint8_t reg) {
+  m->burst_mode = false;
+  if (g_mock.now_us - m->addr_us < PMW_T_SRAD) violation("register read before t_SRAD", i);
+  if (reg == PMW_REG_PRODUCT_ID && g_mock.now_us - m->reset_us < 50000)
+    violation("product ID read before the 50 ms power-up", i);
+  if (reg == PMW_REG_SROM_ID)
+    return !m->srom_bad && m->srom_n == SROM_LEN && !memcmp(m->srom, g_srom_img, SROM_LEN) ? SROM_ID : 0;
+  return m->regs[reg];
+}
+
+static void mock_read(void *ctx, uint8_t *buf, size_t n) {
+  mock_bus_t *b = ctx;
+  int i = selected();
+  if (i < 0 || n > sizeof(b->data)) {
+    violation("read with no chip select down", i);
+    return;
+  }
+  mock_sensor_t *m = &b->s[i];
+  memset(b->data, 0, sizeof(b->data));
+  if (m->mode == MODE_BURST) {
+    if (b->now_us - m->addr_us < PMW_T_SRAD_MOTBR) violation("burst read before t_SRAD_MOTBR", i);
+    int16_t dx = take_s16(&m->dx), dy = take_s16(&m->dy);
+    b->data[0] = (uint8_t)((dx || dy ? PMW_MOTION_MOT : 0) | (m->lifted ? PMW_MOTION_LIFT : 0));
+    b->data[2] = (uint8_t)(uint16_t)dx;
+    b->data[3] = (uint8_t)((uint16_t)dx >> 8);
+    b->data[4] = (uint8_t)(uint16_t)dy;
+    b->data[5] = (uint8_t)((uint16_t)dy >> 8);
+    b->data[6] = 0x40;   /* SQUAL */
+  } else if (m->mode == MODE_REG) {
+    b->data[0] = reg_read(m, i, m->addr);
+  } else {
+    violation("read without an address", i);
+  }
+  if (m->stuck)
+    memset(b->data, 0xFF, sizeof(b->data));
+  else if (!m->answers)
+    memset(b->data, 0x00, sizeof(b->data));
+  /* The data lands when the transfer completes; until then buf holds garbage */
+  memset(buf, 0x5A, n);
+  b->dst = buf;
+  b->n = n;
+  b->busy_polls = b->busy_max ? rand() % (b->busy_max + 1) : 0;
+  m->mode = MODE_NONE;
+}
+
+static bool mock_busy(void *ctx) {
+  mock_bus_t *b = ctx;
+  if (!b->dst) return false;
+  if (b->busy_polls > 0) {
+    b->busy_polls--;
+    return true;
+  }
+  memcpy(b->dst, b->data, b->n);
+  b->dst = NULL;
+  return false;
+}
+
+static void mock_delay(void *ctx, uint32_t us) {
+  ((mock_bus_t *)ctx)->now_us += us;
+}
+
+static const pmw_bus_t g_bus = { mock_select, mock_write, mock_read, mock_busy, mock_delay, &g_mock };
+
+static void mock_reset(void) {
+  memset(&g_mock, 0, sizeof(g_mock));
+  g_mock.now_us = 1000;
+  for (int i = 0; i < SENSORS; i++)
+    g_mock.s[i].regs[PMW_REG_PRODUCT_ID] = PMW_PRODUCT_ID;
+}
+
+static void check_burst_parse(void) {
+  pmw_motion_t m;
+  uint8_t b[PMW_BURST_LEN] = { PMW_MOTION_MOT, 0, 0x34, 0x12, 0xFE, 0xFF, 0x21 };
+  CHECK(pmw_burst_parse(b, &m));
+  CHECK_EQ(m.dx, 0x1234);
+  CHECK_EQ(m.dy, -2);
+  CHECK_EQ(m.squal, 0x21);
+  CHECK(!m.lifted);
+  b[0] = PMW_MOTION_LIFT;   /* no MOT: the deltas are stale */
+  CHECK(pmw_burst_parse(b, &m));
+  CHECK_EQ(m.dx, 0);
+  CHECK_EQ(m.dy, 0);
+  CHECK(m.lifted);
+  memset(b, 0xFF, sizeof(b));   /* MISO stuck high */
+  CHECK(!pmw_burst_parse(b, &m));
+}
+
+/* Sensors on CS 0, 1 and 3; 2 is empty (MISO reads 0), 4 has MISO stuck high, 5 is empty. */
+static void check_power_up(void) {
+  mock_reset();
+  g_mock.s[0].answers = g_mock.s[1].answers = g_mock.s[3].answers = true;
+  g_mock.s[4].stuck = true;
+  pmw_t p;
+  uint8_t found = pmw_init(&p, &g_bus, SENSORS, 1600);
+  CHECK_EQ(found, 0x0B);
+  for (int i = 0; i < SENSORS; i++) {
+    bool on = found & (1u << i);
+    CHECK_EQ(g_mock.s[i].regs[PMW_REG_POWER_UP_RESET], 0x5A);
+    if (!on) continue;
+    CHECK_EQ(g_mock.s[i].regs[PMW_REG_CONFIG1], 1600 / 100 - 1);
+    CHECK(g_mock.s[i].burst_mode);
+    CHECK_EQ(g_mock.s[i].srom_n, 0);   /* no SROM image linked in */
+  }
+  /* CPI is clamped to the sensor's range */
+  mock_reset();
+  g_mock.s[0].answers = true;
+  pmw_init(&p, &g_bus, 1, 20000);
+  CHECK_EQ(g_mock.s[0].regs[PMW_REG_CONFIG1], PMW_CPI_MAX / 100 - 1);
+  CHECK_EQ(g_mock.violations, 0);
+}
+
+static void check_srom(void) {
+  for (int k = 0; k < SROM_LEN; k++)
+    g_srom_img[k] = (uint8_t)(k * 37 + 11);
+  g_srom_on = true;
+  mock_reset();
+  g_mock.s[0].answers = g_mock.s[1].answers = g_mock.s[2].answers = true;
+  g_mock.s[1].srom_bad = true;   /* answers, but the download doesn't take */
+  pmw_t p;
+  uint8_t found = pmw_init(&p, &g_bus, 3, 800);
+  CHECK_EQ(found, 0x05);
+  CHECK_EQ(g_mock.s[0].srom_n, SROM_LEN);
+  CHECK(memcmp(g_mock.s[0].srom, g_srom_img, SROM_LEN) == 0);
+  CHECK_EQ(g_mock.s[2].srom_n, SROM_LEN);
+  CHECK_EQ(g_mock.s[0].regs[PMW_REG_CONFIG1], 800 / 100 - 1);
+  CHECK(g_mock.s[0].burst_mode);
+  CHECK_EQ(g_mock.violations, 0);
+  g_srom_on = false;
+}
+
+/* Random motion on every sensor, polled at random intervals with random DMA latency:
+ * every count comes through, from the sensor it was made on. */
+static void check_round_robin(void) {
+  mock_reset();
+  for (int i = 0; i < SENSORS; i++)
+    g_mock.s[i].answers = i != 2;
+  pmw_t p;
+  uint8_t found = pmw_init(&p, &g_bus, SENSORS, 1600);
+  CHECK_EQ(found, 0x3B);
+  g_mock.busy_max = 4;
+  srand(1);
+
+  int64_t want[SENSORS][2] = { { 0 } }, got[SENSORS][2] = { { 0 } };
+  uint32_t moved_bits = 0;
+  for (int step = 0; step < 200000; step++) {
+    if (step % 7 == 0) {
+      for (int i = 0; i < SENSORS; i++) {
+        if (!(found & (1u << i))) continue;
+        int dx = rand() % 401 - 200, dy = rand() % 401 - 200;
+        g_mock.s[i].dx += dx;
+        g_mock.s[i].dy += dy;
+        want[i][0] += dx;
+        want[i][1] += dy;
+        g_mock.s[i].lifted = rand() % 50 == 0;
+      }
+    }
+    g_mock.now_us += (uint32_t)(rand() % 60);
+    moved_bits |= pmw_poll(&p, g_mock.now_us);
+    for (int i = 0; i < SENSORS; i++) {
+      got[i][0] += p.acc[i][0];
+      got[i][1] += p.acc[i][1];
+      p.acc[i][0] = p.acc[i][1] = 0;
+    }
+  }
+  /* Drain: no new motion, poll until each sensor has been read once more */
+  for (int step = 0; step < 1000; step++) {
+    g_mock.now_us += 50;
+    pmw_poll(&p, g_mock.now_us);
+    for (int i = 0; i < SENSORS; i++) {
+      got[i][0] += p.acc[i][0];
+      got[i][1] += p.acc[i][1];
+      p.acc[i][0] = p.acc[i][1] = 0;
+    }
+  }
+  for (int i = 0; i < SENSORS; i++) {
+    CHECK_EQ(got[i][0], want[i][0]);
+    CHECK_EQ(got[i][1], want[i][1]);
+  }
+  CHECK_EQ(moved_bits, found);
+  CHECK(p.bursts > 10000);
+  CHECK_EQ(p.bad, 0);
+  CHECK_EQ(g_mock.violations, 0);
+  printf("%u bursts over %u us of mock time\n", p.bursts, g_mock.now_us);
+
+  /* A sensor whose MISO sticks high after power-up: its bursts are dropped as bad,
+   * the others keep counting */
+  g_mock.s[1].stuck = true;
+  g_mock.s[0].dx += 5;
+  uint32_t bad = p.bad;
+  for (int step = 0; step < 1000; step++) {
+    g_mock.now_us += 50;
+    pmw_poll(&p, g_mock.now_us);
+  }
+  CHECK(p.bad > bad);
+  CHECK_EQ(p.acc[1][0], 0);
+  CHECK_EQ(p.acc[0][0], 5);
+  CHECK_EQ(g_mock.violations, 0);
+}
+
+/* One sensor: each burst goes straight back to the same chip select (t_BEXIT). */
+static void check_single(void) {
+  mock_reset();
+  g_mock.s[0].answers = true;
+  pmw_t p;
+  CHECK_EQ(pmw_init(&p, &g_bus, 1, 1600), 0x01);
+  g_mock.busy_max = 2;
+  int64_t want = 0, got = 0;
+  for (int step = 0; step < 20000; step++) {
+    int dx = rand() % 201 - 100;
+    g_mock.s[0].dx += dx;
+    want += dx;
+    g_mock.now_us += (uint32_t)(rand() % 40);
+    pmw_poll(&p, g_mock.now_us);
+    got += p.acc[0][0];
+    p.acc[0][0] = 0;
+  }
+  for (int step = 0; step < 10; step++) {
+    g_mock.now_us += 50;
+    pmw_poll(&p, g_mock.now_us);
+    got += p.acc[0][0];
+    p.acc[0][0] = 0;
+  }
+  CHECK_EQ(got, want);
+  CHECK_EQ(g_mock.violations, 0);
+}
+
+int main(void) {
+  check_burst_parse();
+  check_power_up();
+  check_srom();
+  check_round_robin();
+  check_single();
+  return check_done("test_pmw3360");
+}
@@ -0,0 +1,158 @@
+/**
+ * quad: the packed decoder against a per-pin reference on every transition of one
+ * axis, with the other axes held or moving; the per-axis counts saturating at the
+ * int16 limits instead of wrapping during a long stall; the majority vote; and the
+ * timer sampler's adaptive rate against a ball speeding up, reversing and stopping.
+ */
+#include "quad.h"
+#include "check.h"
+#include <math.h>
+#include <stdlib.h>
+
+/* Gray-code position of an A/B pair (A = bit 0, B = bit 1): 00, 01, 11, 10 */
+static int phase(uint32_t ab) {
+  static const int p[4] = { 0, 1, 3, 2 };
+  return p[ab & 3u];
+}
+
+static void check_transitions(void) {
+  for (int axis = 0; axis < QUAD_MICE * 2; axis++) {
+    for (uint32_t from = 0; from < 4; from++) {
+      for (uint32_t to = 0; to < 4; to++) {
+        quad_state_t q;
+        uint32_t base = 0x00A5C3u & QUAD_MASK & ~(3u << (axis * 2));   /* other pins, held */
+        quad_reset(&q, base | from << (axis * 2));
+        uint32_t r = quad_step(&q, base | to << (axis * 2));
+        int step = (phase(to) - phase(from) + 4) % 4;   /* 1 forward, 3 back, 2 lost */
+        int want = step == 1 ? 1 : step == 3 ? -1 : 0;
+        CHECK_EQ(q.acc[axis >> 1][axis & 1], want);
+        CHECK_EQ((r & QUAD_STEP_ILLEGAL) != 0, step == 2);
+        CHECK_EQ(q.illegal[axis >> 1][axis & 1], step == 2);
+        CHECK_EQ(r & QUAD_MOVED_MASK, want ? 1u << (axis >> 1) : 0u);
+        for (int other = 0; other < QUAD_MICE * 2; other++)
+          if (other != axis) CHECK_EQ(q.acc[other >> 1][other & 1], 0);
+      }
+    }
+  }
+}
+
+/* All axes at once: mouse i's X runs forward and Y back, at different speeds */
+static void check_all_axes(void) {
+  static const uint32_t gray[4] = { 0, 1, 3, 2 };
+  quad_state_t q;
+  quad_reset(&q, 0);
+  int32_t want[QUAD_MICE][2] = { { 0 } };
+  int pos[QUAD_MICE * 2] = { 0 };
+  for (int t = 1; t <= 10000; t++) {
+    uint32_t s = 0;
+    for (int axis = 0; axis < QUAD_MICE * 2; axis++) {
+      int every = 1 + axis % 5;
+      if (t % every == 0) {
+        pos[axis] += (axis & 1) ? -1 : 1;
+        want[axis >> 1][axis & 1] += (axis & 1) ? -1 : 1;
+      }
+      s |= gray[pos[axis] & 3] << (axis * 2);
+    }
+    quad_step(&q, s);
+  }
+  for (int i = 0; i < QUAD_MICE; i++) {
+    CHECK_EQ(q.acc[i][0], want[i][0]);
+    CHECK_EQ(q.acc[i][1], want[i][1]);
+    CHECK_EQ(q.illegal[i][0] + q.illegal[i][1], 0);
+  }
+}
+
+/* 40000 steps forward on X and back on Y without anyone taking the counts: they stop
+ * at the int16 limits (a stalled main loop slows the pointer, it doesn't reverse it),
+ * and count back from there. */
+static void check_saturation(void) {
+  static const uint32_t gray[4] = { 0, 1, 3, 2 };
+  quad_state_t q;
+  quad_reset(&q, 0);
+  int px = 0, py = 0;
+  for (int t = 0; t < 40000; t++) {
+    px++;
+    py--;
+    quad_step(&q, gray[px & 3] | gray[py & 3] << 2);
+  }
+  CHECK_EQ(q.acc[0][0], INT16_MAX);
+  CHECK_EQ(q.acc[0][1], INT16_MIN);
+  px--;
+  py++;
+  quad_step(&q, gray[px & 3] | gray[py & 3] << 2);
+  CHECK_EQ(q.acc[0][0], INT16_MAX - 1);
+  CHECK_EQ(q.acc[0][1], INT16_MIN + 1);
+}
+
+static void check_vote(void) {
+  srand(7);
+  for (int k = 0; k < 10000; k++) {
+    uint32_t s[5];
+    for (int i = 0; i < 5; i++)
+      s[i] = ((uint32_t)rand() ^ (uint32_t)rand() << 12) & QUAD_MASK;
+    uint32_t v3 = quad_vote(s, 3), v5 = quad_vote(s, 5);
+    CHECK_EQ(quad_vote(s, 1), s[0]);
+    for (int b = 0; b < QUAD_BITS; b++) {
+      int n3 = 0, n5 = 0;
+      for (int i = 0; i < 5; i++) {
+        int bit = (s[i] >> b) & 1;
+        if (i < 3) n3 += bit;
+        n5 += bit;
+      }
+      CHECK_EQ((v3 >> b) & 1, n3 >= 2);
+      CHECK_EQ((v5 >> b) & 1, n5 >= 3);
+    }
+  }
+}
+
+/* The timer sampler's adaptive rate on one ball that speeds up, cruises, reverses,
+ * cruises back and stops (vmax edges/s at the peaks), sampled with a 20 kHz ceiling
+ * at the periods quad_rate_step() picks. No step may be dropped or miscounted, and
+ * the average rate must come out under the ceiling, far under it for a slow ball. */
+static void check_rate(double vmax) {
+  static const uint32_t gray[4] = { 0, 1, 3, 2 };
+  quad_state_t q;
+  quad_rate_t rate;
+  quad_reset(&q, 0);
+  quad_rate_init(&rate, 20000);
+  double pos = 0.0;
+  long long samples = 0, illegal = 0;
+  uint32_t next = 0;
+  for (uint32_t us = 0; us < 1500000; us++) {
+    double ms = us / 1000.0, v;
+    if (ms < 100)       v = 0;
+    else if (ms < 300)  v = vmax * (ms - 100) / 200;
+    else if (ms < 600)  v = vmax;
+    else if (ms < 800)  v = vmax * (700 - ms) / 100;
+    else if (ms < 1100) v = -vmax;
+    else if (ms < 1300) v = -vmax * (1300 - ms) / 200;
+    else                v = 0;
+    pos += v / 1e6;
+    if (us != next)
+      continue;
+    uint32_t s = gray[(int)floor(pos) & 3];
+    bool changed = s != q.prev;
+    uint32_t r = quad_step(&q, s);
+    if (r & QUAD_STEP_ILLEGAL) illegal++;
+    next = us + quad_rate_step(&rate, changed, (r & QUAD_STEP_ILLEGAL) != 0);
+    samples++;
+  }
+  printf("%6.0f edges/s: %lld samples in 1.5 s (%.1f kHz average), %lld illegal\n", vmax, samples,
+         (double)samples / 1500.0, illegal);
+  CHECK_EQ(illegal, 0);
+  CHECK_EQ(q.acc[0][0], (int16_t)floor(pos));
+  CHECK(samples < 30000);                    /* under the ceiling on average */
+  if (vmax <= 1000) CHECK(samples < 7500);   /* and far under it for a slow ball */
+}
+
+int main(void) {
+  check_transitions();
+  check_all_axes();
+  check_saturation();
+  check_vote();
+  check_rate(200);
+  check_rate(1000);
+  check_rate(4000);
+  check_rate(12000);
+  return check_done("test_quad");
+}
@@ -0,0 +1,124 @@
+/**
+ * settings seqlock: one writer publishes as fast as it can while readers take
+ * snapshots with settings_acquire(), and no snapshot may mix two updates.
+ *
+ * The writer alternates two setters that touch opposite ends of settings_t:
+ * settings_apply_uart() (the first fields) and settings_set_accel() (near the
+ * end). Each writes values derived from the version its snapshot will carry, so a
+ * reader can tell from one snapshot's version what every field must be: the odd
+ * version's uart fields and the even version's accel fields, whichever of the two
+ * it is. A torn copy shows up as fields from different versions.
+ */
+#include "settings.h"
+#include "check.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define PUBLISHES  2000000
+#define READERS    3
+
+static uint32_t g_base;   /* version before the writer started */
+static atomic_bool g_done;
+
+static uint8_t num_mice_for(uint32_t v)  { return (uint8_t)(SETTINGS_NUM_MICE_MIN + v % (SETTINGS_NUM_MICE_MAX - SETTINGS_NUM_MICE_MIN + 1)); }
+static uint8_t logic_for(uint32_t v)     { return (uint8_t)(v % (SETTINGS_LOGIC_FUSION + 1)); }
+static uint8_t input_for(uint32_t v)     { return (uint8_t)(v % (SETTINGS_INPUT_BOTH + 1)); }
+static uint8_t output_for(uint32_t v)    { return (uint8_t)(v % (SETTINGS_OUTPUT_RAW + 1)); }
+static uint8_t amplify_for(uint32_t v)   { return (uint8_t)(10 + v % 246); }
+static uint16_t quad_scale_for(uint32_t v) { return (uint16_t)(1 + v % 1000); }
+static uint8_t accel_mode_for(uint32_t v)   { return (uint8_t)(v % (SETTINGS_ACCEL_EXP + 1)); }
+static uint8_t accel_window_for(uint32_t v) { return (uint8_t)(SETTINGS_ACCEL_WINDOW_MIN + v % (SETTINGS_ACCEL_WINDOW_MAX - SETTINGS_ACCEL_WINDOW_MIN + 1)); }
+static uint8_t accel_thresh_for(uint32_t v) { return (uint8_t)(v >> 3); }
+static uint16_t accel_rate_for(uint32_t v)  { return (uint16_t)(v % 10001); }
+static uint16_t accel_max_for(uint32_t v)   { return (uint16_t)(100 + v % 901); }
+
+static void *writer(void *arg) {
+  (void)arg;
+  for (int k = 0; k < PUBLISHES; k++) {
+    uint32_t v = settings_version() + 1;   /* the version this update publishes as */
+    if (v & 1) {
+      settings_apply_uart(num_mice_for(v), logic_for(v), input_for(v), output_for(v),
+                          amplify_for(v), quad_scale_for(v));
+    } else {
+      settings_set_accel(accel_mode_for(v), accel_window_for(v), accel_thresh_for(v), accel_rate_for(v),
+                         accel_max_for(v));
+    }
+  }
+  atomic_store(&g_done, true);
+  return NULL;
+}
+
+typedef struct {
+  long long reads, checked, torn;
+} reader_stats_t;
+
+static bool consistent(const settings_t *s) {
+  uint32_t v = s->version;
+  uint32_t va = (v & 1) ? v : v - 1;   /* last apply_uart */
+  uint32_t vb = (v & 1) ? v - 1 : v;   /* last set_accel */
+  if (s->num_mice != num_mice_for(va) || s->logic_mode != logic_for(va) ||
+      s->input_mode != input_for(va) || s->output_mode != output_for(va) ||
+      s->amplify != (float)amplify_for(va) / 100.0f || s->quad_scale != quad_scale_for(va))
+    return false;
+  return s->accel_mode == accel_mode_for(vb) && s->accel_window_ms == accel_window_for(vb) &&
+         s->accel_threshold == accel_thresh_for(vb) && s->accel_rate == accel_rate_for(vb) &&
+         s->accel_max_x100 == accel_max_for(vb);
+}
+
+static void *reader(void *arg) {
+  reader_stats_t *st = arg;
+  settings_t s;
+  while (!atomic_load(&g_done)) {
+    settings_acquire(&s);
+    st->reads++;
+    if (s.version < g_base + 2)   /* both setters have run since the start */
+      continue;
+    st->checked++;
+    if (!consistent(&s)) {
+      if (st->torn++ < 5)
+        fprintf(stderr, "torn snapshot at version %u\n", s.version);
+    }
+  }
+  return NULL;
+}
+
+int main(void) {
+  settings_init();   /* host flash is blank: defaults */
+  g_base = settings_version();
+
+  /* Single-threaded first: an update is published whole, as the version it expects */
+  settings_t s;
+  uint32_t v = g_base + 1;
+  settings_apply_uart(num_mice_for(v), logic_for(v), input_for(v), output_for(v), amplify_for(v),
+                      quad_scale_for(v));
+  settings_acquire(&s);
+  CHECK_EQ(s.version, v);
+  CHECK_EQ(settings_version(), v);
+  CHECK_EQ(s.num_mice, num_mice_for(v));
+  CHECK_EQ(s.quad_scale, quad_scale_for(v));
+  g_base = settings_version();
+
+  pthread_t w, r[READERS];
+  reader_stats_t st[READERS];
+  memset(st, 0, sizeof(st));
+  for (int i = 0; i < READERS; i++)
+    pthread_create(&r[i], NULL, reader, &st[i]);
+  pthread_create(&w, NULL, writer, NULL);
+  pthread_join(w, NULL);
+  long long reads = 0, checked = 0, torn = 0;
+  for (int i = 0; i < READERS; i++) {
+    pthread_join(r[i], NULL);
+    reads += st[i].reads;
+    checked += st[i].checked;
+    torn += st[i].torn;
+  }
+  printf("%d publishes, %lld reads, %lld checked, %lld torn\n", PUBLISHES, reads, checked, torn);
+
+  settings_acquire(&s);
+  CHECK(consistent(&s));
+  CHECK(checked > 0);
+  CHECK_EQ(torn, 0);
+  return check_done("test_settings_seqlock");
+}
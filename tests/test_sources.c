@@ -0,0 +1,291 @@
+/**
+ * plan: mixed input sources. plan_build's per-source slot masks (slots 0-2 quadrature
+ * and 3-5 UART, overlaps, masks cut at num_mice), the sources each input mode runs and
+ * the UART kept on for cascade. Then both sources feed one frame's slots the way
+ * main.c's quadrature_poll and input_records do: the real decoder on six encoders,
+ * slot-addressed host records, each adding only into its own mask. Every slot must
+ * end with exactly what its sources sent, with nothing overwritten or crossed over.
+ */
+#include "plan.h"
+#include "quad.h"
+#include "host_rx.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MICE    6
+#define FRAMES  2000
+
+static void settings_for(settings_t *s, uint8_t input_mode, const uint8_t *slot_src, int num_mice) {
+  memset(s, 0, sizeof(*s));
+  s->num_mice = (uint8_t)num_mice;
+  s->input_mode = input_mode;
+  s->logic_mode = SETTINGS_LOGIC_SUM;
+  s->amplify = 1.0f;
+  s->quad_scale = 1;
+  memset(s->slot_src, SETTINGS_SRC_ALL, sizeof(s->slot_src));
+  if (slot_src)
+    memcpy(s->slot_src, slot_src, MICE);
+}
+
+static const uint8_t split[MICE] = {
+  SETTINGS_SRC_QUAD, SETTINGS_SRC_QUAD, SETTINGS_SRC_QUAD,
+  SETTINGS_SRC_HOST, SETTINGS_SRC_HOST, SETTINGS_SRC_HOST,
+};
+
+static void check_masks(void) {
+  settings_t s;
+  plan_t p;
+
+  settings_for(&s, SETTINGS_INPUT_BOTH, split, MICE);
+  plan_build(&p, &s);
+  CHECK_EQ(p.sources, SETTINGS_SRC_HOST | SETTINGS_SRC_QUAD);
+  CHECK_EQ(p.src_slots[PLAN_SRC_QUAD], 0x07);
+  CHECK_EQ(p.src_slots[PLAN_SRC_HOST], 0x38);
+  CHECK_EQ(p.src_slots[PLAN_SRC_SPI], 0);
+  CHECK_EQ(p.src_slots[PLAN_SRC_USB], 0);
+
+  /* A slot two sources may feed is in both masks */
+  uint8_t shared[MICE];
+  memcpy(shared, split, MICE);
+  shared[2] |= SETTINGS_SRC_HOST | SETTINGS_SRC_SPI;
+  settings_for(&s, SETTINGS_INPUT_BOTH, shared, MICE);
+  plan_build(&p, &s);
+  CHECK_EQ(p.src_slots[PLAN_SRC_QUAD], 0x07);
+  CHECK_EQ(p.src_slots[PLAN_SRC_HOST], 0x3C);
+  CHECK_EQ(p.src_slots[PLAN_SRC_SPI], 0x04);
+
+  /* Slots at or past num_mice are fed by nothing, whatever slot_src says */
+  settings_for(&s, SETTINGS_INPUT_BOTH, split, 4);
+  plan_build(&p, &s);
+  CHECK_EQ(p.src_slots[PLAN_SRC_QUAD], 0x07);
+  CHECK_EQ(p.src_slots[PLAN_SRC_HOST], 0x08);
+  settings_for(&s, SETTINGS_INPUT_UART, NULL, 3);
+  plan_build(&p, &s);
+  for (int k = 0; k < PLAN_SOURCES; k++)
+    CHECK_EQ(p.src_slots[k], 0x07);
+
+  /* Sources by input mode; the masks don't depend on it (USB device packets arrive
+   * in any mode) */
+  static const struct { uint8_t mode, sources; } modes[] = {
+    { SETTINGS_INPUT_UART,       SETTINGS_SRC_HOST },
+    { SETTINGS_INPUT_QUADRATURE, SETTINGS_SRC_QUAD },
+    { SETTINGS_INPUT_BOTH,       SETTINGS_SRC_HOST | SETTINGS_SRC_QUAD },
+    { SETTINGS_INPUT_SPI,        SETTINGS_SRC_SPI },
+    { SETTINGS_INPUT_USB,        SETTINGS_SRC_USB },
+  };
+  for (unsigned m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+    settings_for(&s, modes[m].mode, split, MICE);
+    plan_build(&p, &s);
+    CHECK_EQ(p.sources, modes[m].sources);
+    CHECK_EQ(p.src_slots[PLAN_SRC_HOST], 0x38);
+    /* Cascading keeps the UART up: it is the link to the next Pico */
+    s.cascade_mode = SETTINGS_CASCADE_SLOTS;
+    plan_build(&p, &s);
+    CHECK_EQ(p.sources, modes[m].sources | SETTINGS_SRC_HOST);
+  }
+}
+
+/* One frame's slot accumulators, as g_mice[i].dx/dy */
+typedef struct {
+  int32_t dx[MICE], dy[MICE];
+} slots_t;
+
+/* quadrature_poll: take whole counts (quad_scale) from mapped encoders into their
+ * slots, keep the remainder, drop counts of encoders whose slot is another source's */
+static void quad_drain(const plan_t *p, quad_state_t *q, slots_t *f) {
+  uint32_t slots = p->src_slots[PLAN_SRC_QUAD];
+  for (int i = 0; i < MICE; i++) {
+    if (!(slots & (1u << i))) {
+      q->acc[i][0] = q->acc[i][1] = 0;
+      continue;
+    }
+    for (int a = 0; a < 2; a++) {
+      int32_t d = fastdiv_s32(&p->quad_div, q->acc[i][a]);
+      q->acc[i][a] = (int16_t)(q->acc[i][a] - d * p->quad_scale);
+      if (a == 0) f->dx[i] += d; else f->dy[i] += d;
+    }
+  }
+}
+
+/* input_records: a host record adds into its slot only if the host source feeds it */
+static void host_feed(const plan_t *p, int slot, int16_t dx, int16_t dy, slots_t *f) {
+  uint8_t rec[HOST_RECORD_LEN] = { (uint8_t)slot, 0, (uint8_t)dx, (uint8_t)((uint16_t)dx >> 8),
+                                   (uint8_t)dy, (uint8_t)((uint16_t)dy >> 8) };
+  host_record_t r;
+  if (!host_record(rec, 0, p->src_slots[PLAN_SRC_HOST], &r))
+    return;
+  f->dx[r.slot] += r.dx;
+  f->dy[r.slot] += r.dy;
+}
+
+/* The same from the true encoder counts: whole units, truncated like fastdiv_s32 */
+static void owed_drain(int32_t owed[MICE][2], const uint8_t *slot_src, int16_t quad_scale, slots_t *want) {
+  for (int i = 0; i < MICE; i++) {
+    if (!(slot_src[i] & SETTINGS_SRC_QUAD)) continue;
+    for (int a = 0; a < 2; a++) {
+      int32_t whole = owed[i][a] / quad_scale;
+      owed[i][a] -= whole * quad_scale;
+      if (a == 0) want->dx[i] += whole; else want->dy[i] += whole;
+    }
+  }
+}
+
+/* Random motion on all six encoders and host records for every slot, several of each
+ * per frame in random order; per slot, the frame must hold the sum of what the
+ * sources mapped to it sent. */
+static void check_mixed(const uint8_t *slot_src, int16_t quad_scale) {
+  static const uint32_t gray[4] = { 0, 1, 3, 2 };
+  settings_t s;
+  plan_t p;
+  settings_for(&s, SETTINGS_INPUT_BOTH, slot_src, MICE);
+  s.quad_scale = quad_scale;
+  plan_build(&p, &s);
+
+  quad_state_t q;
+  quad_reset(&q, 0);
+  int pos[MICE * 2] = { 0 };
+  int32_t quad_owed[MICE][2] = { { 0 } };   /* true encoder counts not yet taken */
+  srand(47);
+  for (int frame = 0; frame < FRAMES; frame++) {
+    slots_t f, want;
+    memset(&f, 0, sizeof(f));
+    memset(&want, 0, sizeof(want));
+    int events = rand() % 40;
+    for (int e = 0; e < events; e++) {
+      if (rand() % 2) {
+        /* one encoder step on a random axis */
+        int axis = rand() % (MICE * 2), dir = rand() % 2 ? 1 : -1;
+        pos[axis] += dir;
+        uint32_t sample = 0;
+        for (int a = 0; a < MICE * 2; a++)
+          sample |= gray[pos[a] & 3] << (2 * a);
+        quad_step(&q, sample);
+        if (slot_src[axis >> 1] & SETTINGS_SRC_QUAD)
+          quad_owed[axis >> 1][axis & 1] += dir;
+      } else {
+        int slot = rand() % 8;   /* now and then past the last slot */
+        int16_t dx = (int16_t)(rand() % 201 - 100), dy = (int16_t)(rand() % 201 - 100);
+        host_feed(&p, slot, dx, dy, &f);
+        if (slot < MICE && (slot_src[slot] & SETTINGS_SRC_HOST)) {
+          want.dx[slot] += dx;
+          want.dy[slot] += dy;
+        }
+      }
+      if (rand() % 8 == 0 || e == events - 1) {
+        /* the main loop polls several times a frame, and once more before the report */
+        quad_drain(&p, &q, &f);
+        owed_drain(quad_owed, slot_src, quad_scale, &want);
+      }
+    }
+    for (int i = 0; i < MICE; i++) {
+      CHECK_EQ(f.dx[i], want.dx[i]);
+      CHECK_EQ(f.dy[i], want.dy[i]);
+    }
+  }
+}
+
+/* main.c's pins: quadrature mouse i on 2 + 4i .. 5 + 4i, SPI chip selects on 2..7
+ * and the bus on 16, 18, 19, the UART on 0, 1. The USB host isn't modelled. */
+#define PINS  30
+static int g_owner[PINS];          /* PLAN_SRC_* + 1 whose setup last took the pin; 0 = free */
+static int g_inits[PLAN_SOURCES];
+
+static int source_pins(int k, int num_mice, int *pins) {
+  int n = 0;
+  if (k == PLAN_SRC_HOST) {
+    pins[n++] = 0;
+    pins[n++] = 1;
+  } else if (k == PLAN_SRC_QUAD) {
+    for (int i = 0; i < num_mice && i < QUAD_MICE; i++)
+      for (int j = 0; j < 4; j++)
+        pins[n++] = 2 + 4 * i + j;
+  } else if (k == PLAN_SRC_SPI) {
+    for (int i = 0; i < 6; i++)
+      pins[n++] = 2 + i;
+    pins[n++] = 16;
+    pins[n++] = 18;
+    pins[n++] = 19;
+  }
+  return n;
+}
+
+/* One sources_apply: stop hooks (quadrature and SPI have one) free the pins, setups
+ * take them for the plan's num_mice; then every running source must own its pins. */
+static void apply(plan_sources_t *st, const plan_t *p) {
+  static int held[PLAN_SOURCES][PINS], nheld[PLAN_SOURCES];
+  uint8_t stop, start;
+  plan_sources_step(st, p, SETTINGS_SRC_QUAD, &stop, &start);
+  CHECK_EQ(stop & start & ~SETTINGS_SRC_QUAD, 0);   /* only a num_mice change restarts */
+  for (int k = 0; k < PLAN_SOURCES; k++)
+    if ((stop & (1u << k)) && (k == PLAN_SRC_QUAD || k == PLAN_SRC_SPI)) {
+      for (int j = 0; j < nheld[k]; j++)
+        if (g_owner[held[k][j]] == k + 1) g_owner[held[k][j]] = 0;
+      nheld[k] = 0;
+    }
+  for (int k = 0; k < PLAN_SOURCES; k++)
+    if (start & (1u << k)) {
+      nheld[k] = source_pins(k, p->num_mice, held[k]);
+      for (int j = 0; j < nheld[k]; j++)
+        g_owner[held[k][j]] = k + 1;
+      g_inits[k]++;
+    }
+  CHECK_EQ(st->up, p->sources);
+  for (int k = 0; k < PLAN_SOURCES; k++) {
+    if (!(p->sources & (1u << k))) continue;
+    int pins[PINS], n = source_pins(k, p->num_mice, pins);
+    for (int j = 0; j < n; j++)
+      CHECK_EQ(g_owner[pins[j]], k + 1);
+  }
+}
+
+static void check_restart(void) {
+  static const struct { uint8_t mode, cascade; int num_mice, quad, spi, host; } steps[] = {
+    /* mode                    cascade                 mice  quad/spi/uart setups so far */
+    { SETTINGS_INPUT_QUADRATURE, 0,                      6,  1, 0, 0 },
+    { SETTINGS_INPUT_SPI,        0,                      6,  1, 1, 0 },   /* SPI takes 2..7 */
+    { SETTINGS_INPUT_QUADRATURE, 0,                      6,  2, 1, 0 },   /* and gives them back */
+    { SETTINGS_INPUT_QUADRATURE, 0,                      6,  2, 1, 0 },   /* no change, no setup */
+    { SETTINGS_INPUT_QUADRATURE, 0,                      3,  3, 1, 0 },   /* num_mice: fewer pins */
+    { SETTINGS_INPUT_BOTH,       0,                      3,  3, 1, 1 },
+    { SETTINGS_INPUT_BOTH,       0,                      5,  4, 1, 1 },   /* more pins; UART stays */
+    { SETTINGS_INPUT_SPI,        SETTINGS_CASCADE_SLOTS, 5,  4, 2, 1 },   /* the UART stays up */
+    { SETTINGS_INPUT_SPI,        SETTINGS_CASCADE_SLOTS, 2,  4, 2, 1 },   /* SPI has every sensor up */
+    { SETTINGS_INPUT_BOTH,       0,                      6,  5, 2, 1 },
+    { SETTINGS_INPUT_UART,       0,                      6,  5, 2, 1 },
+    { SETTINGS_INPUT_SPI,        0,                      6,  5, 3, 1 },
+    { SETTINGS_INPUT_BOTH,       0,                      6,  6, 3, 2 },   /* UART left and came back */
+  };
+  plan_sources_t st = { 0, 0 };
+  settings_t s;
+  plan_t p;
+  for (unsigned k = 0; k < sizeof(steps) / sizeof(steps[0]); k++) {
+    settings_for(&s, steps[k].mode, NULL, steps[k].num_mice);
+    s.cascade_mode = steps[k].cascade;
+    plan_build(&p, &s);
+    apply(&st, &p);
+    CHECK_EQ(g_inits[PLAN_SRC_QUAD], steps[k].quad);
+    CHECK_EQ(g_inits[PLAN_SRC_SPI], steps[k].spi);
+    CHECK_EQ(g_inits[PLAN_SRC_HOST], steps[k].host);
+  }
+}
+
+int main(void) {
+  check_masks();
+  check_mixed(split, 1);
+  check_mixed(split, 4);
+  /* Both sources into every slot: they add, neither overwrites the other */
+  static const uint8_t both[MICE] = {
+    SETTINGS_SRC_ALL, SETTINGS_SRC_ALL, SETTINGS_SRC_ALL,
+    SETTINGS_SRC_ALL, SETTINGS_SRC_ALL, SETTINGS_SRC_ALL,
+  };
+  check_mixed(both, 1);
+  /* Interleaved, with one slot fed by nothing */
+  static const uint8_t mixed[MICE] = {
+    SETTINGS_SRC_HOST, SETTINGS_SRC_QUAD, 0,
+    SETTINGS_SRC_QUAD, SETTINGS_SRC_HOST | SETTINGS_SRC_QUAD, SETTINGS_SRC_HOST,
+  };
+  check_mixed(mixed, 2);
+  check_restart();
+  return check_done("test_sources");
+}